@@ -0,0 +1,164 @@
+#include "atlas.h"
+
+#include <algorithm>
+
+ShelfPacker::ShelfPacker(const uint32_t width, const uint32_t height) : width(width), height(height) {}
+
+std::optional<glm::uvec2> ShelfPacker::pack(const uint32_t w, const uint32_t h) {
+    if (w > width || h > height) return {};
+
+    // Best fit: the shelf wasting the least height
+    Shelf *best = nullptr;
+    for (auto &shelf : shelves) {
+        if (shelf.height < h || width - shelf.used_width < w) continue;
+
+        if (best == nullptr || shelf.height < best->height) best = &shelf;
+    }
+
+    if (best == nullptr) {
+        if (height - used_height < h) return {};
+
+        best = &shelves.emplace_back(Shelf { used_height, h, 0 });
+        used_height += h;
+    }
+
+    const glm::uvec2 pos { best->used_width, best->y };
+    best->used_width += w;
+
+    return pos;
+}
+
+float ShelfPacker::occupancy() const {
+    return static_cast<float>(used_height) / static_cast<float>(height);
+}
+
+SpriteAtlas::SpriteAtlas(const std::shared_ptr<TextureLease> &lease, const uint32_t page_size, const uint32_t padding, const uint32_t gutter)
+    : lease(lease), page_size(page_size), padding(padding), gutter(gutter) {}
+
+bool SpriteAtlas::try_get(const std::string &name, AtlasRegion *region) const {
+    const auto found = regions.find(name);
+    if (found == regions.end()) return false;
+
+    *region = found->second;
+
+    return true;
+}
+
+AtlasRegion SpriteAtlas::load_file(const libgui::VkImmediateCommandBuffer &cmd, const char *path, const std::string &name) {
+    if (AtlasRegion region; try_get(name, &region)) return region;
+
+    if (!std::filesystem::exists(path)) throw std::runtime_error("Given path doesn't exist: " + std::string(path));
+
+    int w, h, c;
+    const auto stbi_handle = stbi_load(path, &w, &h, &c, STBI_rgb_alpha);
+    if (stbi_handle == nullptr) throw std::runtime_error("Couldn't decode " + std::string(path) + ": " + stbi_failure_reason());
+
+    const AtlasRegion region = add_pixels(cmd, name, w, h, stbi_handle);
+    stbi_image_free(stbi_handle);
+
+    return region;
+}
+
+void SpriteAtlas::load_files(const libgui::VkImmediateCommandBuffer &cmd, const std::span<const std::pair<std::string, std::string>> paths_and_names) {
+    struct Decoded {
+        const std::string *name;
+        int w, h;
+        stbi_uc *pixels;
+    };
+
+    std::vector<Decoded> decoded;
+    for (const auto &[path, name] : paths_and_names) {
+        if (regions.contains(name)) continue;
+        if (!std::filesystem::exists(path)) throw std::runtime_error("Given path doesn't exist: " + path);
+
+        int w, h, c;
+        stbi_uc *pixels = stbi_load(path.c_str(), &w, &h, &c, STBI_rgb_alpha);
+        if (pixels == nullptr) {
+            for (const auto &done : decoded) stbi_image_free(done.pixels);
+            throw std::runtime_error("Couldn't decode " + path + ": " + stbi_failure_reason());
+        }
+
+        decoded.push_back({ &name, w, h, pixels });
+    }
+
+    std::ranges::stable_sort(decoded, std::greater {}, &Decoded::h);
+
+    for (const auto &[name, w, h, pixels] : decoded) {
+        add_pixels(cmd, *name, w, h, pixels);
+        stbi_image_free(pixels);
+    }
+}
+
+AtlasRegion SpriteAtlas::add_pixels(const libgui::VkImmediateCommandBuffer &cmd, const std::string &name, const uint32_t w, const uint32_t h, const uint8_t *rgba) {
+    if (AtlasRegion region; try_get(name, &region)) return region;
+
+    const AtlasRegion region = upload(cmd, w, h, rgba);
+    regions.emplace(name, region);
+
+    return region;
+}
+
+AtlasRegion SpriteAtlas::upload(const libgui::VkImmediateCommandBuffer &cmd, const uint32_t w, const uint32_t h, const uint8_t *rgba) {
+    const uint32_t packed_w = w + gutter * 2;
+    const uint32_t packed_h = h + gutter * 2;
+
+    if (packed_w + padding > page_size || packed_h + padding > page_size)
+        throw std::runtime_error("Sprite too large for atlas page: " + std::to_string(w) + "x" + std::to_string(h));
+
+    // Find a page with space, open a new one otherwise
+    std::optional<glm::uvec2> pos;
+    Page *page = nullptr;
+    for (auto &p : pages) {
+        pos = p.packer.pack(packed_w + padding, packed_h + padding);
+        if (pos.has_value()) {
+            page = &p;
+            break;
+        }
+    }
+
+    if (page == nullptr) {
+        page = &pages.emplace_back(Page {
+            lease->create_empty(cmd, page_size, page_size, nullptr),
+            ShelfPacker(page_size, page_size),
+        });
+
+        pos = page->packer.pack(packed_w + padding, packed_h + padding);
+        wlog::logf(wlog::WLOG_INFO, "Opened atlas page %d", static_cast<int>(pages.size()));
+    }
+
+    // Extrude the sprite's edges into the gutter
+    std::vector<uint8_t> packed(packed_w * packed_h * 4);
+    for (uint32_t y = 0; y < packed_h; y++) {
+        const uint32_t src_y = std::clamp<int64_t>(static_cast<int64_t>(y) - gutter, 0, h - 1);
+
+        for (uint32_t x = 0; x < packed_w; x++) {
+            const uint32_t src_x = std::clamp<int64_t>(static_cast<int64_t>(x) - gutter, 0, w - 1);
+            memcpy(&packed[(y * packed_w + x) * 4], &rgba[(src_y * w + src_x) * 4], 4);
+        }
+    }
+
+    libgui::VkSizedBuffer staging {};
+    libgui::cmd_immediate(cmd, [&] {
+        const VkImage image = page->texture->image.image;
+
+        libgui::change_image_layout(cmd.cmd, image, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        libgui::data_to_image(cmd.cmd, staging, lease->VMA, packed.data(), packed.size(), 0, image, packed_w, packed_h, pos->x, pos->y);
+        libgui::change_image_layout(cmd.cmd, image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    });
+    staging.dispose();
+
+    const float texel = 1.0f / static_cast<float>(page_size);
+    const glm::vec2 inner = glm::vec2(*pos + gutter);
+
+    return AtlasRegion {
+        .texture = page->texture->index,
+        .uv_min = inner * texel,
+        .uv_max = (inner + glm::vec2(w, h)) * texel,
+        .size = glm::vec2(w, h),
+    };
+}
+
+void SpriteAtlas::dispose() {
+    regions.clear();
+    pages.clear();
+}
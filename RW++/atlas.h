@@ -0,0 +1,72 @@
+#pragma once
+
+#include "textures.h"
+
+#include <glm/vec2.hpp>
+
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Shelf packer for a single atlas page.
+// Rects are placed left to right on horizontal shelves, a new shelf is opened below the last one when none fit
+class ShelfPacker {
+    struct Shelf {
+        uint32_t y;
+        uint32_t height;
+        uint32_t used_width;
+    };
+
+    uint32_t width;
+    uint32_t height;
+    uint32_t used_height = 0;
+
+    std::vector<Shelf> shelves;
+
+public:
+    ShelfPacker(uint32_t width, uint32_t height);
+
+    // Top left of the packed rect, nothing if the page is full
+    std::optional<glm::uvec2> pack(uint32_t w, uint32_t h);
+
+    // Fraction of the page covered by shelves
+    float occupancy() const;
+};
+
+// Packs small sprites into large textures so one bindless slot and one image view serve all of them
+class SpriteAtlas {
+    struct Page {
+        TexturePtr texture;
+        ShelfPacker packer;
+    };
+
+    std::shared_ptr<TextureLease> lease;
+    std::vector<Page> pages;
+    std::unordered_map<std::string, AtlasRegion> regions;
+
+    uint32_t page_size;
+    uint32_t padding; // Empty pixels between sprites
+    uint32_t gutter;  // Edge pixels repeated around sprites, keeps filtering and lower mips from bleeding
+
+    AtlasRegion upload(const libgui::VkImmediateCommandBuffer &cmd, uint32_t w, uint32_t h, const uint8_t *rgba);
+
+public:
+    explicit SpriteAtlas(const std::shared_ptr<TextureLease> &lease, uint32_t page_size = 1024, uint32_t padding = 1, uint32_t gutter = 0);
+
+    bool try_get(const std::string &name, AtlasRegion *region) const;
+
+    // Packs an image file at runtime
+    AtlasRegion load_file(const libgui::VkImmediateCommandBuffer &cmd, const char *path, const std::string &name);
+
+    // Packs a batch of image files, tallest first, which wastes less shelf space than packing them as they come
+    void load_files(const libgui::VkImmediateCommandBuffer &cmd, std::span<const std::pair<std::string, std::string>> paths_and_names);
+
+    // Packs raw RGBA8 pixels
+    AtlasRegion add_pixels(const libgui::VkImmediateCommandBuffer &cmd, const std::string &name, uint32_t w, uint32_t h, const uint8_t *rgba);
+
+    size_t page_count() const { return pages.size(); }
+
+    void dispose();
+};
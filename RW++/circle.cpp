@@ -4,31 +4,14 @@ class SceneCircle final : public SceneObject_T {
     std::shared_ptr<Scene> scene;
     glm::vec2 position;
 
-    TexturePtr circle_image;
-    VkDescriptorSetLayout texture_layout;
-    VkDescriptorSet texture_set;
+    AtlasRegion circle_region;
     LeasedPipeline pipeline;
 
 public:
     explicit SceneCircle(const std::shared_ptr<Scene> &scene, const glm::vec2 pos) : scene(scene) {
         position = pos;
-        if (!this->scene->TextureLeaser.try_get("circle32", &circle_image))
-            circle_image = this->scene->TextureLeaser.load_file(this->scene->ImmediateCmd, "assets/circle.png", "circle32");
+        circle_region = this->scene->Atlas.load_file(this->scene->ImmediateCmd, "assets/circle.png", "circle32");
 
-        texture_layout = {};
-        VK_ASSERT( libgui::descriptor_set_layout(
-            scene->GPU,
-            {
-                VkDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr),
-            },
-
-            &texture_layout
-        ) );
-
-        texture_set = scene->DescriptorLeaser.allocate(scene->TextureLeaser.GPU, texture_layout);
-        libgui::DescriptorLayoutHelper()
-            .image(0, circle_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
-            .update_set(scene->GPU, texture_set);
 
         // basic sprite pipeline
         VkShaderModule basic_vert;
@@ -40,7 +23,7 @@ public:
         pipeline = scene->PipelineLeaser.ensure_pipeline(
             scene->GPU,
             scene->DrawImage.format,
-            { scene->UniversalSetLayout, texture_layout },
+            { scene->UniversalSetLayout, scene->TextureLeaser->BindlessLayout },
             { "shaders/basic_sprite.vert.spv", "shaders/basic_sprite.frag.spv" },
             { {basic_vert, VK_SHADER_STAGE_VERTEX_BIT}, {basic_frag, VK_SHADER_STAGE_FRAGMENT_BIT} }
         );
@@ -58,6 +41,7 @@ public:
     }
 
     void poll_draw() override {
-        pipeline->poller.make_sprite(position, glm::vec2(32), -5, 1, scene->UniversalSet, texture_set);
+        pipeline->poller.make_sprite(position, -5, 1, scene->UniversalSet, scene->TextureLeaser->BindlessSet, circle_region);
+        scene->ShadowPoller.make_sprite(position, -5, 1, scene->UniversalSet, scene->TextureLeaser->BindlessSet, circle_region);
     }
 };
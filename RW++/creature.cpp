@@ -0,0 +1,80 @@
+#include "rendering.h"
+#include "custom/bodychunk.h"
+#include "custom/demo.h"
+#include "custom/geometry.h"
+
+#include <vector>
+
+// A worm of body chunks held together by the scene's constraint solver, the head is the heaviest
+class Creature final : public SceneObject_T {
+    std::shared_ptr<Scene> scene;
+
+    AtlasRegion circle_region;
+    LeasedPipeline pipeline;
+
+    std::vector<size_t> body; // Chunks in the scene's physics world, head first
+    std::vector<float> radii; // Theirs, poll_draw can't read the physics world
+
+    int iterations; // The solver's, set between ticks
+
+public:
+    explicit Creature(const std::shared_ptr<Scene> &scene, const glm::vec2 pos, const glm::vec2 g, RoomGeometry &room)
+        : scene(scene), body(demo::addWorm(scene->Physics, pos, g, room)) {
+        for (const size_t chunk: body) radii.push_back(scene->Physics.getChunk(chunk).getRadius());
+        iterations = scene->Physics.getConstraints().getIterations();
+
+        circle_region = this->scene->Atlas.load_file(this->scene->ImmediateCmd, "assets/circle.png", "circle32");
+
+        // basic sprite pipeline
+        VkShaderModule basic_vert;
+        VkShaderModule basic_frag;
+
+        libgui::vulkan_create_shader_from_file(scene->GPU, &basic_vert, "shaders/basic_sprite.vert.spv");
+        libgui::vulkan_create_shader_from_file(scene->GPU, &basic_frag, "shaders/basic_sprite.frag.spv");
+
+        pipeline = scene->PipelineLeaser.ensure_pipeline(
+            scene->GPU,
+            scene->DrawImage.format,
+            { scene->UniversalSetLayout, scene->TextureLeaser->BindlessLayout },
+            { "shaders/basic_sprite.vert.spv", "shaders/basic_sprite.frag.spv" },
+            { {basic_vert, VK_SHADER_STAGE_VERTEX_BIT}, {basic_frag, VK_SHADER_STAGE_FRAGMENT_BIT} }
+        );
+
+        vkDestroyShaderModule(scene->GPU, basic_vert, nullptr);
+        vkDestroyShaderModule(scene->GPU, basic_frag, nullptr);
+    }
+
+    // Stepped by the scene's physics world, hops with the tick's input
+    void physics_tick(Scene *scene) override {
+        demo::applyWormInput(scene->Physics, body, scene->TickInput);
+    }
+
+    void frame_update(Scene *scene) override {
+        const SceneState &state = scene->States.front();
+
+        ImGui::Begin("Creature");
+
+        if (ImGui::Button("Hop")) scene->Input.press(InputHop);
+
+        if (ImGui::SliderInt("Solver iterations", &iterations, 1, 32)) {
+            scene->Input.edit(PhysicsEdit { .kind = PhysicsEdit::SolverIterations, .iterations = static_cast<uint32_t>(iterations) });
+        }
+
+        const ConstraintSolver::Stats &stats = state.constraint_stats;
+        ImGui::Text("Solve: %.3f ms, average %.3f ms", stats.last_ms, stats.average_ms);
+        ImGui::Text("%zu distance, %zu angle constraints in %zu colours", state.distance_constraints, state.angle_constraints, stats.colours);
+
+        ImGui::End();
+    }
+
+    void poll_draw() override {
+        // circle32 is 32 pixels across
+        for (size_t i = 0; i < body.size(); ++i) {
+            const glm::vec2 onScreenPos = scene->chunk_position(body[i]) + scene->Camera.offset;
+            const float scale = radii[i] / 16.0f;
+
+            pipeline->poller.make_sprite(onScreenPos, -5, scale, scene->UniversalSet, scene->TextureLeaser->BindlessSet, circle_region);
+            scene->ShadowPoller.make_sprite(onScreenPos, -5, scale, scene->UniversalSet, scene->TextureLeaser->BindlessSet, circle_region);
+        }
+    }
+};
@@ -2,17 +2,35 @@
 
 #include "geometry.h"
 #include <glm/glm.hpp>
+#include <algorithm>
 #include <cmath>
+#include <cstdio>
 #include "custom.h"
 
-class BodyChunk {
+// Features a body chunk variant is compiled with. Every creature type can pick its own set, the flags are constant expressions
+// so whatever a variant leaves out is dropped from its collision loops at compile time instead of being branched over at runtime
+struct DefaultChunkFeatures {
+    static constexpr bool DoUpdate = true;           // Moves by its velocity, without it only corrections from other chunks move it
+    static constexpr bool CollideWithTerrain = true;
+    static constexpr bool GoThroughFloors = false;   // Falls through the tops of tiles, walls and ceilings still stop it
+    static constexpr bool Substeps = true;           // Substeps and time of impact for fast chunks, see Move
+};
+
+// Same flags settable per chunk, what a single chunk type with runtime switches would do. Used as the baseline in bench_chunk_variants
+struct RuntimeChunkFeatures {
+    bool DoUpdate = true;
+    bool CollideWithTerrain = true;
+    bool GoThroughFloors = false;
+    bool Substeps = true;
+};
+
+template<typename Features>
+class BasicBodyChunk {
 public:
-    BodyChunk(glm::vec2 position, float Mass, float radius, float Friction, float Bounce, RoomGeometry& room)
-        : geo(&room) {
+    BasicBodyChunk(glm::vec2 position, float Mass, float radius, float Friction, float Bounce, RoomGeometry& room, Features chunk_features = {})
+        : geo(&room), features(chunk_features) {
         pos = lastPos = lastLastPos = position;
         mass = Mass;
-        //doUpdate = true;
-        //collideWithTerrain = true;
         rad = radius;
         rad_2 = rad*rad;
         friction = Friction;
@@ -22,28 +40,73 @@ public:
         printf("Created a bodychunk with radius = %f\n", rad);
     }
 
-    void draw_ui(const glm::vec2 screenOffset, const float image_height) {
+#ifdef IMGUI_VERSION
+    /**
+     * @brief Edits the settings of this chunk that copySettings takes, usually on a copy owned by the window's object
+     * @param screenPos where the frame shows the chunk being controlled
+     * @param velocity of the chunk being controlled
+     * @return whether a setting changed
+     */
+    bool draw_ui(const glm::vec2 screenPos, const glm::vec2 velocity, const float image_height) {
         // IMGUI CONTROLS
         ImGui::Begin("Collider Controls");
 
         // Draw line to the collider on-screen
         const auto dl = ImGui::GetBackgroundDrawList();
-        const auto pos2 = screenOffset + pos;
-        dl->AddLine(ImGui::GetWindowPos(), ImVec2(pos2.x, image_height - pos2.y), ImGui::GetColorU32(ImVec4(1, 1, 1, 1)), 2);
+        dl->AddLine(ImGui::GetWindowPos(), ImVec2(screenPos.x, image_height - screenPos.y), ImGui::GetColorU32(ImVec4(1, 1, 1, 1)), 2);
 
-        ImGui::DragFloat("Mass", &mass, 1, -2, 2);
-        ImGui::DragFloat("Radius", &rad, 1, -2, 2);
+        bool changed = false;
+        changed |= ImGui::DragFloat("Mass", &mass, 1, -2, 2);
+        changed |= ImGui::DragFloat("Radius", &rad, 1, -2, 2);
         rad_2 = rad*rad;
-        ImGui::DragFloat("Friction", &friction, 1, -2, 2);
-        ImGui::DragFloat("Bounce", &bounce, 1, -2, 2);
+        changed |= ImGui::DragFloat("Friction", &friction, 1, -2, 2);
+        changed |= ImGui::DragFloat("Bounce", &bounce, 1, -2, 2);
+        changed |= ImGui::Checkbox("Projectile", &projectile);
 
-        ImGui::Text("VEL: %f, %f", vel.x, vel.y);
+        ImGui::Text("VEL: %f, %f", velocity.x, velocity.y);
 
         ImGui::End();
+
+        return changed;
     }
+#endif
+
+    // Takes mass, radius, friction, bounce and projectile from another chunk, position and motion stay
+    void copySettings(const BasicBodyChunk &other) {
+        setSettings(other.mass, other.rad, other.friction, other.bounce, other.projectile);
+    }
+
+    // The settings copySettings takes, one by one, how a recorded PhysicsEdit applies them
+    void setSettings(const float new_mass, const float radius, const float new_friction, const float new_bounce, const bool new_projectile) {
+        mass = new_mass;
+        rad = radius;
+        rad_2 = radius * radius;
+        friction = new_friction;
+        bounce = new_bounce;
+        projectile = new_projectile;
+    }
+
+    static constexpr float TileSize = 20.0f;
+    static constexpr float SubstepFraction = 0.5f; // Of a tile or the radius, whichever is smaller, the most a chunk moves before colliding
+    static constexpr int MaxSubsteps = 16;
 
     //it might be more accurate to name velocity "dPos", but this works fine too
     void Update(glm::vec2 g) {
+        Integrate(g);
+        Move();
+    }
+
+    // First half of Update, gravity and friction. Only touches this chunk
+    void Integrate(glm::vec2 g) {
+        lastLastPos = lastPos;
+        lastPos = pos;
+
+        // Speed from other chunks doesn't carry over either
+        if (!features.DoUpdate) {
+            vel = glm::vec2{0, 0};
+            return;
+        }
+
         if(std::isinf(vel.x))
         {
             vel.x = 0;
@@ -55,13 +118,79 @@ public:
 
         vel += g;
         vel *= (1 - friction);
+    }
 
-        lastLastPos = lastPos;
-        lastPos = pos;
-        pos += vel;
+    /**
+     * @brief Second half of Update, moves by the velocity and collides with the terrain. Only reads the room geometry besides this chunk.
+     * A chunk moving further than getMaxStep() in a tick is moved in substeps of that length, colliding after each, so it can't pass
+     * through a tile. Projectiles and chunks needing more than MaxSubsteps skip ahead to just before the first tile they'd touch and
+     * substep from there, whatever of the tick is left after MaxSubsteps is lost to the impact
+     */
+    void Move() {
+        if (!features.DoUpdate) return;
 
-        CheckVerticalCollision();
-        CheckHorizontalCollision();
+        if (!features.CollideWithTerrain) {
+            pos += vel;
+            IsOnSolid = false;
+            return;
+        }
+
+        const float distance = glm::length(vel);
+        const float max_step = getMaxStep();
+
+        // Slow chunks, one step like always
+        if (!features.Substeps || distance <= max_step) {
+            pos += vel;
+            CollideWithTerrain();
+            return;
+        }
+
+        const glm::vec2 start = pos;
+        const float step = max_step / distance; // Of the tick, with the speed at its start
+        float left = 1.0f;
+
+        if (projectile || distance > max_step * MaxSubsteps) {
+            const float skip = std::max(0.0f, timeOfImpact() - step);
+            pos += vel * skip;
+            left -= skip;
+        }
+
+        bool landed = false;
+        for (int i = 0; i < MaxSubsteps && left > 0.0f; ++i) {
+            const float part = std::min(step, left);
+            lastPos = pos;
+            pos += vel * part;
+            CollideWithTerrain();
+            landed |= IsOnSolid;
+            left -= part;
+        }
+
+        // The whole tick for everyone looking at it from outside
+        lastPos = start;
+        IsOnSolid = landed;
+    }
+
+    // Furthest a chunk moves between two terrain collisions, chunks with no radius still take steps of a pixel's worth
+    float getMaxStep() const {
+        return std::max(std::min(TileSize, rad), 1.0f) * SubstepFraction;
+    }
+
+    // Projectiles always look ahead for the first tile they'd hit when they're fast, see Move
+    void setProjectile(const bool value) {
+        projectile = value;
+    }
+
+    bool isProjectile() const {
+        return projectile;
+    }
+
+    // Only settable for runtime features, the compiled in ones are constants
+    Features & getFeatures() {
+        return features;
+    }
+
+    const Features & getFeatures() const {
+        return features;
     }
 
     glm::vec2 getPosition() const {
@@ -70,17 +199,105 @@ public:
 
     void setPosition(const glm::vec2 new_pos) {
         pos = new_pos;
+        wake();
+    }
+
+    // Moves the chunk into another room's geometry, keeps its position and velocity
+    void setRoom(RoomGeometry& room) {
+        geo = &room;
+        wake();
+    }
+
+    glm::vec2 getVelocity() const {
+        return vel;
     }
 
     void setVelocity(const glm::vec2 Vel) {
         vel = Vel;
+        wake();
     }
 
     void addVelocity(const glm::vec2 addVel) {
         vel += addVel;
+        wake();
     }
 
-    inline bool isOnSolid(){
+    // Collision response from other chunks, unlike the setters above it doesn't wake the chunk or reset its rest
+    void applyCorrection(const glm::vec2 dPos, const glm::vec2 dVel) {
+        pos += dPos;
+        vel += dVel;
+    }
+
+    bool isAsleep() const {
+        return asleep;
+    }
+
+    // Whether the last tick counted towards falling asleep
+    bool isResting() const {
+        return restTicks > 0;
+    }
+
+    void wake() {
+        asleep = false;
+        restTicks = 0;
+    }
+
+    /**
+     * @brief Counts ticks spent on solid ground or another chunk moving less than maxSpeed, the chunk falls asleep after restLimit of them.
+     * Movement is measured over the whole tick, chunks lying on others keep some velocity that the collisions cancel out every tick.
+     * A sleeping chunk isn't updated until something wakes it
+     * @param supported whether the chunk lies on another chunk
+     * @return whether it fell asleep
+     */
+    bool updateRest(const float maxSpeed, const int restLimit, const bool supported) {
+        if (!(IsOnSolid || supported) || glm::length(pos - lastPos) >= maxSpeed) {
+            restTicks = 0;
+            return false;
+        }
+
+        if (++restTicks < restLimit) return false;
+
+        asleep = true;
+        vel = glm::vec2{0, 0};
+        lastPos = lastLastPos = pos;
+        sleepRevision = geo->getRevision();
+        return true;
+    }
+
+    // Whether a tile the sleeping chunk could touch changed since it fell asleep
+    bool terrainChanged() {
+        if (geo->getRevision() == sleepRevision) return false;
+
+        const glm::ivec2 min = custom::getTilePos(pos - glm::vec2(rad + 20.0f));
+        const glm::ivec2 max = custom::getTilePos(pos + glm::vec2(rad + 20.0f));
+        for (int y = min.y; y <= max.y; ++y) {
+            for (int x = min.x; x <= max.x; ++x) {
+                if (geo->getTileRevision(x, y) > sleepRevision) return true;
+            }
+        }
+
+        // Changes somewhere else, no need to look at them again
+        sleepRevision = geo->getRevision();
+        return false;
+    }
+
+    float getRadius() const {
+        return rad;
+    }
+
+    float getMass() const {
+        return mass;
+    }
+
+    float getBounce() const {
+        return bounce;
+    }
+
+    float getFriction() const {
+        return friction;
+    }
+
+    inline bool isOnSolid() const {
         return IsOnSolid;
     }
 
@@ -109,6 +326,85 @@ private:
     //bool grabsDisableFloors;
 
     bool IsOnSolid;
+    bool projectile = false;
+
+    [[no_unique_address]] Features features;
+
+    bool asleep = false;
+    int restTicks = 0;          // Ticks in a row spent resting, see updateRest
+    uint32_t sleepRevision = 0; // Room revision the chunk last checked its tiles at
+
+    void CollideWithTerrain() {
+        CheckVerticalCollision();
+        CheckHorizontalCollision();
+    }
+
+    /**
+     * @brief Conservative time of impact, the fraction of this tick's velocity the chunk moves before it first touches a solid tile
+     * it doesn't touch yet, 1 if none. Tiles are grown by the radius into boxes, so passing close by a corner counts as touching it.
+     * Walks the tiles around the path column by column (row by row when it's steeper), cost grows with the distance and not its square
+     */
+    float timeOfImpact() const {
+        const int major = std::abs(vel.x) >= std::abs(vel.y) ? 0 : 1;
+        const int minor = 1 - major;
+        const glm::vec2 end = pos + vel;
+
+        float hit = 1.0f;
+        const int first = static_cast<int>(std::floor((std::min(pos[major], end[major]) - rad) / TileSize));
+        const int last = static_cast<int>(std::floor((std::max(pos[major], end[major]) + rad) / TileSize));
+
+        for (int line = first; line <= last; ++line) {
+            // Part of the path within reach of this column, and the tiles across it that it passes
+            const float from = std::max(static_cast<float>(line) * TileSize - rad, std::min(pos[major], end[major]));
+            const float to = std::min(static_cast<float>(line + 1) * TileSize + rad, std::max(pos[major], end[major]));
+            const float at_from = pos[minor] + (from - pos[major]) / vel[major] * vel[minor];
+            const float at_to = pos[minor] + (to - pos[major]) / vel[major] * vel[minor];
+            const int across_first = static_cast<int>(std::floor((std::min(at_from, at_to) - rad) / TileSize));
+            const int across_last = static_cast<int>(std::floor((std::max(at_from, at_to) + rad) / TileSize));
+
+            for (int across = across_first; across <= across_last; ++across) {
+                glm::ivec2 tile;
+                tile[major] = line;
+                tile[minor] = across;
+                if (geo->getTileType(tile.x, tile.y) != 1) continue;
+
+                const glm::vec2 low = glm::vec2(tile) * TileSize - glm::vec2(rad);
+                const glm::vec2 high = glm::vec2(tile + 1) * TileSize + glm::vec2(rad);
+
+                // Slabs, touching the box counts as outside so chunks can slide along the tiles they lie on
+                float enter = 0.0f;
+                float exit = 1.0f;
+                int enter_axis = -1;
+                for (int axis = 0; axis < 2; ++axis) {
+                    if (vel[axis] == 0.0f) {
+                        if (pos[axis] <= low[axis] || pos[axis] >= high[axis]) exit = -1.0f;
+                        continue;
+                    }
+
+                    const float t_low = (low[axis] - pos[axis]) / vel[axis];
+                    const float t_high = (high[axis] - pos[axis]) / vel[axis];
+                    if (std::min(t_low, t_high) > enter) {
+                        enter = std::min(t_low, t_high);
+                        enter_axis = axis;
+                    }
+                    exit = std::min(exit, std::max(t_low, t_high));
+                }
+
+                // Coming down onto the top of the tile
+                if (features.GoThroughFloors && enter_axis == 1 && vel.y < 0.0f) continue;
+
+                // Boxes the chunk is already in only count when it's heading further in, sliding along or leaving is the normal collision's
+                const bool overlapping = pos.x > low.x && pos.x < high.x && pos.y > low.y && pos.y < high.y;
+                if (overlapping) {
+                    if (glm::dot(vel, (low + high) * 0.5f - pos) > 0.0f) hit = 0.0f;
+                } else if (enter < exit && enter < hit) {
+                    hit = enter;
+                }
+            }
+        }
+
+        return hit;
+    }
 
     void CheckHorizontalCollision() {
 
@@ -166,7 +462,7 @@ private:
             {
                 if(Cease) break;
 
-                for(int j = y2; j <= y; y++)
+                for(int j = y2; j <= y; j++)
                 {
                     if(Cease) break;
 
@@ -236,7 +532,7 @@ private:
                     }
                 }
             }
-        }else if (vel.y < 0.f)
+        }else if (vel.y < 0.f && !features.GoThroughFloors)
         {
             //printf("pos.x: %f, pos.y: %f, lastPos.y: %f rad: %f\n", pos.x, pos.y, lastPos.y, rad);
 
@@ -269,7 +565,7 @@ private:
                         }
                         vel.x *= glm::clamp(friction*2.f, 0.f, 1.f);
                         Cease = true;
-                        IsOnSolid = isOnSolid();
+                        IsOnSolid = true;
                     }
                     n++;
                     if (n > MaxRepeats)
@@ -288,3 +584,5 @@ private:
      *}
      */
 };
+
+typedef BasicBodyChunk<DefaultChunkFeatures> BodyChunk;
@@ -0,0 +1,95 @@
+#pragma once
+
+#include "descriptor.h"
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+// The camera views of a room in room pixels (y up, same space as BodyChunk) and which of them should show a position.
+// Switching has hysteresis so a target standing where two views overlap doesn't flip between them
+class RoomCameras {
+public:
+    static constexpr float ViewWidth = 1400.0f;
+    static constexpr float ViewHeight = 800.0f;
+
+    static constexpr float SwitchMargin = 40.0f; // Other views are only considered once the target is this close to the current view's edge
+    static constexpr float Hysteresis = 60.0f;   // and only a view that has it this much further from its own edges wins
+
+    RoomCameras() = default;
+
+    explicit RoomCameras(const RoomDescriptor &room) {
+        // The file measures cameras from the top of the room
+        for (const glm::ivec2 camera: room.cameras) {
+            origins.emplace_back(camera.x - 10.0f, room.y_size * 20.0f - ViewHeight - camera.y);
+        }
+    }
+
+    int getCount() const { return static_cast<int>(origins.size()); }
+
+    // Bottom left of the view in room pixels
+    glm::vec2 getOrigin(const int camera) const { return origins.at(camera); }
+
+    // Room pixels + offset = screen pixels (y up)
+    glm::vec2 getOffset(const int camera) const { return -origins.at(camera); }
+
+    // Distance from pos to the nearest edge of the view, negative when pos is outside of it
+    float edgeDistance(const int camera, const glm::vec2 pos) const {
+        const glm::vec2 min = origins.at(camera);
+        const glm::vec2 max = min + glm::vec2(ViewWidth, ViewHeight);
+        return std::min(std::min(pos.x - min.x, max.x - pos.x), std::min(pos.y - min.y, max.y - pos.y));
+    }
+
+    // The view that has pos furthest from its edges, or the closest one if none show it
+    int best(const glm::vec2 pos) const {
+        int best_camera = 0;
+        for (int i = 1; i < getCount(); ++i) {
+            if (edgeDistance(i, pos) > edgeDistance(best_camera, pos)) best_camera = i;
+        }
+        return best_camera;
+    }
+
+    /**
+     * @brief The view to show pos with, given the one shown now
+     * @return current unless pos is leaving it and another view clearly shows it better
+     */
+    int update(const int current, const glm::vec2 pos) const {
+        const float current_distance = edgeDistance(current, pos);
+        if (current_distance >= SwitchMargin) return current;
+
+        const int candidate = best(pos);
+        if (candidate == current) return current;
+
+        // Always leave a view that lost the target, otherwise only switch when it's clearly better
+        if (current_distance < 0 || edgeDistance(candidate, pos) >= current_distance + Hysteresis) return candidate;
+        return current;
+    }
+
+    /**
+     * @brief Views the target could need soon, ordered by how soon. The current view isn't included
+     * @param velocity room pixels per tick
+     * @param lookahead ticks to extrapolate the target's movement by
+     * @param radius how far outside a view the target may be for the view to count
+     */
+    std::vector<int> neighbours(const int current, const glm::vec2 pos, const glm::vec2 velocity, const float lookahead, const float radius) const {
+        const glm::vec2 predicted = pos + velocity * lookahead;
+
+        std::vector<std::pair<float, int>> near;
+        for (int i = 0; i < getCount(); ++i) {
+            if (i == current) continue;
+
+            const float distance = std::max(edgeDistance(i, pos), edgeDistance(i, predicted));
+            if (distance > -radius) near.emplace_back(-distance, i);
+        }
+
+        std::sort(near.begin(), near.end());
+
+        std::vector<int> cameras;
+        for (const auto &[distance, camera]: near) cameras.push_back(camera);
+        return cameras;
+    }
+
+private:
+    std::vector<glm::vec2> origins;
+};
@@ -0,0 +1,248 @@
+#pragma once
+
+#include "bodychunk.h"
+
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <stdexcept>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Connections between body chunks, what multi chunk creatures are made of.
+// Constraints are graph coloured so no two of a colour share a chunk, every colour is stored as arrays of fields (SoA) and
+// solved in batches that can run in parallel. Colours are solved one after another, the solve is bit identical for any runner.
+// Corrections move position and velocity together and are split by mass, the heavier end moves less
+class ConstraintSolver {
+public:
+    static constexpr size_t BatchSize = 64;
+
+    // Same contract as PhysicsWorld::BatchRunner
+    typedef std::function<void(size_t count, const std::function<void(size_t)> &batch)> BatchRunner;
+
+    // Timing of the last solve and a running average, in milliseconds
+    struct Stats {
+        float last_ms = 0;
+        float average_ms = 0;
+        size_t colours = 0;
+    };
+
+    /**
+     * @brief Keeps chunks a and b rest apart
+     * @param stiffness fraction of the error corrected per iteration, 0 to 1
+     * @return index of the constraint among the distance constraints
+     */
+    size_t addDistance(const uint32_t a, const uint32_t b, const float rest, const float stiffness = 1.0f) {
+        distances.push_back(Distance { a, b, rest, stiffness });
+        dirty = true;
+        return distances.size() - 1;
+    }
+
+    /**
+     * @brief Keeps the bend at chunk b between min and max radians. The bend is how far the direction from b to c turns
+     * counterclockwise away from the direction from a to b, 0 is straight, -pi to pi. a and c are rotated around b, b itself doesn't move
+     * @return index of the constraint among the angle constraints
+     */
+    size_t addAngle(const uint32_t a, const uint32_t b, const uint32_t c, const float min, const float max, const float stiffness = 1.0f) {
+        if (min > max) throw std::invalid_argument("Angle constraint with min > max.");
+
+        angles.push_back(Angle { a, b, c, min, max, stiffness });
+        dirty = true;
+        return angles.size() - 1;
+    }
+
+    size_t getDistanceCount() const { return distances.size(); }
+    size_t getAngleCount() const { return angles.size(); }
+
+    int getIterations() const { return iterations; }
+    void setIterations(const int count) { iterations = std::max(1, count); }
+
+    const Stats & getStats() const { return stats; }
+
+    /**
+     * @brief Wakes every chunk connected to one that's awake and moving, so connected chunks sleep and wake together
+     */
+    template<typename Chunk>
+    void wakeConnected(std::vector<Chunk> &chunks) const {
+        const auto moving = [&](const uint32_t i) { return !chunks[i].isAsleep() && !chunks[i].isResting(); };
+        const auto wake = [&](const uint32_t i) { if (chunks[i].isAsleep()) chunks[i].wake(); };
+
+        for (const Distance &d: distances) {
+            if (moving(d.a) || moving(d.b)) { wake(d.a); wake(d.b); }
+        }
+        for (const Angle &g: angles) {
+            if (moving(g.a) || moving(g.b) || moving(g.c)) { wake(g.a); wake(g.b); wake(g.c); }
+        }
+    }
+
+    // Relaxes every constraint getIterations() times, sleeping chunks don't move
+    template<typename Chunk>
+    void solve(std::vector<Chunk> &chunks, const BatchRunner &runner) {
+        const auto start = std::chrono::steady_clock::now();
+
+        if (dirty) colour(chunks.size());
+
+        for (int iteration = 0; iteration < iterations; ++iteration) {
+            for (Colour &c: colours) {
+                run(runner, c.distance.a.size(), [&](const size_t begin, const size_t end) { solveDistances(chunks, c.distance, begin, end); });
+                run(runner, c.angle.a.size(), [&](const size_t begin, const size_t end) { solveAngles(chunks, c.angle, begin, end); });
+            }
+        }
+
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        stats.last_ms = elapsed.count();
+        stats.average_ms = stats.average_ms * 0.95f + stats.last_ms * 0.05f;
+        stats.colours = colours.size();
+    }
+
+private:
+    struct Distance {
+        uint32_t a, b;
+        float rest;
+        float stiffness;
+    };
+
+    struct Angle {
+        uint32_t a, b, c;
+        float min, max;
+        float stiffness;
+    };
+
+    // One colour's constraints, field by field
+    struct DistanceBatch {
+        std::vector<uint32_t> a, b;
+        std::vector<float> rest, stiffness;
+    };
+
+    struct AngleBatch {
+        std::vector<uint32_t> a, b, c;
+        std::vector<float> min, max, stiffness;
+    };
+
+    struct Colour {
+        DistanceBatch distance;
+        AngleBatch angle;
+    };
+
+    std::vector<Distance> distances;
+    std::vector<Angle> angles;
+
+    std::vector<Colour> colours;
+    bool dirty = false;
+
+    int iterations = 4;
+    Stats stats;
+
+    static void run(const BatchRunner &runner, const size_t size, const std::function<void(size_t, size_t)> &fn) {
+        const size_t count = (size + BatchSize - 1) / BatchSize;
+        const auto batch = [&](const size_t i) { fn(i * BatchSize, std::min(size, (i + 1) * BatchSize)); };
+
+        if (runner) runner(count, batch);
+        else for (size_t i = 0; i < count; ++i) batch(i);
+    }
+
+    // Greedy colouring in constraint order, every constraint takes the first colour none of its chunks has yet
+    void colour(const size_t chunk_count) {
+        colours.clear();
+        std::vector<uint64_t> used(chunk_count, 0);
+
+        const auto pick = [&](std::initializer_list<uint32_t> members) {
+            uint64_t taken = 0;
+            for (const uint32_t m: members) {
+                if (m >= chunk_count) throw std::out_of_range("Constraint on a chunk that doesn't exist.");
+                taken |= used[m];
+            }
+            if (~taken == 0) throw std::runtime_error("Chunk is in too many constraints.");
+
+            const int first_free = std::countr_one(taken);
+            for (const uint32_t m: members) used[m] |= uint64_t(1) << first_free;
+            if (first_free >= static_cast<int>(colours.size())) colours.resize(first_free + 1);
+            return first_free;
+        };
+
+        for (const Distance &d: distances) {
+            DistanceBatch &batch = colours[pick({ d.a, d.b })].distance;
+            batch.a.push_back(d.a);
+            batch.b.push_back(d.b);
+            batch.rest.push_back(d.rest);
+            batch.stiffness.push_back(d.stiffness);
+        }
+
+        for (const Angle &g: angles) {
+            AngleBatch &batch = colours[pick({ g.a, g.b, g.c })].angle;
+            batch.a.push_back(g.a);
+            batch.b.push_back(g.b);
+            batch.c.push_back(g.c);
+            batch.min.push_back(g.min);
+            batch.max.push_back(g.max);
+            batch.stiffness.push_back(g.stiffness);
+        }
+
+        dirty = false;
+    }
+
+    // Share of a correction the chunk takes, by the other chunk's mass. Sleeping chunks are immovable
+    template<typename Chunk>
+    static float share(const Chunk &chunk, const Chunk &other) {
+        if (chunk.isAsleep()) return 0.0f;
+        if (other.isAsleep()) return 1.0f;
+
+        const float total = chunk.getMass() + other.getMass();
+        return total > 0.0f ? other.getMass() / total : 0.5f;
+    }
+
+    template<typename Chunk>
+    static void solveDistances(std::vector<Chunk> &chunks, const DistanceBatch &batch, const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Chunk &a = chunks[batch.a[i]];
+            Chunk &b = chunks[batch.b[i]];
+
+            const glm::vec2 delta = b.getPosition() - a.getPosition();
+            const float distance = glm::length(delta);
+            if (distance <= 0.0f) continue;
+
+            // Positive pulls the chunks together
+            const glm::vec2 error = delta * ((distance - batch.rest[i]) / distance * batch.stiffness[i]);
+
+            const glm::vec2 move_a = error * share(a, b);
+            const glm::vec2 move_b = -error * share(b, a);
+            a.applyCorrection(move_a, move_a);
+            b.applyCorrection(move_b, move_b);
+        }
+    }
+
+    static glm::vec2 rotate(const glm::vec2 v, const float angle) {
+        const float c = std::cos(angle);
+        const float s = std::sin(angle);
+        return glm::vec2(v.x * c - v.y * s, v.x * s + v.y * c);
+    }
+
+    template<typename Chunk>
+    static void solveAngles(std::vector<Chunk> &chunks, const AngleBatch &batch, const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Chunk &a = chunks[batch.a[i]];
+            const Chunk &b = chunks[batch.b[i]];
+            Chunk &c = chunks[batch.c[i]];
+
+            const glm::vec2 to_a = a.getPosition() - b.getPosition();
+            const glm::vec2 to_c = c.getPosition() - b.getPosition();
+
+            // to_a points back, so the bend is the angle from -to_a to to_c
+            const float bend = std::atan2(to_c.x * to_a.y - to_c.y * to_a.x, -glm::dot(to_a, to_c));
+            const float error = bend < batch.min[i] ? bend - batch.min[i] : bend > batch.max[i] ? bend - batch.max[i] : 0.0f;
+            if (error == 0.0f) continue;
+
+            // Turning a counterclockwise and c clockwise both straighten the bend
+            const float turn = error * batch.stiffness[i];
+            const glm::vec2 move_a = b.getPosition() + rotate(to_a, turn * share(a, c)) - a.getPosition();
+            const glm::vec2 move_c = b.getPosition() + rotate(to_c, -turn * share(c, a)) - c.getPosition();
+            a.applyCorrection(move_a, move_a);
+            c.applyCorrection(move_c, move_c);
+        }
+    }
+};
@@ -27,44 +27,14 @@ namespace custom
     }
     */
 
-    int getTilePos(float value) {
+    inline int getTilePos(float value) {
         return static_cast<int>(value / 20.0f);
     }
 
-    glm::ivec2 getTilePos(const glm::vec2& position) {
+    inline glm::ivec2 getTilePos(const glm::vec2& position) {
         glm::ivec2 result;
         result.x = getTilePos(position.x);
         result.y = getTilePos(position.y);
         return result;
     }
-
-    //Cam coordinates are contained on 4th line, for now we assume there is only one camera
-    static glm::ivec2 getCamOffsetFromFile(const std::string& filepath) {
-        std::ifstream file(filepath);
-        if (!file.is_open()) {
-            throw std::runtime_error("Could not open file: " + filepath);
-        }
-
-        std::string line;
-        int currentLine = 0;
-
-        while (std::getline(file, line)) {
-            ++currentLine;
-            if (currentLine == 4) {
-                std::stringstream ss(line);
-                int x, y;
-                char delimiter;
-
-                if (ss >> x >> delimiter >> y && delimiter == ',') {
-                    printf("Camoffset.x = %d\n", x);
-                    printf("Camoffset.y = %d\n", y);
-                    return glm::ivec2(x, y);
-                } else {
-                    throw std::runtime_error("Invalid format on line 4: " + line);
-                }
-            }
-        }
-
-        throw std::runtime_error("File has fewer than 4 lines: " + filepath);
-    }
 }
\ No newline at end of file
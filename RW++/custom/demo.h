@@ -0,0 +1,137 @@
+#pragma once
+
+#include "bodychunk.h"
+#include "geometry.h"
+#include "history.h"
+#include "input.h"
+#include "physics.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Physics of the demo's objects without anything to draw them. The scene objects add their chunks and apply their input through it,
+// rwpp_replay builds the same world from it and replays a run without a window
+namespace demo {
+
+    // Where main.cpp puts them, in the order it adds them
+    inline glm::vec2 playerStart() { return glm::vec2(200, 700); }
+    inline glm::vec2 wormStart() { return glm::vec2(400, 700); }
+    inline glm::vec2 gravity() { return glm::vec2(0, -100); }
+
+    constexpr int WormLength = 5;
+    constexpr float WormSpacing = 22.0f;
+
+    // The player's collider, returns its chunk
+    inline size_t addPlayer(PhysicsWorld &world, const glm::vec2 pos, const glm::vec2 g, RoomGeometry &room) {
+        return world.add(BodyChunk(pos, 1.0f, 16.0f, 0.55f, 0.05f, room), g);
+    }
+
+    // The debug windows' edits, in the order they were made
+    inline void applyEdits(PhysicsWorld &world, const InputFrame &input) {
+        for (const PhysicsEdit &edit: input.edits) {
+            switch (edit.kind) {
+                case PhysicsEdit::ChunkGravity:
+                    world.setGravity(edit.chunk, edit.gravity);
+                    break;
+                case PhysicsEdit::ChunkSettings:
+                    world.getChunk(edit.chunk).setSettings(edit.mass, edit.radius, edit.friction, edit.bounce, edit.projectile);
+                    break;
+                case PhysicsEdit::SolverIterations:
+                    world.getConstraints().setIterations(static_cast<int>(edit.iterations));
+                    break;
+            }
+        }
+    }
+
+    // An edit giving chunk the settings of another one, what copySettings would take
+    inline PhysicsEdit chunkSettingsEdit(const size_t chunk, const BodyChunk &settings) {
+        PhysicsEdit edit { .kind = PhysicsEdit::ChunkSettings, .chunk = static_cast<uint32_t>(chunk) };
+        edit.mass = settings.getMass();
+        edit.radius = settings.getRadius();
+        edit.friction = settings.getFriction();
+        edit.bounce = settings.getBounce();
+        edit.projectile = settings.isProjectile();
+        return edit;
+    }
+
+    // Walking, jumping and teleporting to the cursor
+    inline void applyPlayerInput(PhysicsWorld &world, const size_t player, const InputFrame &input) {
+        BodyChunk &chunk = world.getChunk(player);
+
+        if (input.down(InputRight)) chunk.addVelocity(glm::vec2(10, 0));
+        if (input.down(InputLeft)) chunk.addVelocity(glm::vec2(-10, 0));
+        if (input.down(InputJump)) chunk.addVelocity(glm::vec2(0, 50));
+        if (input.down(InputTeleport)) chunk.setPosition(input.cursor);
+    }
+
+    // A worm of chunks held together by constraints, the head is the heaviest. Returns its chunks head first
+    inline std::vector<size_t> addWorm(PhysicsWorld &world, const glm::vec2 pos, const glm::vec2 g, RoomGeometry &room) {
+        std::vector<size_t> body;
+        for (int i = 0; i < WormLength; ++i) {
+            const float radius = 14.0f - static_cast<float>(i);
+            const float mass = 1.5f - static_cast<float>(i) * 0.2f;
+            body.push_back(world.add(BodyChunk(pos + glm::vec2(i * WormSpacing, 0), mass, radius, 0.6f, 0.1f, room), g));
+        }
+
+        // Every joint bends at most 40 degrees either way
+        ConstraintSolver &constraints = world.getConstraints();
+        for (int i = 0; i + 1 < WormLength; ++i) constraints.addDistance(body[i], body[i + 1], WormSpacing);
+        for (int i = 1; i + 1 < WormLength; ++i) constraints.addAngle(body[i - 1], body[i], body[i + 1], -0.7f, 0.7f, 0.5f);
+
+        return body;
+    }
+
+    inline void applyWormInput(PhysicsWorld &world, const std::vector<size_t> &body, const InputFrame &input) {
+        if (input.down(InputHop)) world.getChunk(body[0]).addVelocity(glm::vec2(0, 30));
+    }
+
+    // The demo's physics stepped the way the scene steps it, rooms are read from the level directory as they're entered
+    class Replay {
+    public:
+        Replay(std::string level_directory, const std::string &start_room) : level_directory(std::move(level_directory)) {
+            RoomGeometry &room = enter(start_room);
+            player = addPlayer(physics, playerStart(), gravity(), room);
+            worm = addWorm(physics, wormStart(), gravity(), room);
+        }
+
+        // Same order as the game: room change, rewind, snapshot, edits, the objects' input, step
+        void tick(const InputFrame &input) {
+            if (!input.room.empty()) {
+                physics.setRoom(enter(input.room));
+                history.clear();
+            }
+
+            const uint32_t rewind = std::min(input.rewind, static_cast<uint32_t>(history.getCount()));
+            if (rewind) history.rollback(physics, rewind);
+            history.save(physics);
+
+            applyEdits(physics, input);
+            applyPlayerInput(physics, player, input);
+            applyWormInput(physics, worm, input);
+            physics.step();
+        }
+
+        PhysicsWorld & getPhysics() { return physics; }
+
+    private:
+        std::string level_directory;
+        std::unordered_map<std::string, std::unique_ptr<RoomGeometry>> rooms; // Chunks point into them, never dropped
+
+        PhysicsWorld physics;
+        PhysicsHistory history;
+        size_t player;
+        std::vector<size_t> worm;
+
+        RoomGeometry & enter(const std::string &name) {
+            auto &room = rooms[name];
+            if (!room) room = std::make_unique<RoomGeometry>(RoomGeometry::fromFile(level_directory + name + ".txt"));
+            return *room;
+        }
+    };
+
+}
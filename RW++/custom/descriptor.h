@@ -0,0 +1,133 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// The header of a room file, everything before the geometry that the renderer cares about.
+//   1: name
+//   2: XSize*YSize|water level|water in front
+//   3: light angle x*y|...
+//   4: camera positions, x,y|x,y|...
+//   5: Border: Passable or Solid
+class RoomDescriptor {
+public:
+    enum class BorderMode { Solid, Passable };
+
+    std::string name;
+    int x_size = 0;
+    int y_size = 0;
+    int water_level = -1;        // In tiles from the bottom, -1 for rooms without water
+    bool water_in_front = false;
+    glm::vec2 light_angle { 0, 0 };
+    std::vector<glm::ivec2> cameras; // Bottom left of each camera in room pixels
+    BorderMode border = BorderMode::Solid;
+
+    bool hasWater() const { return water_level >= 0; }
+
+    // Level image of a camera, ROOM_1.png, ROOM_2.png, ... Rooms with one camera may use ROOM.png instead
+    std::string getImagePath(const std::string &directory, const int camera) const {
+        const std::string numbered = directory + name + "_" + std::to_string(camera + 1) + ".png";
+        if (cameras.size() == 1 && !std::filesystem::exists(numbered)) return directory + name + ".png";
+        return numbered;
+    }
+
+    static RoomDescriptor fromStream(std::istream &in) {
+        std::string lines[5];
+        for (int i = 0; i < 5; ++i) {
+            if (!std::getline(in, lines[i])) {
+                throw std::runtime_error("Room header has fewer than 5 lines");
+            }
+
+            if (!lines[i].empty() && lines[i].back() == '\r') lines[i].pop_back();
+        }
+
+        RoomDescriptor room;
+        room.name = lines[0];
+
+        // XSize*YSize|WaterLevel|WaterInFront, the water parts are optional
+        {
+            const std::vector<std::string> parts = split(lines[1], '|');
+            const std::vector<std::string> size = split(parts[0], '*');
+            if (size.size() != 2) throw std::runtime_error("Invalid room size on line 2: " + lines[1]);
+
+            room.x_size = toInt(size[0], 2, lines[1]);
+            room.y_size = toInt(size[1], 2, lines[1]);
+            if (room.x_size <= 0 || room.y_size <= 0) throw std::runtime_error("Invalid room size on line 2: " + lines[1]);
+
+            if (parts.size() > 1) room.water_level = toInt(parts[1], 2, lines[1]);
+            if (parts.size() > 2) room.water_in_front = toInt(parts[2], 2, lines[1]) != 0;
+        }
+
+        // LightAngleX*LightAngleY|...
+        {
+            const std::vector<std::string> angle = split(split(lines[2], '|')[0], '*');
+            if (angle.size() != 2) throw std::runtime_error("Invalid light angle on line 3: " + lines[2]);
+
+            room.light_angle = glm::vec2(toFloat(angle[0], 3, lines[2]), toFloat(angle[1], 3, lines[2]));
+        }
+
+        // x,y|x,y|...
+        for (const std::string &camera: split(lines[3], '|')) {
+            if (camera.empty()) continue;
+
+            const std::vector<std::string> pos = split(camera, ',');
+            if (pos.size() != 2) throw std::runtime_error("Invalid camera on line 4: " + lines[3]);
+
+            room.cameras.emplace_back(toInt(pos[0], 4, lines[3]), toInt(pos[1], 4, lines[3]));
+        }
+
+        if (room.cameras.empty()) throw std::runtime_error("Room has no cameras on line 4: " + lines[3]);
+
+        // Border: Passable
+        if (lines[4].find("Passable") != std::string::npos) room.border = BorderMode::Passable;
+        else if (lines[4].find("Solid") != std::string::npos) room.border = BorderMode::Solid;
+        else throw std::runtime_error("Invalid border mode on line 5: " + lines[4]);
+
+        return room;
+    }
+
+    static RoomDescriptor fromFile(const std::string &filepath) {
+        std::ifstream file(filepath);
+        if (!file.is_open()) {
+            throw std::runtime_error("Error opening file: " + filepath);
+        }
+
+        return fromStream(file);
+    }
+
+private:
+    static std::vector<std::string> split(const std::string &text, const char delimiter) {
+        std::vector<std::string> parts;
+        std::stringstream ss(text);
+        std::string part;
+
+        while (std::getline(ss, part, delimiter)) parts.push_back(part);
+        if (parts.empty()) parts.emplace_back();
+
+        return parts;
+    }
+
+    static int toInt(const std::string &text, const int line_number, const std::string &line) {
+        try {
+            size_t used;
+            const int value = std::stoi(text, &used);
+            if (text.find_first_not_of(' ', used) != std::string::npos) throw std::invalid_argument(text);
+            return value;
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Invalid number on line " + std::to_string(line_number) + ": " + line);
+        }
+    }
+
+    static float toFloat(const std::string &text, const int line_number, const std::string &line) {
+        try {
+            return std::stof(text);
+        } catch (const std::logic_error&) {
+            throw std::runtime_error("Invalid number on line " + std::to_string(line_number) + ": " + line);
+        }
+    }
+};
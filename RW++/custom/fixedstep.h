@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+
+/**
+ * @brief When fixed rate ticks are due. Never more than MaxCatchUp ticks behind, the ticks over that are dropped instead of run.
+ * Otherwise ticks slower than their period would leave more ticks to catch up on every time, until nothing else runs (the spiral of death)
+ */
+class FixedStep {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static constexpr int MaxCatchUp = 4;
+
+    FixedStep(const Clock::duration period, const Clock::time_point start) : period(period), next(start) {
+        if (period <= Clock::duration::zero()) throw std::invalid_argument("A fixed step needs a period");
+    }
+
+    // Ticks to run by now, at most MaxCatchUp. Dropping the ones over that moves the next tick on
+    int due(const Clock::time_point now) {
+        if (now < next) return 0;
+
+        const int64_t late = (now - next) / period + 1;
+        if (late <= MaxCatchUp) return static_cast<int>(late);
+
+        dropped += static_cast<uint64_t>(late - MaxCatchUp);
+        next += period * (late - MaxCatchUp);
+        return MaxCatchUp;
+    }
+
+    // Takes the next tick, returns when it was due
+    Clock::time_point advance() {
+        const Clock::time_point tick = next;
+        next += period;
+        return tick;
+    }
+
+    Clock::time_point getNext() const { return next; }
+    Clock::duration getPeriod() const { return period; }
+
+    // Ticks dropped since the start
+    uint64_t getDropped() const { return dropped; }
+
+private:
+    Clock::duration period;
+    Clock::time_point next;
+    uint64_t dropped = 0;
+};
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 #include <stdexcept>
@@ -15,7 +17,7 @@
 class RoomGeometry {
 public:
     RoomGeometry(int x_size, int y_size, const std::vector<int>& tiles)
-        : x_size(x_size), y_size(y_size), grid(x_size, y_size) {
+        : x_size(x_size), y_size(y_size), grid(x_size, y_size), tile_revisions(tiles.size(), 0) {
         if (tiles.size() != static_cast<size_t>(x_size * y_size)) {
             throw std::invalid_argument("Tile data size does not match room dimensions.");
         }
@@ -96,6 +98,30 @@ public:
         return getTileType(pos.x, pos.y);
     }
 
+    // Changes a tile and bumps the revision, same coordinates as getTileType but out of range ones throw
+    void setTileType(int x, int y, int type) {
+        if (x < 0 || x >= x_size || y < 0 || y >= y_size) {
+            throw std::out_of_range("Tile outside of the room.");
+        }
+
+        int &tile = grid.at(x, y_size - y - 1);
+        if (tile == type) return;
+
+        tile = type;
+        revision++;
+        tile_revisions[y * x_size + x] = revision;
+    }
+
+    // Bumped by every tile change
+    uint32_t getRevision() const { return revision; }
+
+    // Revision of the last change to a tile, 0 if it never changed. Clamped like getTileType
+    uint32_t getTileRevision(int x, int y) const {
+        x = std::clamp(x, 0, x_size - 1);
+        y = std::clamp(y, 0, y_size - 1);
+        return tile_revisions[y * x_size + x];
+    }
+
     int getTileType(glm::vec2 pos){
         return getTileType(custom::getTilePos(pos));
     }
@@ -111,6 +137,9 @@ private:
     int x_size, y_size;
     Matrix grid;
 
+    uint32_t revision = 0;
+    std::vector<uint32_t> tile_revisions; // By getTileType coordinates, y up
+
     //I blame lingo :(<
     static std::vector<int> parseLine(const std::string& line) {
         std::vector<int> result;
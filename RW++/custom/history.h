@@ -0,0 +1,97 @@
+#pragma once
+
+#include "physics.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+
+// The last getCapacity() ticks of a physics world, for rolling back and stepping again with corrected inputs.
+// Frames live in one ring allocated for the world's chunk count, a save is two memcpys and never allocates.
+// Chunks keep a pointer to their room, the history has to be cleared when the world moves to another room.
+// Adding chunks clears it too, older frames don't have them
+template<typename Features>
+class BasicPhysicsHistory {
+public:
+    typedef BasicPhysicsWorld<Features> World;
+    typedef typename World::Chunk Chunk;
+
+    explicit BasicPhysicsHistory(const size_t capacity = 240) : capacity(capacity) {
+        if (capacity == 0) throw std::invalid_argument("A physics history needs room for at least one tick");
+    }
+
+    size_t getCapacity() const { return capacity; }
+    size_t getCount() const { return count; }
+
+    // Ticks the stored frames were saved at, a frame holds the world from before that tick ran
+    uint64_t getOldestTick() const { return newest + 1 - count; }
+    uint64_t getNewestTick() const { return newest; }
+
+    bool has(const uint64_t tick) const {
+        return count > 0 && tick <= newest && tick >= getOldestTick();
+    }
+
+    void clear() {
+        count = 0;
+    }
+
+    /**
+     * @brief Saves the world as it is before its next step, overwriting the oldest frame once full.
+     * Saving a tick that's already stored drops it and every frame after it, the world took another way from there
+     */
+    void save(const World &world) {
+        const uint64_t tick = world.getTicks();
+
+        if (world.getCount() != chunk_count) {
+            chunk_count = world.getCount();
+            chunk_bytes.assign(capacity * chunk_count * sizeof(Chunk), std::byte {0});
+            gravities.assign(capacity * chunk_count, glm::vec2(0));
+            count = 0;
+        }
+
+        if (has(tick)) count -= static_cast<size_t>(newest - tick + 1);
+        else if (count > 0 && tick != newest + 1) count = 0;
+
+        const size_t slot = tick % capacity;
+        world.saveState(chunk_bytes.data() + slot * chunk_count * sizeof(Chunk), gravities.data() + slot * chunk_count);
+
+        newest = tick;
+        count = std::min(count + 1, capacity);
+    }
+
+    /**
+     * @brief Puts the world back to how it was before the given tick, the frame stays stored and the ones after it are dropped
+     * @throws std::out_of_range if the tick isn't stored
+     */
+    void restore(World &world, const uint64_t tick) {
+        if (!has(tick)) throw std::out_of_range("Physics tick " + std::to_string(tick) + " isn't in the history");
+        if (world.getCount() != chunk_count) throw std::invalid_argument("The physics world has different chunks than its history");
+
+        const size_t slot = tick % capacity;
+        world.loadState(chunk_bytes.data() + slot * chunk_count * sizeof(Chunk), gravities.data() + slot * chunk_count, tick);
+
+        count -= static_cast<size_t>(newest - tick);
+        newest = tick;
+    }
+
+    // Rolls the world back to before the last ticks it stepped, 1 undoes the last step
+    void rollback(World &world, const size_t ticks) {
+        if (ticks > world.getTicks()) throw std::out_of_range("Can't roll back past the first physics tick");
+        restore(world, world.getTicks() - ticks);
+    }
+
+private:
+    size_t capacity;
+    size_t count = 0;
+    uint64_t newest = 0;
+
+    size_t chunk_count = 0;
+    std::vector<std::byte> chunk_bytes; // capacity frames of chunk_count chunks, the frame of a tick is at tick % capacity
+    std::vector<glm::vec2> gravities;
+};
+
+typedef BasicPhysicsHistory<DefaultChunkFeatures> PhysicsHistory;
@@ -0,0 +1,368 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Buttons of an InputFrame. Held ones stay down from tick to tick, pressed ones are down for the one tick after the press
+enum InputButton : uint8_t {
+    InputRight = 1 << 0,    // Held
+    InputLeft = 1 << 1,     // Held
+    InputJump = 1 << 2,     // Pressed
+    InputHop = 1 << 3,      // Pressed, the worm's hop
+    InputTeleport = 1 << 4, // Held, the player follows cursor
+};
+
+// A change a debug window made to the physics. Part of the tick's input so a replay makes it on the same tick,
+// see demo::applyEdits
+struct PhysicsEdit {
+    enum Kind : uint8_t {
+        ChunkGravity,     // gravity of chunk
+        ChunkSettings,    // mass, radius, friction, bounce and projectile of chunk, see BasicBodyChunk::setSettings
+        SolverIterations, // iterations of the constraint solver
+    };
+
+    Kind kind = ChunkGravity;
+    uint32_t chunk = 0;
+    glm::vec2 gravity {0};
+    float mass = 0, radius = 0, friction = 0, bounce = 0;
+    bool projectile = false;
+    uint32_t iterations = 0;
+
+    bool operator==(const PhysicsEdit &other) const = default;
+};
+
+// What happened before one physics tick, applied by the scene objects in their physics_tick.
+// Rewinds and room changes happen between ticks, they're applied in that order before the tick's snapshot is saved.
+// Edits are applied after the snapshot, before the objects' input
+struct InputFrame {
+    uint8_t buttons = 0;
+    glm::vec2 cursor {0};   // Room position the player teleports to while InputTeleport is held
+    uint32_t rewind = 0;    // Ticks the physics was rewound by
+    std::string room;       // Room entered, empty for none
+    std::vector<PhysicsEdit> edits; // In the order they were made
+
+    bool down(const InputButton button) const {
+        return (buttons & button) != 0;
+    }
+
+    bool operator==(const InputFrame &other) const = default;
+};
+
+// Collects what the player does over the frames between two physics ticks, the next tick takes it as its InputFrame.
+// Frames fill it on one thread while ticks take it on another, every call locks
+class InputLatch {
+public:
+    // Held buttons that are down this frame, only the last frame before the tick counts
+    void hold(const uint8_t buttons) {
+        std::lock_guard guard(lock);
+        held = buttons;
+    }
+
+    // Pressed buttons, a press in any frame before the tick counts
+    void press(const uint8_t buttons) {
+        std::lock_guard guard(lock);
+        pending.buttons |= buttons;
+    }
+
+    void setCursor(const glm::vec2 cursor) {
+        std::lock_guard guard(lock);
+        pending.cursor = cursor;
+    }
+
+    void rewound(const uint32_t ticks) {
+        std::lock_guard guard(lock);
+        pending.rewind += ticks;
+    }
+
+    void edit(const PhysicsEdit &edit) {
+        std::lock_guard guard(lock);
+        pending.edits.push_back(edit);
+    }
+
+    // The history is cleared on the way, a rewind before the room change has nothing left to go back to
+    void enteredRoom(const std::string &room) {
+        std::lock_guard guard(lock);
+        pending.room = room;
+        pending.rewind = 0;
+    }
+
+    InputFrame take() {
+        std::lock_guard guard(lock);
+        InputFrame frame = std::move(pending);
+        frame.buttons |= held;
+        if (!frame.down(InputTeleport)) frame.cursor = glm::vec2(0);
+
+        pending = InputFrame {};
+        return frame;
+    }
+
+private:
+    std::mutex lock;
+    uint8_t held = 0;
+    InputFrame pending;
+};
+
+/**
+ * @brief Every tick's InputFrame of a run, from the room it started in, and the physics checksum it ended on.
+ * Saved as a compact binary log, a frame is only written when it isn't the previous one's held buttons again:
+ *   "RWIN", version byte, start room
+ *   records: ticks skipped since the last record (varint), flags byte, cursor if teleporting, rewind (varint), room,
+ *            edit count (varint) and the edits, each a kind byte and its values
+ *   end record: ticks skipped, End flag, checksum (8 bytes)
+ * Version 1 logs have no edits and are still read
+ * Skipped ticks repeat the held buttons of the record before them
+ * Strings are a varint length and the bytes, numbers are little endian
+ */
+class InputLog {
+public:
+    static constexpr uint8_t Version = 2;
+
+    InputLog() = default;
+
+    explicit InputLog(std::string start_room) : start_room(std::move(start_room)) {}
+
+    const std::string & getStartRoom() const { return start_room; }
+
+    void push(const InputFrame &frame) {
+        frames.push_back(frame);
+    }
+
+    size_t getTickCount() const { return frames.size(); }
+
+    const InputFrame & getFrame(const size_t tick) const { return frames.at(tick); }
+
+    uint64_t getChecksum() const { return checksum; }
+    void setChecksum(const uint64_t value) { checksum = value; }
+
+    std::vector<uint8_t> serialize() const {
+        std::vector<uint8_t> out { 'R', 'W', 'I', 'N', Version };
+        writeString(out, start_room);
+
+        InputFrame previous;
+        size_t skipped_from = 0;
+        for (size_t tick = 0; tick < frames.size(); ++tick) {
+            const InputFrame &frame = frames[tick];
+            if (frame == held(previous)) {
+                previous = frame;
+                continue;
+            }
+
+            uint8_t flags = frame.buttons;
+            if (frame.rewind) flags |= Rewind;
+            if (!frame.room.empty()) flags |= Room;
+
+            writeVarint(out, tick - skipped_from);
+            out.push_back(flags);
+            if (frame.down(InputTeleport)) {
+                writeFloat(out, frame.cursor.x);
+                writeFloat(out, frame.cursor.y);
+            }
+            if (frame.rewind) writeVarint(out, frame.rewind);
+            if (!frame.room.empty()) writeString(out, frame.room);
+
+            writeVarint(out, frame.edits.size());
+            for (const PhysicsEdit &edit: frame.edits) writeEdit(out, edit);
+
+            previous = frame;
+            skipped_from = tick + 1;
+        }
+
+        writeVarint(out, frames.size() - skipped_from);
+        out.push_back(End);
+        for (int i = 0; i < 8; ++i) out.push_back(static_cast<uint8_t>(checksum >> (i * 8)));
+        return out;
+    }
+
+    /**
+     * @throws std::runtime_error for anything that isn't a log this version wrote
+     */
+    static InputLog deserialize(const std::vector<uint8_t> &bytes) {
+        Reader in { bytes };
+        if (in.take(4) != "RWIN") throw std::runtime_error("Not an input log");
+        const uint8_t version = in.byte();
+        if (version != 1 && version != Version) throw std::runtime_error("Input log of another version");
+
+        InputLog log(in.string());
+
+        InputFrame previous;
+        while (true) {
+            const uint64_t skipped = in.varint();
+            const uint8_t flags = in.byte();
+
+            for (uint64_t i = 0; i < skipped; ++i) log.frames.push_back(held(previous));
+
+            if (flags & End) {
+                for (int i = 0; i < 8; ++i) log.checksum |= static_cast<uint64_t>(in.byte()) << (i * 8);
+                break;
+            }
+
+            InputFrame frame;
+            frame.buttons = flags & ButtonMask;
+            if (frame.down(InputTeleport)) {
+                frame.cursor.x = in.real();
+                frame.cursor.y = in.real();
+            }
+            if (flags & Rewind) frame.rewind = static_cast<uint32_t>(in.varint());
+            if (flags & Room) frame.room = in.string();
+            if (version >= 2) {
+                const uint64_t edits = in.varint();
+                for (uint64_t i = 0; i < edits; ++i) frame.edits.push_back(in.edit());
+            }
+
+            log.frames.push_back(frame);
+            previous = frame;
+        }
+
+        return log;
+    }
+
+    void save(const std::string &path) const {
+        const std::vector<uint8_t> bytes = serialize();
+
+        std::ofstream file(path, std::ios::binary);
+        if (!file.is_open()) throw std::runtime_error("Error opening file: " + path);
+        file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    }
+
+    static InputLog load(const std::string &path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) throw std::runtime_error("Error opening file: " + path);
+
+        const std::vector<uint8_t> bytes { std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>() };
+        return deserialize(bytes);
+    }
+
+private:
+    // Flags of a record, the low bits are the buttons
+    static constexpr uint8_t ButtonMask = 0x1F;
+    static constexpr uint8_t Rewind = 1 << 5;
+    static constexpr uint8_t Room = 1 << 6;
+    static constexpr uint8_t End = 1 << 7;
+
+    std::string start_room;
+    std::vector<InputFrame> frames;
+    uint64_t checksum = 0;
+
+    // What the frame after this one is when nothing changes
+    static InputFrame held(const InputFrame &frame) {
+        InputFrame next;
+        next.buttons = frame.buttons & (InputRight | InputLeft | InputTeleport);
+        next.cursor = frame.cursor;
+        return next;
+    }
+
+    static void writeVarint(std::vector<uint8_t> &out, uint64_t value) {
+        while (value >= 0x80) {
+            out.push_back(static_cast<uint8_t>(value | 0x80));
+            value >>= 7;
+        }
+        out.push_back(static_cast<uint8_t>(value));
+    }
+
+    static void writeFloat(std::vector<uint8_t> &out, const float value) {
+        uint32_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        for (int i = 0; i < 4; ++i) out.push_back(static_cast<uint8_t>(bits >> (i * 8)));
+    }
+
+    static void writeString(std::vector<uint8_t> &out, const std::string &value) {
+        writeVarint(out, value.size());
+        out.insert(out.end(), value.begin(), value.end());
+    }
+
+    static void writeEdit(std::vector<uint8_t> &out, const PhysicsEdit &edit) {
+        out.push_back(edit.kind);
+        switch (edit.kind) {
+            case PhysicsEdit::ChunkGravity:
+                writeVarint(out, edit.chunk);
+                writeFloat(out, edit.gravity.x);
+                writeFloat(out, edit.gravity.y);
+                break;
+            case PhysicsEdit::ChunkSettings:
+                writeVarint(out, edit.chunk);
+                writeFloat(out, edit.mass);
+                writeFloat(out, edit.radius);
+                writeFloat(out, edit.friction);
+                writeFloat(out, edit.bounce);
+                out.push_back(edit.projectile);
+                break;
+            case PhysicsEdit::SolverIterations:
+                writeVarint(out, edit.iterations);
+                break;
+        }
+    }
+
+    struct Reader {
+        const std::vector<uint8_t> &bytes;
+        size_t at = 0;
+
+        uint8_t byte() {
+            if (at >= bytes.size()) throw std::runtime_error("Input log ends early");
+            return bytes[at++];
+        }
+
+        std::string take(const size_t count) {
+            if (bytes.size() - at < count) throw std::runtime_error("Input log ends early");
+            std::string value(reinterpret_cast<const char *>(bytes.data() + at), count);
+            at += count;
+            return value;
+        }
+
+        uint64_t varint() {
+            uint64_t value = 0;
+            for (int shift = 0; shift < 64; shift += 7) {
+                const uint8_t b = byte();
+                value |= static_cast<uint64_t>(b & 0x7F) << shift;
+                if (!(b & 0x80)) return value;
+            }
+            throw std::runtime_error("Input log has a broken number");
+        }
+
+        float real() {
+            uint32_t bits = 0;
+            for (int i = 0; i < 4; ++i) bits |= static_cast<uint32_t>(byte()) << (i * 8);
+            float value;
+            std::memcpy(&value, &bits, sizeof(value));
+            return value;
+        }
+
+        std::string string() {
+            return take(static_cast<size_t>(varint()));
+        }
+
+        PhysicsEdit edit() {
+            PhysicsEdit edit;
+            edit.kind = static_cast<PhysicsEdit::Kind>(byte());
+            switch (edit.kind) {
+                case PhysicsEdit::ChunkGravity:
+                    edit.chunk = static_cast<uint32_t>(varint());
+                    edit.gravity.x = real();
+                    edit.gravity.y = real();
+                    break;
+                case PhysicsEdit::ChunkSettings:
+                    edit.chunk = static_cast<uint32_t>(varint());
+                    edit.mass = real();
+                    edit.radius = real();
+                    edit.friction = real();
+                    edit.bounce = real();
+                    edit.projectile = byte() != 0;
+                    break;
+                case PhysicsEdit::SolverIterations:
+                    edit.iterations = static_cast<uint32_t>(varint());
+                    break;
+                default:
+                    throw std::runtime_error("Input log has an unknown edit");
+            }
+            return edit;
+        }
+    };
+};
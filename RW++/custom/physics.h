@@ -0,0 +1,251 @@
+#pragma once
+
+#include "bodychunk.h"
+#include "constraints.h"
+#include "geometry.h"
+#include "spatial.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <type_traits>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Steps every body chunk of the room once per physics tick.
+// A tick runs in phases: integrate, move through the terrain, broadphase, resolve chunk against chunk, write back and relax the
+// constraints between chunks. Each phase is split
+// into batches of BatchSize chunks that only write their own chunks, so the runner may run them in any order on any thread.
+// Batches depend on the number of awake chunks alone and every sum runs in an order fixed by the chunks alone, results are bit identical for any runner.
+// Chunks resting on solid ground or on other chunks fall asleep and are left out of every phase but the broadphase, until an awake chunk
+// touches them, they're moved through a setter or a tile next to them changes.
+// A world holds chunks of one feature set, a homogeneous array stepped without any per chunk branching on what the chunk can do
+template<typename Features>
+class BasicPhysicsWorld {
+public:
+    typedef BasicBodyChunk<Features> Chunk;
+    static_assert(std::is_trivially_copyable_v<Chunk>, "snapshots copy chunks as bytes");
+
+    static constexpr size_t BatchSize = 32;
+
+    static constexpr float SleepSpeed = 0.05f; // Room pixels per tick a resting chunk has to stay under
+    static constexpr int SleepTicks = 40;      // for this many ticks in a row before it falls asleep
+
+    // Calls batch(i) once for every i in [0, count) and returns once all of them ran
+    typedef std::function<void(size_t count, const std::function<void(size_t)> &batch)> BatchRunner;
+
+    BasicPhysicsWorld() = default;
+
+    // Runs the batches of every phase, the default runs them one after another on the calling thread
+    void setRunner(BatchRunner batch_runner) {
+        runner = std::move(batch_runner);
+    }
+
+    // Adds a chunk falling with gravity (room pixels per tick squared), returns its index
+    size_t add(const Chunk &chunk, const glm::vec2 gravity) {
+        chunks.push_back(chunk);
+        gravities.push_back(gravity);
+        corrections.emplace_back(0.0f);
+        impulses.emplace_back(0.0f);
+        touches_sleeper.push_back(0);
+        supported.push_back(0);
+        return chunks.size() - 1;
+    }
+
+    size_t getCount() const { return chunks.size(); }
+
+    Chunk & getChunk(const size_t index) { return chunks.at(index); }
+    const Chunk & getChunk(const size_t index) const { return chunks.at(index); }
+
+    glm::vec2 getGravity(const size_t index) const { return gravities.at(index); }
+    void setGravity(const size_t index, const glm::vec2 gravity) { gravities.at(index) = gravity; }
+
+    // Every chunk collides with this room from now on, the geometry has to outlive the world or the next setRoom
+    void setRoom(RoomGeometry &room) {
+        for (Chunk &chunk: chunks) chunk.setRoom(room);
+    }
+
+    void step() {
+        constraints.wakeConnected(chunks);
+
+        active.clear();
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            if (chunks[i].isAsleep() && chunks[i].terrainChanged()) chunks[i].wake();
+            if (!chunks[i].isAsleep()) active.push_back(static_cast<uint32_t>(i));
+        }
+
+        forEachBatch([this](const size_t begin, const size_t end) {
+            for (size_t k = begin; k < end; ++k) chunks[active[k]].Integrate(gravities[active[k]]);
+        });
+
+        forEachBatch([this](const size_t begin, const size_t end) {
+            for (size_t k = begin; k < end; ++k) chunks[active[k]].Move();
+        });
+
+        // Linear and cheap next to the other phases, stays on the calling thread. Sleeping chunks are in it so awake ones hit them
+        positions.resize(chunks.size());
+        radii.resize(chunks.size());
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            positions[i] = chunks[i].getPosition();
+            radii[i] = chunks[i].getRadius();
+        }
+        broadphase.update(positions, radii);
+
+        // Chunks only read the others here, each writes its own correction
+        forEachBatch([this](const size_t begin, const size_t end) {
+            for (size_t k = begin; k < end; ++k) resolve(active[k]);
+        });
+
+        // Sleepers that got hit join in from the next tick on
+        for (const uint32_t i: active) {
+            if (!touches_sleeper[i]) continue;
+
+            broadphase.query(chunks[i].getPosition(), chunks[i].getRadius(), [&](const size_t j) {
+                if (chunks[j].isAsleep() && overlaps(chunks[i], chunks[j])) chunks[j].wake();
+            });
+        }
+
+        forEachBatch([this](const size_t begin, const size_t end) {
+            for (size_t k = begin; k < end; ++k) chunks[active[k]].applyCorrection(corrections[active[k]], impulses[active[k]]);
+        });
+
+        constraints.solve(chunks, runner);
+
+        forEachBatch([this](const size_t begin, const size_t end) {
+            for (size_t k = begin; k < end; ++k) chunks[active[k]].updateRest(SleepSpeed, SleepTicks, supported[active[k]]);
+        });
+
+        ticks++;
+    }
+
+    uint64_t getTicks() const { return ticks; }
+
+    // Copies everything a tick reads and writes into arrays of getCount() chunks and gravities, see BasicPhysicsHistory
+    void saveState(std::byte *chunk_bytes, glm::vec2 *gravity_out) const {
+        std::memcpy(chunk_bytes, chunks.data(), chunks.size() * sizeof(Chunk));
+        std::memcpy(gravity_out, gravities.data(), gravities.size() * sizeof(glm::vec2));
+    }
+
+    // Puts back what saveState copied at the given tick, the next step continues exactly like it did from there.
+    // The world has to have the same chunks it had when saving
+    void loadState(const std::byte *chunk_bytes, const glm::vec2 *gravity_in, const uint64_t tick) {
+        std::memcpy(static_cast<void *>(chunks.data()), chunk_bytes, chunks.size() * sizeof(Chunk));
+        std::memcpy(gravities.data(), gravity_in, gravities.size() * sizeof(glm::vec2));
+        ticks = tick;
+    }
+
+    // Chunks stepped by the last tick, the rest slept through it
+    size_t getActiveCount() const { return active.size(); }
+
+    const SpatialHash & getBroadphase() const { return broadphase; }
+
+    // Connections between the chunks of this world, by chunk index
+    ConstraintSolver & getConstraints() { return constraints; }
+    const ConstraintSolver & getConstraints() const { return constraints; }
+
+    // FNV-1a over the bits of every chunk's position and velocity, for comparing runs
+    uint64_t checksum() const {
+        uint64_t hash = 14695981039346656037ull;
+        const auto mix = [&hash](const float value) {
+            uint32_t bits;
+            std::memcpy(&bits, &value, sizeof(bits));
+            for (int i = 0; i < 4; ++i) {
+                hash ^= (bits >> (i * 8)) & 0xFF;
+                hash *= 1099511628211ull;
+            }
+        };
+
+        for (const Chunk &chunk: chunks) {
+            mix(chunk.getPosition().x);
+            mix(chunk.getPosition().y);
+            mix(chunk.getVelocity().x);
+            mix(chunk.getVelocity().y);
+        }
+        return hash;
+    }
+
+private:
+    std::vector<Chunk> chunks;
+    std::vector<glm::vec2> gravities;
+    std::vector<glm::vec2> corrections; // Position and velocity changes written by the resolve phase, applied by write back
+    std::vector<glm::vec2> impulses;
+    std::vector<uint8_t> touches_sleeper; // Set by resolve when the chunk overlaps a sleeping one
+    std::vector<uint8_t> supported;       // and when it lies on top of another chunk
+
+    std::vector<uint32_t> active; // Awake chunks in index order, what the batches run over
+
+    SpatialHash broadphase;
+    ConstraintSolver constraints;
+    std::vector<glm::vec2> positions; // Broadphase input, kept so it doesn't allocate every tick
+    std::vector<float> radii;
+
+    BatchRunner runner;
+    uint64_t ticks = 0;
+
+    void forEachBatch(const std::function<void(size_t, size_t)> &fn) {
+        const size_t count = (active.size() + BatchSize - 1) / BatchSize;
+        const auto batch = [&](const size_t i) {
+            fn(i * BatchSize, std::min(active.size(), (i + 1) * BatchSize));
+        };
+
+        if (runner) runner(count, batch);
+        else for (size_t i = 0; i < count; ++i) batch(i);
+    }
+
+    static bool overlaps(const Chunk &a, const Chunk &b) {
+        return glm::length(a.getPosition() - b.getPosition()) < a.getRadius() + b.getRadius();
+    }
+
+    /**
+     * @brief Pushes the chunk out of every chunk it overlaps and takes its share of their approach speed.
+     * The lighter of two chunks moves further and gets more of the velocity change, the less bouncy one decides the restitution
+     */
+    void resolve(const size_t index) {
+        const Chunk &chunk = chunks[index];
+        glm::vec2 correction(0.0f);
+        glm::vec2 impulse(0.0f);
+        uint8_t touched_sleeper = 0;
+        uint8_t lies_on = 0;
+
+        broadphase.query(chunk.getPosition(), chunk.getRadius(), [&](const size_t j) {
+            if (j == index) return;
+            const Chunk &other = chunks[j];
+
+            const glm::vec2 delta = chunk.getPosition() - other.getPosition();
+            const float distance = glm::length(delta);
+            const float overlap = chunk.getRadius() + other.getRadius() - distance;
+            if (overlap <= 0.0f) return;
+
+            // Resting chunks keep touching their sleeping neighbours, only moving ones wake them
+            touched_sleeper |= other.isAsleep() && !chunk.isResting();
+
+            // Chunks exactly on top of each other separate along x, the lower index going left
+            const glm::vec2 normal = distance > 0.0f ? delta / distance : glm::vec2(index < j ? -1.0f : 1.0f, 0.0f);
+            lies_on |= normal.y > 0.7f;
+
+            // Our share of the pair, the other chunk takes the rest when it resolves against us.
+            // Chunks on the ground or asleep don't give way to chunks on top of them, otherwise stacks never come to rest
+            const float total_mass = chunk.getMass() + other.getMass();
+            float share = total_mass > 0.0f ? other.getMass() / total_mass : 0.5f;
+            if (normal.y > 0.7f && (other.isAsleep() || other.isOnSolid())) share = 1.0f;
+            else if (normal.y < -0.7f && chunk.isOnSolid()) share = 0.0f;
+
+            correction += normal * (overlap * share);
+
+            const float approach = glm::dot(chunk.getVelocity() - other.getVelocity(), normal);
+            if (approach < 0.0f) {
+                const float restitution = std::min(chunk.getBounce(), other.getBounce());
+                impulse -= normal * ((1.0f + restitution) * approach * share);
+            }
+        });
+
+        corrections[index] = correction;
+        impulses[index] = impulse;
+        touches_sleeper[index] = touched_sleeper;
+        supported[index] = lies_on;
+    }
+};
+
+typedef BasicPhysicsWorld<DefaultChunkFeatures> PhysicsWorld;
@@ -0,0 +1,136 @@
+#pragma once
+
+#include <algorithm>
+#include <fstream>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+// Rooms of a region and how they connect, the ROOMS section of a world file:
+//   ROOMS
+//   SU_A40 : SU_A41, SU_A22, DISCONNECTED
+//   SU_S01 : SU_A40 : SHELTER
+//   END ROOMS
+// Connections can name rooms outside the region (gates), those are kept but never streamed
+class RegionMap {
+public:
+    struct Room {
+        std::string name;
+        std::vector<std::string> connections; // DISCONNECTED exits are dropped
+        std::string tag;                      // SHELTER, GATE, ... or empty
+    };
+
+    static RegionMap fromStream(std::istream &in) {
+        RegionMap region;
+        std::string line;
+        bool in_rooms = false;
+        bool found_rooms = false;
+
+        while (std::getline(in, line)) {
+            line = trim(line);
+            if (line.empty() || line.starts_with("//")) continue;
+
+            if (!in_rooms) {
+                if (line == "ROOMS") in_rooms = found_rooms = true;
+                continue;
+            }
+
+            if (line == "END ROOMS") {
+                in_rooms = false;
+                continue;
+            }
+
+            const std::vector<std::string> parts = split(line, ':');
+            if (parts.size() < 2 || parts.size() > 3 || parts[0].empty())
+                throw std::runtime_error("Invalid room line in world file: " + line);
+
+            Room room { parts[0], {}, parts.size() == 3 ? parts[2] : "" };
+            for (const std::string &connection: split(parts[1], ',')) {
+                if (!connection.empty() && connection != "DISCONNECTED") room.connections.push_back(connection);
+            }
+
+            if (region.index.contains(room.name)) throw std::runtime_error("Room listed twice in world file: " + room.name);
+
+            region.index.emplace(room.name, region.rooms.size());
+            region.rooms.push_back(std::move(room));
+        }
+
+        if (!found_rooms) throw std::runtime_error("World file has no ROOMS section");
+        if (in_rooms) throw std::runtime_error("World file is missing END ROOMS");
+
+        return region;
+    }
+
+    static RegionMap fromFile(const std::string &filepath) {
+        std::ifstream file(filepath);
+        if (!file.is_open()) {
+            throw std::runtime_error("Error opening file: " + filepath);
+        }
+
+        return fromStream(file);
+    }
+
+    const std::vector<Room> & getRooms() const { return rooms; }
+
+    bool contains(const std::string &name) const { return index.contains(name); }
+
+    const Room & getRoom(const std::string &name) const {
+        const auto found = index.find(name);
+        if (found == index.end()) throw std::runtime_error("Room isn't in the region: " + name);
+        return rooms[found->second];
+    }
+
+    /**
+     * @brief Rooms of this region reachable from a room in at most depth steps, nearest first
+     * @return names, the room itself isn't included
+     */
+    std::vector<std::string> neighbours(const std::string &name, const int depth) const {
+        std::vector<std::string> found;
+        std::unordered_set<std::string> seen { name };
+        std::queue<std::pair<std::string, int>> open;
+        open.emplace(name, 0);
+
+        while (!open.empty()) {
+            const auto [room, steps] = open.front();
+            open.pop();
+            if (steps == depth) continue;
+
+            for (const std::string &connection: getRoom(room).connections) {
+                if (!contains(connection) || !seen.insert(connection).second) continue;
+
+                found.push_back(connection);
+                open.emplace(connection, steps + 1);
+            }
+        }
+
+        return found;
+    }
+
+private:
+    std::vector<Room> rooms;
+    std::unordered_map<std::string, size_t> index;
+
+    static std::string trim(const std::string &text) {
+        const size_t first = text.find_first_not_of(" \t\r");
+        if (first == std::string::npos) return "";
+        return text.substr(first, text.find_last_not_of(" \t\r") - first + 1);
+    }
+
+    static std::vector<std::string> split(const std::string &text, const char delimiter) {
+        std::vector<std::string> parts;
+        size_t start = 0;
+
+        while (true) {
+            const size_t end = text.find(delimiter, start);
+            parts.push_back(trim(text.substr(start, end - start)));
+            if (end == std::string::npos) break;
+            start = end + 1;
+        }
+
+        return parts;
+    }
+};
@@ -0,0 +1,328 @@
+#pragma once
+
+#include "geometry.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Ropes, vines and tongues as chains of point masses, far cheaper per segment than a body chunk each.
+// Points of every rope live in the same flat arrays, field by field, so integration is one straight loop over all of them.
+// A tick integrates every point with Verlet, then relaxes each rope's segment lengths and pushes its points out of solid tiles
+// for getIterations() rounds. Ropes only touch their own points, so they're handed to the runner in batches and the results
+// are bit identical for any runner
+class RopeSystem {
+public:
+    static constexpr size_t PointBatchSize = 1024;
+    static constexpr size_t RopeBatchSize = 8;
+    static constexpr float TileSize = 20.0f;
+
+    // Same contract as PhysicsWorld::BatchRunner
+    typedef std::function<void(size_t count, const std::function<void(size_t)> &batch)> BatchRunner;
+
+    // Timing of the last step and a running average, in milliseconds
+    struct Stats {
+        float last_ms = 0;
+        float average_ms = 0;
+    };
+
+    void setRunner(BatchRunner batch_runner) {
+        runner = std::move(batch_runner);
+    }
+
+    /**
+     * @brief Adds a rope of segments equal segments laid out straight from one point to another
+     * @param radius how far the rope keeps from solid tiles, also half of its drawn width
+     * @param slack segment length over the laid out one, above 1 the rope sags
+     * @return index of the rope
+     */
+    size_t add(const glm::vec2 from, const glm::vec2 to, const uint32_t segments, const float radius, const float slack = 1.0f) {
+        if (segments == 0) throw std::invalid_argument("Rope without segments.");
+
+        ropes.push_back(Rope { static_cast<uint32_t>(x.size()), segments + 1, glm::length(to - from) / static_cast<float>(segments) * slack, radius });
+
+        for (uint32_t i = 0; i <= segments; ++i) {
+            const glm::vec2 point = from + (to - from) * (static_cast<float>(i) / static_cast<float>(segments));
+            x.push_back(point.x);
+            y.push_back(point.y);
+            previous_x.push_back(point.x);
+            previous_y.push_back(point.y);
+            weight.push_back(1.0f);
+        }
+
+        return ropes.size() - 1;
+    }
+
+    // Drops every rope, settings and the room stay
+    void clear() {
+        ropes.clear();
+        x.clear();
+        y.clear();
+        previous_x.clear();
+        previous_y.clear();
+        weight.clear();
+    }
+
+    size_t getRopeCount() const { return ropes.size(); }
+    size_t getPointCount() const { return x.size(); }
+    uint32_t getPointCount(const size_t rope) const { return ropes.at(rope).count; }
+    float getSegmentLength(const size_t rope) const { return ropes.at(rope).length; }
+
+    glm::vec2 getPoint(const size_t rope, const uint32_t point) const {
+        const size_t i = index(rope, point);
+        return glm::vec2(x[i], y[i]);
+    }
+
+    // Moves a point without giving it speed, what pinned points are dragged around with
+    void setPoint(const size_t rope, const uint32_t point, const glm::vec2 position) {
+        const size_t i = index(rope, point);
+        x[i] = previous_x[i] = position.x;
+        y[i] = previous_y[i] = position.y;
+    }
+
+    // Pinned points don't move by themselves and aren't pulled by the rope, only setPoint moves them
+    void pin(const size_t rope, const uint32_t point, const bool pinned = true) {
+        weight[index(rope, point)] = pinned ? 0.0f : 1.0f;
+    }
+
+    bool isPinned(const size_t rope, const uint32_t point) const {
+        return weight[index(rope, point)] == 0.0f;
+    }
+
+    glm::vec2 getGravity() const { return gravity; }
+    void setGravity(const glm::vec2 g) { gravity = g; }
+
+    // Fraction of the speed kept every tick
+    float getDamping() const { return damping; }
+    void setDamping(const float value) { damping = std::clamp(value, 0.0f, 1.0f); }
+
+    int getIterations() const { return iterations; }
+    void setIterations(const int count) { iterations = std::max(1, count); }
+
+    const Stats & getStats() const { return stats; }
+
+    // Ropes collide with this room from now on, the geometry has to outlive the system or the next setRoom
+    void setRoom(RoomGeometry &new_room) {
+        room = &new_room;
+        tiles_room = nullptr;
+    }
+
+    void step() {
+        const auto start = std::chrono::steady_clock::now();
+
+        if (room) refreshTiles();
+
+        // Verlet, the speed is the distance moved last tick. Pinned points have weight 0 and stay put
+        run((x.size() + PointBatchSize - 1) / PointBatchSize, [this](const size_t batch) {
+            const size_t end = std::min(x.size(), (batch + 1) * PointBatchSize);
+            for (size_t i = batch * PointBatchSize; i < end; ++i) {
+                const float next_x = x[i] + ((x[i] - previous_x[i]) * damping + gravity.x) * weight[i];
+                const float next_y = y[i] + ((y[i] - previous_y[i]) * damping + gravity.y) * weight[i];
+                previous_x[i] = x[i];
+                previous_y[i] = y[i];
+                x[i] = next_x;
+                y[i] = next_y;
+            }
+        });
+
+        run((ropes.size() + RopeBatchSize - 1) / RopeBatchSize, [this](const size_t batch) {
+            const size_t end = std::min(ropes.size(), (batch + 1) * RopeBatchSize);
+            for (size_t r = batch * RopeBatchSize; r < end; ++r) {
+                for (int iteration = 0; iteration < iterations; ++iteration) {
+                    solveLengths(ropes[r], 0);
+                    solveLengths(ropes[r], 1);
+                    if (room) collide(ropes[r]);
+                }
+            }
+        });
+
+        ticks++;
+
+        const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        stats.last_ms = elapsed.count();
+        stats.average_ms = stats.average_ms * 0.95f + stats.last_ms * 0.05f;
+    }
+
+    uint64_t getTicks() const { return ticks; }
+
+    /**
+     * @brief Outlines every rope for drawing, two vertices per point, one on each side at the rope's radius.
+     * Consecutive pairs of a rope make a quad, see DrawPoller::make_strips
+     * @param vertices cleared and filled with the pairs of all ropes, rope after rope
+     * @param strips cleared and filled with the number of pairs of every rope
+     */
+    void outline(std::vector<glm::vec2> &vertices, std::vector<uint32_t> &strips) const {
+        vertices.clear();
+        strips.clear();
+        vertices.reserve(x.size() * 2);
+        strips.reserve(ropes.size());
+
+        for (const Rope &rope: ropes) {
+            for (uint32_t k = 0; k < rope.count; ++k) {
+                // Across the rope at a point is across the line between its neighbours
+                const size_t before = rope.first + (k > 0 ? k - 1 : k);
+                const size_t after = rope.first + (k + 1 < rope.count ? k + 1 : k);
+                const glm::vec2 along(x[after] - x[before], y[after] - y[before]);
+                const float length = glm::length(along);
+                const glm::vec2 across = length > 0.0f ? glm::vec2(-along.y, along.x) * (rope.radius / length) : glm::vec2(rope.radius, 0.0f);
+
+                const glm::vec2 point(x[rope.first + k], y[rope.first + k]);
+                vertices.push_back(point + across);
+                vertices.push_back(point - across);
+            }
+            strips.push_back(rope.count);
+        }
+    }
+
+private:
+    struct Rope {
+        uint32_t first; // Index of the first point in the arrays
+        uint32_t count;
+        float length;   // Of every segment
+        float radius;
+    };
+
+    std::vector<Rope> ropes;
+
+    // Every point of every rope
+    std::vector<float> x, y;
+    std::vector<float> previous_x, previous_y;
+    std::vector<float> weight; // 1 free, 0 pinned
+
+    glm::vec2 gravity = glm::vec2(0.0f, -0.5f);
+    float damping = 0.99f;
+    int iterations = 8;
+
+    RoomGeometry *room = nullptr;
+
+    // Solid or not for every tile of the room, rebuilt when the room or its revision changes
+    std::vector<uint8_t> solid_tiles;
+    int tiles_x = 0, tiles_y = 0;
+    const RoomGeometry *tiles_room = nullptr;
+    uint32_t tiles_revision = 0;
+
+    BatchRunner runner;
+    uint64_t ticks = 0;
+    Stats stats;
+
+    size_t index(const size_t rope, const uint32_t point) const {
+        const Rope &r = ropes.at(rope);
+        if (point >= r.count) throw std::out_of_range("Point outside of the rope.");
+        return r.first + point;
+    }
+
+    void run(const size_t count, const std::function<void(size_t)> &batch) {
+        if (runner) runner(count, batch);
+        else for (size_t i = 0; i < count; ++i) batch(i);
+    }
+
+    // Every other segment starting at parity, none of them share a point so the loop has no dependencies between steps
+    void solveLengths(const Rope &rope, const uint32_t parity) {
+        for (uint32_t s = rope.first + parity; s + 1 < rope.first + rope.count; s += 2) {
+            const float dx = x[s + 1] - x[s];
+            const float dy = y[s + 1] - y[s];
+            const float distance = std::sqrt(dx * dx + dy * dy);
+
+            // Both pinned or on top of each other gives 0, nothing moves
+            const float total = weight[s] + weight[s + 1];
+            const float error = distance > 0.0f && total > 0.0f ? (distance - rope.length) / (distance * total) : 0.0f;
+
+            x[s] += dx * error * weight[s];
+            y[s] += dy * error * weight[s];
+            x[s + 1] -= dx * error * weight[s + 1];
+            y[s + 1] -= dy * error * weight[s + 1];
+        }
+    }
+
+    void refreshTiles() {
+        if (tiles_room == room && tiles_revision == room->getRevision()) return;
+
+        tiles_x = room->getXSize();
+        tiles_y = room->getYSize();
+        solid_tiles.resize(static_cast<size_t>(tiles_x) * tiles_y);
+        for (int tile_y = 0; tile_y < tiles_y; ++tile_y) {
+            for (int tile_x = 0; tile_x < tiles_x; ++tile_x) {
+                solid_tiles[tile_y * tiles_x + tile_x] = room->getTileType(tile_x, tile_y) == 1;
+            }
+        }
+
+        tiles_room = room;
+        tiles_revision = room->getRevision();
+    }
+
+    // Tile a room coordinate falls in, rounding down. std::floor is a library call without SSE4.1 and this runs for every point
+    static int tileOf(const float value) {
+        const int tile = static_cast<int>(value * (1.0f / TileSize));
+        return value < static_cast<float>(tile) * TileSize ? tile - 1 : tile;
+    }
+
+    // Clamped like RoomGeometry::getTileType, the border tiles go on forever
+    bool solid(const int tile_x, const int tile_y) const {
+        return solid_tiles[std::clamp(tile_y, 0, tiles_y - 1) * tiles_x + std::clamp(tile_x, 0, tiles_x - 1)];
+    }
+
+    // Pushes every free point out of the solid tiles it's within radius of, along the shortest way out
+    void collide(const Rope &rope) {
+        for (size_t i = rope.first; i < rope.first + rope.count; ++i) {
+            if (weight[i] == 0.0f) continue;
+
+            glm::vec2 point(x[i], y[i]);
+
+            // Most points are well inside an air tile
+            const int cell_x = tileOf(point.x);
+            const int cell_y = tileOf(point.y);
+            const float inside_x = point.x - static_cast<float>(cell_x) * TileSize;
+            const float inside_y = point.y - static_cast<float>(cell_y) * TileSize;
+            if (inside_x > rope.radius && inside_x < TileSize - rope.radius && inside_y > rope.radius && inside_y < TileSize - rope.radius
+                && !solid(cell_x, cell_y)) continue;
+
+            const int min_x = tileOf(point.x - rope.radius);
+            const int max_x = tileOf(point.x + rope.radius);
+            const int min_y = tileOf(point.y - rope.radius);
+            const int max_y = tileOf(point.y + rope.radius);
+
+            for (int tile_y = min_y; tile_y <= max_y; ++tile_y) {
+                for (int tile_x = min_x; tile_x <= max_x; ++tile_x) {
+                    if (!solid(tile_x, tile_y)) continue;
+
+                    const glm::vec2 low(static_cast<float>(tile_x) * TileSize, static_cast<float>(tile_y) * TileSize);
+                    const glm::vec2 high = low + glm::vec2(TileSize);
+                    const glm::vec2 closest = glm::clamp(point, low, high);
+                    const glm::vec2 away = point - closest;
+                    const float distance = glm::length(away);
+
+                    if (distance >= rope.radius) continue;
+
+                    if (distance > 0.0f) {
+                        point = closest + away * (rope.radius / distance);
+                        continue;
+                    }
+
+                    // Inside the tile, out through the nearest side that isn't solid itself
+                    float best = INFINITY;
+                    glm::vec2 out = point;
+                    const auto consider = [&](const float depth, const int next_x, const int next_y, const glm::vec2 target) {
+                        if (depth < best && !solid(next_x, next_y)) {
+                            best = depth;
+                            out = target;
+                        }
+                    };
+                    consider(point.x - low.x, tile_x - 1, tile_y, glm::vec2(low.x - rope.radius, point.y));
+                    consider(high.x - point.x, tile_x + 1, tile_y, glm::vec2(high.x + rope.radius, point.y));
+                    consider(point.y - low.y, tile_x, tile_y - 1, glm::vec2(point.x, low.y - rope.radius));
+                    consider(high.y - point.y, tile_x, tile_y + 1, glm::vec2(point.x, high.y + rope.radius));
+                    point = out;
+                }
+            }
+
+            x[i] = point.x;
+            y[i] = point.y;
+        }
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+
+#include "custom.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Uniform grid over room pixels with one cell per tile (custom::getTilePos), hashed into a power of two bucket table.
+// Buckets are stored flat, sorted by a counting sort, so a rebuild is linear in the number of entries and a query
+// visits only the cells the queried circle can reach. Entries in a bucket keep their index order, queries are deterministic
+class SpatialHash {
+public:
+    SpatialHash() = default;
+
+    /**
+     * @brief Puts every circle into the cell of its centre, radii are only used to size queries.
+     * Does nothing when no circle left its cell since the last update
+     * @return whether the table was rebuilt
+     */
+    bool update(const std::vector<glm::vec2> &positions, const std::vector<float> &radii) {
+        max_radius = 0.0f;
+        for (const float radius: radii) max_radius = std::max(max_radius, radius);
+
+        bool moved = positions.size() != cells.size();
+        cells.resize(positions.size());
+        for (size_t i = 0; i < positions.size(); ++i) {
+            const glm::ivec2 cell = custom::getTilePos(positions[i]);
+            if (cell != cells[i]) {
+                cells[i] = cell;
+                moved = true;
+            }
+        }
+
+        if (!moved) return false;
+
+        rebuild();
+        return true;
+    }
+
+    /**
+     * @brief Calls fn(j) for every circle j whose cell can hold a circle overlapping the given one, j included if it's in the table.
+     * The caller does the exact test
+     */
+    template<typename Fn>
+    void query(const glm::vec2 pos, const float radius, Fn &&fn) const {
+        if (starts.empty()) return;
+
+        const float reach = radius + max_radius;
+        const glm::ivec2 min = custom::getTilePos(pos - glm::vec2(reach));
+        const glm::ivec2 max = custom::getTilePos(pos + glm::vec2(reach));
+
+        for (int y = min.y; y <= max.y; ++y) {
+            for (int x = min.x; x <= max.x; ++x) {
+                const size_t bucket = hash(x, y);
+                for (uint32_t e = starts[bucket]; e < starts[bucket + 1]; ++e) {
+                    // Other cells can share the bucket, they're visited when their own cell comes up
+                    const uint32_t index = entries[e];
+                    if (cells[index].x == x && cells[index].y == y) fn(static_cast<size_t>(index));
+                }
+            }
+        }
+    }
+
+    size_t getCount() const { return cells.size(); }
+    size_t getBucketCount() const { return starts.empty() ? 0 : starts.size() - 1; }
+    uint64_t getRebuilds() const { return rebuilds; }
+
+private:
+    std::vector<glm::ivec2> cells; // Cell of every entry, by entry index
+    std::vector<uint32_t> starts;  // entries[starts[b], starts[b + 1]) are in bucket b
+    std::vector<uint32_t> entries;
+
+    // Kept between rebuilds so they don't allocate every tick
+    std::vector<uint32_t> bucket_of;
+    std::vector<uint32_t> cursor;
+
+    size_t mask = 0; // Buckets - 1
+    float max_radius = 0.0f;
+    uint64_t rebuilds = 0;
+
+    size_t hash(const int x, const int y) const {
+        const uint32_t h = static_cast<uint32_t>(x) * 73856093u ^ static_cast<uint32_t>(y) * 19349663u;
+        return h & mask;
+    }
+
+    void rebuild() {
+        // At least twice as many buckets as entries keeps unrelated cells from sharing them
+        size_t table = 64;
+        while (table < cells.size() * 2) table *= 2;
+        mask = table - 1;
+        starts.assign(table + 1, 0);
+        entries.resize(cells.size());
+        bucket_of.resize(cells.size());
+
+        for (size_t i = 0; i < cells.size(); ++i) {
+            bucket_of[i] = static_cast<uint32_t>(hash(cells[i].x, cells[i].y));
+            starts[bucket_of[i] + 1]++;
+        }
+
+        for (size_t b = 0; b < table; ++b) starts[b + 1] += starts[b];
+
+        // Filled in index order, so entries stay in index order inside every bucket
+        cursor.assign(starts.begin(), starts.end() - 1);
+        for (size_t i = 0; i < cells.size(); ++i) entries[cursor[bucket_of[i]]++] = static_cast<uint32_t>(i);
+
+        rebuilds++;
+    }
+};
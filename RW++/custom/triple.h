@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Hands values from one writer thread to one reader thread without locks or waiting.
+// The writer fills back() and publishes it, the reader picks up the newest published value with update() and reads front().
+// Neither ever sees the other's slot, the third slot is the one in between. Values the reader missed are skipped, and slots are
+// reused, so the writer has to overwrite all of back() before publishing it
+template<typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    // Writer only
+    T & back() {
+        return slots[back_index];
+    }
+
+    // Writer only, back() becomes the newest value and the writer gets another slot to fill
+    void publish() {
+        back_index = middle.exchange(static_cast<uint8_t>(back_index | Fresh), std::memory_order_acq_rel) & IndexMask;
+    }
+
+    // Reader only, moves front() to the newest published value. Whether there was one the reader hadn't seen
+    bool update() {
+        if (!(middle.load(std::memory_order_relaxed) & Fresh)) return false;
+
+        front_index = middle.exchange(front_index, std::memory_order_acq_rel) & IndexMask;
+        return true;
+    }
+
+    // Reader only
+    const T & front() const {
+        return slots[front_index];
+    }
+
+private:
+    static constexpr uint8_t IndexMask = 3;
+    static constexpr uint8_t Fresh = 4; // Set by publish, cleared by update
+
+    std::array<T, 3> slots {};
+
+    uint8_t back_index = 0;
+    std::atomic<uint8_t> middle { 1 };
+    uint8_t front_index = 2;
+};
@@ -7,27 +7,26 @@ class SceneDebugGeo {
     bool displaying = false;
 
 public:
-    explicit SceneDebugGeo(const RoomGeometry& roomGeo, glm::vec2 offset) {
-        // Get tiles and cache them
+    explicit SceneDebugGeo(const RoomGeometry& roomGeo) {
+        // Get tiles and cache them, bottom left corners in room pixels
         int x_size = roomGeo.getXSize();
         int y_size = roomGeo.getYSize();
 
-        offset.x = -offset.x;
-        offset.y = offset.y;
-
         for (int y = 0; y < y_size; ++y) {
             for (int x = 0; x < x_size; ++x) {
                 if (roomGeo.getTileType(x, y) == 1) {
-                    positions.push_back(glm::vec2(x * 20.0f, 760 - y * 20.0f) + offset);
+                    positions.push_back(glm::vec2(x * 20.0f, y * 20.0f));
                 }
             }
         }
     }
 
-    void frame_update() {
+    // offset: room to screen pixels of the shown camera, see SceneCamera
+    void frame_update(const glm::vec2 offset) {
         if (displaying) {
             const auto dl = ImGui::GetBackgroundDrawList();
-            for (const auto pos: positions) {
+            for (const auto tile: positions) {
+                const glm::vec2 pos(tile.x + offset.x, 800 - (tile.y + offset.y));
                 dl->AddRect(ImVec2(pos.x, pos.y), ImVec2(pos.x + 20, pos.y - 20), ImGui::GetColorU32(ImVec4(1, 1, 1, 1)), 0, 0, 2);
             }
         }
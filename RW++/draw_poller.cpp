@@ -1,5 +1,7 @@
 ﻿#include "rendering.h"
 
+#include <span>
+#include <stdexcept>
 #include <vector>
 
 void DrawPoller::reset() {
@@ -11,46 +13,30 @@ void DrawPoller::make_custom(const RenderDescription &desc) {
 }
 
 template<typename T>
-void DrawPoller::make_sprite(const glm::vec2 pos, const glm::vec2 size, const float depth, const float scale, const VkDescriptorSet scene_set, const VkDescriptorSet object_set, std::shared_ptr<T> uniform) {
-    const float half_w = (size.x / 2) * scale;
-    const float half_h = (size.y / 2) * scale;
-
-    constexpr glm::vec4 white{1};
-
-    const glm::vec3 top_right{pos.x + half_w, pos.y + half_h, depth};
-    const glm::vec3 top_left{pos.x - half_w, pos.y + half_h, depth};
-    const glm::vec3 bottom_left{pos.x - half_w, pos.y - half_h, depth};
-    const glm::vec3 bottom_right{pos.x + half_w, pos.y - half_h, depth};
+void DrawPoller::make_sprite(const glm::vec2 pos, const glm::vec2 size, const float depth, const float scale, const VkDescriptorSet scene_set, const VkDescriptorSet object_set, std::shared_ptr<T> uniform, const uint32_t texture) {
+    const uint32_t uniform_size = uniform ? sizeof(T) : 0;
+    Descriptions.push_back(sprite_description(pos, size, depth, scale, scene_set, object_set, glm::vec2(0), glm::vec2(1), UVOrigin::Top, texture, std::move(uniform), uniform_size));
+}
 
-    std::vector vertices = {
-        Vertex(top_right, {1, 0}, white),
-        Vertex(top_left, {0, 0}, white),
-        Vertex(bottom_left, {0, 1}, white),
-        Vertex(bottom_right, {1, 1}, white),
-    };
+void DrawPoller::make_sprite(const glm::vec2 pos, const glm::vec2 size, const float depth, const float scale, const VkDescriptorSet scene_set, const VkDescriptorSet object_set, const uint32_t texture, const UVOrigin origin) {
+    Descriptions.push_back(sprite_description(pos, size, depth, scale, scene_set, object_set, glm::vec2(0), glm::vec2(1), origin, texture, nullptr, 0));
+}
 
-    std::vector<uint16_t> indices = {
-        0,
-        1,
-        2,
-        3,
-        0,
-        2,
-    };
+void DrawPoller::make_sprite(const glm::vec2 pos, const float depth, const float scale, const VkDescriptorSet scene_set, const VkDescriptorSet object_set, const AtlasRegion &region) {
+    Descriptions.push_back(sprite_description(pos, region.size, depth, scale, scene_set, object_set, region.uv_min, region.uv_max, UVOrigin::Top, region.texture, nullptr, 0));
+}
 
-    RenderDescription desc{
-        .mesh_vertices = vertices,
-        .mesh_indices = indices,
-        .scene_set = scene_set,
-        .object_set = object_set,
-        .uniform = uniform,
-        .uniform_size = sizeof(T),
-    };
+template<typename T>
+RenderDescription DrawPoller::cache_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, std::shared_ptr<T> uniform, const uint32_t texture) {
+    const uint32_t uniform_size = uniform ? sizeof(T) : 0;
+    return sprite_description(pos, size, depth, scale, scene_set, object_set, glm::vec2(0), glm::vec2(1), UVOrigin::Top, texture, std::move(uniform), uniform_size);
+}
 
-    Descriptions.push_back(std::move(desc));
+RenderDescription DrawPoller::cache_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, const uint32_t texture, const UVOrigin origin) {
+    return sprite_description(pos, size, depth, scale, scene_set, object_set, glm::vec2(0), glm::vec2(1), origin, texture, nullptr, 0);
 }
 
-void DrawPoller::make_sprite(const glm::vec2 pos, const glm::vec2 size, const float depth, const float scale, const VkDescriptorSet scene_set, const VkDescriptorSet object_set) {
+RenderDescription DrawPoller::sprite_description(const glm::vec2 pos, const glm::vec2 size, const float depth, const float scale, const VkDescriptorSet scene_set, const VkDescriptorSet object_set, const glm::vec2 uv_min, const glm::vec2 uv_max, const UVOrigin origin, const uint32_t texture, std::shared_ptr<void> uniform, const uint32_t uniform_size) {
     const float half_w = (size.x / 2) * scale;
     const float half_h = (size.y / 2) * scale;
 
@@ -61,11 +47,14 @@ void DrawPoller::make_sprite(const glm::vec2 pos, const glm::vec2 size, const fl
     const glm::vec3 bottom_left{pos.x - half_w, pos.y - half_h, depth};
     const glm::vec3 bottom_right{pos.x + half_w, pos.y - half_h, depth};
 
+    const float top_v = origin == UVOrigin::Top ? uv_min.y : uv_max.y;
+    const float bottom_v = origin == UVOrigin::Top ? uv_max.y : uv_min.y;
+
     std::vector vertices = {
-        Vertex(top_right, {1, 1}, white),
-        Vertex(top_left, {0, 1}, white),
-        Vertex(bottom_left, {0, 0}, white),
-        Vertex(bottom_right, {1, 0}, white),
+        Vertex(top_right, {uv_max.x, top_v}, white, texture),
+        Vertex(top_left, {uv_min.x, top_v}, white, texture),
+        Vertex(bottom_left, {uv_min.x, bottom_v}, white, texture),
+        Vertex(bottom_right, {uv_max.x, bottom_v}, white, texture),
     };
 
     std::vector<uint16_t> indices = {
@@ -77,89 +66,68 @@ void DrawPoller::make_sprite(const glm::vec2 pos, const glm::vec2 size, const fl
         2,
     };
 
-    RenderDescription desc{
+    return RenderDescription {
         .mesh_vertices = vertices,
         .mesh_indices = indices,
         .scene_set = scene_set,
         .object_set = object_set,
-        .uniform = nullptr,
-        .uniform_size = 0,
+        .uniform = std::move(uniform),
+        .uniform_size = uniform_size,
     };
-
-    Descriptions.push_back(std::move(desc));
 }
 
-template<typename T>
-RenderDescription DrawPoller::cache_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, std::shared_ptr<T> uniform) {
-    const float half_w = (size.x / 2) * scale;
-    const float half_h = (size.y / 2) * scale;
+void DrawPoller::make_strips(const std::span<const glm::vec2> outline, const std::span<const uint32_t> strips, const glm::vec2 offset, const float depth, const glm::vec4 color, const VkDescriptorSet scene_set, const VkDescriptorSet object_set, const AtlasRegion &region) {
+    constexpr size_t max_vertices = MaxUploadBytes / sizeof(Vertex);
 
-    constexpr glm::vec4 white{1};
+    size_t pair_count = 0;
+    for (const uint32_t pairs: strips) pair_count += pairs;
+    if (pair_count * 2 != outline.size()) throw std::invalid_argument("Strips don't cover the outline.");
 
-    const glm::vec3 top_right{pos.x + half_w, pos.y + half_h, depth};
-    const glm::vec3 top_left{pos.x - half_w, pos.y + half_h, depth};
-    const glm::vec3 bottom_left{pos.x - half_w, pos.y - half_h, depth};
-    const glm::vec3 bottom_right{pos.x + half_w, pos.y - half_h, depth};
+    const glm::vec2 uv = (region.uv_min + region.uv_max) * 0.5f;
 
-    std::vector vertices = {
-        Vertex(top_right, {1, 0}, white),
-        Vertex(top_left, {0, 0}, white),
-        Vertex(bottom_left, {0, 1}, white),
-        Vertex(bottom_right, {1, 1}, white),
-    };
-
-    std::vector<uint16_t> indices = {
-        0,
-        1,
-        2,
-        3,
-        0,
-        2,
-    };
-
-    return RenderDescription {
-        .mesh_vertices = vertices,
-        .mesh_indices = indices,
+    RenderDescription desc{
         .scene_set = scene_set,
         .object_set = object_set,
-        .uniform = uniform,
-        .uniform_size = sizeof(T),
+        .uniform = nullptr,
+        .uniform_size = 0,
     };
-}
-
-RenderDescription DrawPoller::cache_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set) {
-    const float half_w = (size.x / 2) * scale;
-    const float half_h = (size.y / 2) * scale;
-
-    constexpr glm::vec4 white{1};
-
-    const glm::vec3 top_right{pos.x + half_w, pos.y + half_h, depth};
-    const glm::vec3 top_left{pos.x - half_w, pos.y + half_h, depth};
-    const glm::vec3 bottom_left{pos.x - half_w, pos.y - half_h, depth};
-    const glm::vec3 bottom_right{pos.x + half_w, pos.y - half_h, depth};
 
-    std::vector vertices = {
-        Vertex(top_right, {1, 1}, white),
-        Vertex(top_left, {0, 1}, white),
-        Vertex(bottom_left, {0, 0}, white),
-        Vertex(bottom_right, {1, 0}, white),
+    const auto flush = [&] {
+        if (!desc.mesh_indices.empty()) Descriptions.push_back(desc);
+        desc.mesh_vertices.clear();
+        desc.mesh_indices.clear();
     };
 
-    std::vector<uint16_t> indices = {
-        0,
-        1,
-        2,
-        3,
-        0,
-        2,
+    const auto push_pair = [&](const size_t pair) {
+        desc.mesh_vertices.push_back(Vertex(glm::vec3(outline[pair * 2] + offset, depth), uv, color, region.texture));
+        desc.mesh_vertices.push_back(Vertex(glm::vec3(outline[pair * 2 + 1] + offset, depth), uv, color, region.texture));
     };
 
-    return RenderDescription {
-        .mesh_vertices = vertices,
-        .mesh_indices = indices,
-        .scene_set = scene_set,
-        .object_set = object_set,
-        .uniform = nullptr,
-        .uniform_size = 0,
-    };
+    size_t first = 0;
+    for (const uint32_t pairs: strips) {
+        for (uint32_t p = 0; p < pairs; ++p) {
+            if (desc.mesh_vertices.size() + 2 > max_vertices) {
+                flush();
+
+                // The strip carries on from its last pair
+                if (p > 0) push_pair(first + p - 1);
+            }
+
+            push_pair(first + p);
+            if (p == 0) continue;
+
+            const auto base = static_cast<uint16_t>(desc.mesh_vertices.size() - 4);
+            desc.mesh_indices.insert(desc.mesh_indices.end(), {
+                base,
+                static_cast<uint16_t>(base + 1),
+                static_cast<uint16_t>(base + 2),
+                static_cast<uint16_t>(base + 1),
+                static_cast<uint16_t>(base + 3),
+                static_cast<uint16_t>(base + 2),
+            });
+        }
+        first += pairs;
+    }
+
+    flush();
 }
@@ -0,0 +1,230 @@
+#include "jobs.h"
+
+#include <algorithm>
+
+namespace jobs {
+
+namespace {
+
+// Which pool and worker the calling thread belongs to, workers push their own work onto their own deque
+thread_local const JobSystem *current_system = nullptr;
+thread_local int current_worker = -1;
+
+}
+
+JobSystem::JobSystem(unsigned worker_count) {
+    if (worker_count == 0) worker_count = std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 1;
+
+    for (unsigned i = 0; i <= worker_count; ++i) queues.push_back(std::make_unique<Queue>());
+
+    workers.reserve(worker_count);
+    for (unsigned i = 0; i < worker_count; ++i) workers.emplace_back(&JobSystem::worker_loop, this, static_cast<int>(i));
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard lock(sleep_lock);
+        stopping = true;
+    }
+    wake.notify_all();
+
+    for (auto &worker: workers) worker.join();
+}
+
+JobSystem & JobSystem::shared() {
+    static JobSystem system;
+    return system;
+}
+
+void JobSystem::schedule(JobPtr job) {
+    const bool background_job = job->background;
+    const bool own = current_system == this && current_worker >= 0;
+    Queue &queue = background_job ? background : own ? *queues[current_worker] : *queues.back();
+
+    {
+        std::lock_guard lock(queue.lock);
+        queue.jobs.push_back(std::move(job));
+    }
+
+    // Counted under the sleep lock so a worker can't check, miss it and then sleep through the notify
+    {
+        std::lock_guard lock(sleep_lock);
+        ++(background_job ? background_queued : queued);
+    }
+    wake.notify_one();
+
+    // Sleeping waiters may help with it, background work isn't theirs to run
+    if (!background_job && waiters > 0) finished.notify_all();
+}
+
+JobPtr JobSystem::take(const int worker, const bool take_background) {
+    const auto pop = [&](Queue &queue, const bool back, std::atomic<int> &count) -> JobPtr {
+        std::lock_guard lock(queue.lock);
+        if (queue.jobs.empty()) return nullptr;
+
+        JobPtr job;
+        if (back) {
+            job = std::move(queue.jobs.back());
+            queue.jobs.pop_back();
+        }
+        else {
+            job = std::move(queue.jobs.front());
+            queue.jobs.pop_front();
+        }
+
+        --count;
+        return job;
+    };
+
+    // Newest of our own first while it's still in cache, then outside submissions, then steal the oldest of the others
+    if (worker >= 0) {
+        if (JobPtr job = pop(*queues[worker], true, queued)) return job;
+    }
+
+    if (JobPtr job = pop(*queues.back(), false, queued)) return job;
+
+    // queues is complete before the first worker starts, workers is still growing then
+    const int count = static_cast<int>(queues.size()) - 1;
+    for (int i = 1; i <= count; ++i) {
+        const int victim = (std::max(worker, 0) + i) % count;
+        if (victim == worker) continue;
+
+        if (JobPtr job = pop(*queues[victim], false, queued)) return job;
+    }
+
+    // Background work last, and only when nothing else is
+    if (take_background) return pop(background, false, background_queued);
+
+    return nullptr;
+}
+
+void JobSystem::run(const JobPtr &job, const int worker) {
+    const auto start = std::chrono::steady_clock::now();
+
+    try {
+        job->fn();
+    } catch (...) {
+        job->error = std::current_exception();
+    }
+
+    if (profiler) profiler(JobSample { job->name, worker, start, std::chrono::steady_clock::now() });
+
+    std::vector<JobPtr> continuations;
+    {
+        std::lock_guard lock(job->continuation_lock);
+        job->done.store(true); // Sequentially consistent with waiters, see wait
+        continuations.swap(job->continuations);
+    }
+
+    // Taking the sleep lock orders this after a waiter's check of done or before it, it can't sleep through the notify
+    if (waiters > 0) {
+        { std::lock_guard lock(sleep_lock); }
+        finished.notify_all();
+    }
+
+    job->fn = nullptr; // Drops whatever the job captured
+
+    for (JobPtr &next: continuations) {
+        if (--next->pending == 0) schedule(std::move(next));
+    }
+}
+
+void JobSystem::worker_loop(const int worker) {
+    current_system = this;
+    current_worker = worker;
+
+    while (true) {
+        if (const JobPtr job = take(worker, true)) {
+            run(job, worker);
+            continue;
+        }
+
+        std::unique_lock lock(sleep_lock);
+        wake.wait(lock, [&] { return queued > 0 || background_queued > 0 || stopping; });
+        if (stopping && queued == 0 && background_queued == 0) return;
+    }
+}
+
+JobPtr JobSystem::submit(const char *name, std::function<void()> fn, const std::initializer_list<JobPtr> dependencies) {
+    return submit(name, std::move(fn), std::vector<JobPtr>(dependencies));
+}
+
+JobPtr JobSystem::submit(const char *name, std::function<void()> fn, const std::vector<JobPtr> &dependencies) {
+    return make_job(name, std::move(fn), dependencies, false);
+}
+
+JobPtr JobSystem::submit_background(const char *name, std::function<void()> fn) {
+    return make_job(name, std::move(fn), {}, true);
+}
+
+JobPtr JobSystem::make_job(const char *name, std::function<void()> fn, const std::vector<JobPtr> &dependencies, const bool background) {
+    auto job = std::make_shared<Job>(name, std::move(fn));
+    job->background = background;
+
+    for (const JobPtr &dependency: dependencies) {
+        if (dependency == nullptr) continue;
+
+        std::lock_guard lock(dependency->continuation_lock);
+        if (dependency->is_done()) continue;
+
+        ++job->pending;
+        dependency->continuations.push_back(job);
+    }
+
+    if (--job->pending == 0) schedule(job);
+    return job;
+}
+
+void JobSystem::wait(const JobPtr &job) {
+    const int worker = current_system == this ? current_worker : -1;
+
+    int idle = 0;
+    while (!job->is_done()) {
+        if (const JobPtr other = take(worker, false)) {
+            run(other, worker);
+            idle = 0;
+            continue;
+        }
+
+        // Whatever's left is running elsewhere, usually done in a moment
+        if (++idle < SpinLimit) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        // Counted before done is checked again, so run either sees us or we see done
+        std::unique_lock lock(sleep_lock);
+        ++waiters;
+        finished.wait(lock, [&] { return job->done.load() || queued > 0; });
+        --waiters;
+        idle = 0;
+    }
+
+    if (job->error) std::rethrow_exception(job->error);
+}
+
+void JobSystem::parallel_for(const size_t begin, const size_t end, size_t grain, const std::function<void(size_t, size_t)> &fn) {
+    if (end <= begin) return;
+    grain = std::max<size_t>(grain, 1);
+
+    std::vector<JobPtr> chunks;
+    chunks.reserve((end - begin + grain - 1) / grain);
+    for (size_t chunk = begin; chunk < end; chunk += grain) {
+        const size_t chunk_end = std::min(chunk + grain, end);
+        chunks.push_back(submit("parallel_for", [&fn, chunk, chunk_end] { fn(chunk, chunk_end); }));
+    }
+
+    // Every chunk is waited on before rethrowing, fn is captured by reference
+    std::exception_ptr error;
+    for (const JobPtr &chunk: chunks) {
+        try {
+            wait(chunk);
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+
+    if (error) std::rethrow_exception(error);
+}
+
+}
@@ -0,0 +1,144 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <future>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Work stealing thread pool shared by every subsystem that wants to go wide.
+// Each worker owns a deque, pushes and pops its own work at the back and steals from the front of the others.
+// Threads that aren't workers submit into one more deque that everyone takes from.
+// Background jobs (decodes, loads) get a deque of their own that only idle workers take from, never a thread helping in wait
+namespace jobs {
+
+class JobSystem;
+
+// A submitted job. Jobs that depend on it are scheduled once it finished
+class Job {
+    friend class JobSystem;
+
+    const char *name;
+    std::function<void()> fn;
+    bool background = false;
+
+    std::atomic<int> pending { 1 }; // Unfinished dependencies, plus one until submit is done wiring them
+    std::atomic<bool> done { false };
+    std::exception_ptr error;
+
+    std::mutex continuation_lock;
+    std::vector<std::shared_ptr<Job>> continuations;
+
+public:
+    Job(const char *name, std::function<void()> fn) : name(name), fn(std::move(fn)) {}
+
+    const char * get_name() const { return name; }
+    bool is_done() const { return done.load(std::memory_order_acquire); }
+};
+
+typedef std::shared_ptr<Job> JobPtr;
+
+// What the profiling hook gets after every job, on the thread that ran it
+struct JobSample {
+    const char *name;
+    int worker; // -1 for threads that aren't workers, e.g. the main thread helping in wait
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+};
+
+class JobSystem {
+    struct Queue {
+        std::mutex lock;
+        std::deque<JobPtr> jobs;
+    };
+
+    // Yields in wait before it sleeps until the job finished or there's work to help with
+    static constexpr int SpinLimit = 64;
+
+    std::vector<std::unique_ptr<Queue>> queues; // One per worker, the last one for everyone else
+    Queue background;
+    std::vector<std::thread> workers;
+
+    std::mutex sleep_lock;
+    std::condition_variable wake;     // Idle workers
+    std::condition_variable finished; // Threads sleeping in wait
+    std::atomic<int> queued { 0 };    // Jobs in queues
+    std::atomic<int> background_queued { 0 };
+    std::atomic<int> waiters { 0 };
+    std::atomic<bool> stopping { false };
+
+    std::function<void(const JobSample&)> profiler;
+
+    JobPtr make_job(const char *name, std::function<void()> fn, const std::vector<JobPtr> &dependencies, bool background);
+    void schedule(JobPtr job);
+    JobPtr take(int worker, bool take_background);
+    void run(const JobPtr &job, int worker);
+    void worker_loop(int worker);
+
+public:
+    /**
+     * @param worker_count threads to start, 0 for one less than the hardware has so the main thread keeps a core.
+     * There's always at least one worker
+     */
+    explicit JobSystem(unsigned worker_count = 0);
+
+    // Finishes the queued jobs and joins the workers
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    // Process wide pool with the default worker count, started on first use
+    static JobSystem & shared();
+
+    unsigned worker_count() const { return static_cast<unsigned>(queues.size() - 1); }
+
+    /**
+     * @brief Queues a job, it runs once all of its dependencies have finished
+     * @param name shown to the profiler, must outlive the job
+     */
+    JobPtr submit(const char *name, std::function<void()> fn, std::initializer_list<JobPtr> dependencies = {});
+    JobPtr submit(const char *name, std::function<void()> fn, const std::vector<JobPtr> &dependencies);
+
+    /**
+     * @brief Queues a job that only runs on otherwise idle workers, for long work nobody waits on within a frame or tick
+     * @param name shown to the profiler, must outlive the job
+     */
+    JobPtr submit_background(const char *name, std::function<void()> fn);
+
+    /**
+     * @brief Runs other jobs on the calling thread until the job finished, background jobs excepted.
+     * Sleeps once there's nothing left to help with for a while
+     * @throws whatever the job threw
+     */
+    void wait(const JobPtr &job);
+
+    /**
+     * @brief Splits [begin, end) into chunks of at most grain indices and calls fn(chunk_begin, chunk_end) for each.
+     * Returns once every chunk ran, the calling thread helps
+     */
+    void parallel_for(size_t begin, size_t end, size_t grain, const std::function<void(size_t, size_t)> &fn);
+
+    // Runs fn as a background job and returns its result through a future, for work that's polled rather than waited on
+    template<typename Fn>
+    std::future<std::invoke_result_t<Fn>> async(const char *name, Fn fn) {
+        auto task = std::make_shared<std::packaged_task<std::invoke_result_t<Fn>()>>(std::move(fn));
+        auto future = task->get_future();
+        submit_background(name, [task] { (*task)(); });
+        return future;
+    }
+
+    // Called after every job from the thread that ran it, set it before submitting anything
+    void set_profiler(std::function<void(const JobSample&)> hook) { profiler = std::move(hook); }
+};
+
+}
@@ -1,28 +1,391 @@
 ﻿#pragma once
 
+#include "custom/cameras.h"
+#include "custom/descriptor.h"
+#include "jobs.h"
+
+#include <chrono>
+#include <future>
+
 class SceneLevel final : public SceneObject_T {
+    // Shipped palettes, layer i of the palette array is PalettePaths[i]
+    static constexpr const char *PalettePaths[] = {
+        "assets/palettes/palette0.png",
+        "assets/palettes/palette1.png",
+        "assets/palettes/palette11.png",
+        "assets/palettes/palette12.png",
+        "assets/palettes/palette13.png",
+    };
+    static constexpr const char *PaletteNames[] = { "palette0", "palette1", "palette11", "palette12", "palette13" };
+
     std::shared_ptr<Scene> scene;
 
     TexturePtr level_image;
     TexturePtr palette_image;
     TexturePtr noise_image;
 
+    RoomDescriptor room;
+    RoomCameras cameras;
+    std::string level_directory;
+
+    // Camera images, the current one plus the neighbours the camera target may reach soon.
+    // Neighbours are decoded on background threads and uploaded from frame_update
+    static constexpr float PrefetchTicks = 40;   // How far ahead the target's movement is extrapolated
+    static constexpr float PrefetchRadius = 200; // Views the target is this close to get prefetched too
+    std::vector<TexturePtr> camera_images;
+    std::vector<std::future<DecodedImage>> decoding;
+    std::vector<bool> rejected;   // Images that changed size on disk since the room was loaded, never shown
+    uint32_t prefetch_misses = 0; // Switches that had to wait for their image
+
+    // Level uniforms shared by both renderers, rewritten in frame_update only when something changed
+    libgui::PersistentUniform<UniformLevelInfo> uniforms;
+
+    int palette_a = 0;
+    int palette_b = 0;
+    float palette_blend = 0;
+
+    // The raster, bake and compute sets are allocated from Scene::FrameDescriptors every time they're used
     VkDescriptorSetLayout set_layout;
-    VkDescriptorSet set;
     LeasedPipeline pipeline;
 
+    // Static per pixel terms of the level, see shaders/include/level_gbuffer.glsl
+    static constexpr uint32_t GBufferLayers = 6; // GBUF_LAYERS
+    libgui::VkAllocatedImage gbuffer {};
+    VkDescriptorSetLayout bake_layout;
+    libgui::VkCompletePipeline bake_pipeline;
+    PushLevelBake baked { -1, -1 }; // Palettes the G-buffer was last baked with
+
+    // Compute renderer, writes DrawImage directly and copies its depth into DrawDepth
+    bool use_compute = false;
+    libgui::VkAllocatedImage compute_depth {};   // R16, storage images can't be depth formats
+    libgui::VkSizedBuffer compute_depth_copy {}; // R16 -> D16 goes through a buffer
+    VkDescriptorSetLayout compute_layout;
+
+    // Screen tiles sorted by the shader branches they need, see shaders/include/level_tiles.glsl
+    static constexpr uint32_t TileSize = 8;
+    static constexpr uint32_t TileClasses = 4; // sky, solid, mixed, decal
+    uint32_t tiles_x = 0, tiles_y = 0;
+    libgui::VkSizedBuffer tile_lists {};
+    VkDescriptorSetLayout classify_layout;
+    VkDescriptorSet classify_set;
+    libgui::VkCompletePipeline classify_pipeline;
+
+    // One level.comp permutation per tile class, built for the room's swarm and wet terrain settings
+    std::array<libgui::VkCompletePipeline, TileClasses> compute_pipelines {};
+    bool permutations_swarm = false;
+    bool permutations_wet = false;
+
+    // Rebuilds the level.comp permutations, the GPU must be idle
+    void build_permutations(const bool swarm, const bool wet) {
+        if (compute_pipelines[0].pipeline != VK_NULL_HANDLE)
+            for (auto &compute_pipeline : compute_pipelines) compute_pipeline.dispose();
+
+        struct {
+            VkBool32 sky, solid, decals, swarm, wet;
+            uint32_t tile_class, tile_stride;
+        } constants {};
+
+        static constexpr VkSpecializationMapEntry entries[] = {
+            { 0, 0,  sizeof(VkBool32) },
+            { 1, 4,  sizeof(VkBool32) },
+            { 2, 8,  sizeof(VkBool32) },
+            { 3, 12, sizeof(VkBool32) },
+            { 4, 16, sizeof(VkBool32) },
+            { 5, 20, sizeof(uint32_t) },
+            { 6, 24, sizeof(uint32_t) },
+        };
+
+        const VkSpecializationInfo specialization {
+            .mapEntryCount = std::size(entries),
+            .pMapEntries = entries,
+            .dataSize = sizeof(constants),
+            .pData = &constants,
+        };
+
+        VkShaderModule level_comp;
+        VK_ASSERT( libgui::vulkan_create_shader_from_file(scene->GPU, &level_comp, "shaders/level.comp.spv") );
+
+        for (uint32_t tile_class = 0; tile_class < TileClasses; ++tile_class) {
+            // Sky tiles are never displaced or swarmed, everything else only loses what it can't contain
+            const bool sky_only = tile_class == 0;
+            constants = {
+                .sky = tile_class != 1,
+                .solid = !sky_only,
+                .decals = tile_class == 3,
+                .swarm = swarm && tile_class >= 2,
+                .wet = wet && !sky_only,
+                .tile_class = tile_class,
+                .tile_stride = tiles_x * tiles_y,
+            };
+
+            compute_pipelines[tile_class] = libgui::create_compute_pipeline(scene->GPU, level_comp, { compute_layout }, 0, &specialization);
+        }
+
+        vkDestroyShaderModule(scene->GPU, level_comp, nullptr);
+
+        permutations_swarm = swarm;
+        permutations_wet = wet;
+    }
+
+    // Rebuilds the G-buffer, only needed when the level or the palettes change. Blending between them is left to the renderers
+    void bake() {
+        const PushLevelBake push { palette_a, palette_b };
+
+        // The immediate submit is waited for before this returns, long before the ring comes back to this frame
+        const VkDescriptorSet bake_set = scene->FrameDescriptors.allocate(scene->GPU, bake_layout);
+        libgui::DescriptorLayoutHelper()
+            .image(0, level_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+            .image(1, palette_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+            .image(2, gbuffer.view, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+            .update_set(scene->GPU, bake_set);
+
+        libgui::cmd_immediate(scene->ImmediateCmd, [&] {
+            const VkCommandBuffer cmd = scene->ImmediateCmd.cmd;
+
+            libgui::change_image_layout(cmd, gbuffer.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, bake_pipeline.pipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, bake_pipeline.layout, 0, 1, &bake_set, 0, nullptr);
+            vkCmdPushConstants(cmd, bake_pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushLevelBake), &push);
+            vkCmdDispatch(cmd, (gbuffer.width + 7) / 8, (gbuffer.height + 7) / 8, 1);
+
+            libgui::change_image_layout(cmd, gbuffer.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+
+            // The tile classes only depend on the G-buffer, sort them here instead of every frame
+            uint32_t reset[TileClasses * 4];
+            for (uint32_t i = 0; i < std::size(reset); ++i) reset[i] = i % 4 == 0 ? 0 : 1;
+            vkCmdUpdateBuffer(cmd, tile_lists.buffer, 0, sizeof(reset), reset);
+            libgui::buffer_barrier(cmd, tile_lists, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT);
+
+            const PushLevelClassify classify { glm::ivec2(scene->DrawImage.width, scene->DrawImage.height), tiles_x * tiles_y };
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, classify_pipeline.pipeline);
+            vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, classify_pipeline.layout, 0, 1, &classify_set, 0, nullptr);
+            vkCmdPushConstants(cmd, classify_pipeline.layout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(PushLevelClassify), &classify);
+            vkCmdDispatch(cmd, (tiles_x + 7) / 8, (tiles_y + 7) / 8, 1);
+
+            libgui::buffer_barrier(cmd, tile_lists, VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_STORAGE_WRITE_BIT, VK_PIPELINE_STAGE_2_DRAW_INDIRECT_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_INDIRECT_COMMAND_READ_BIT | VK_ACCESS_2_SHADER_STORAGE_READ_BIT);
+        });
+
+        baked = push;
+    }
+
+    void draw_compute(const VkCommandBuffer cmd, const VkDescriptorSet compute_set) const {
+        libgui::change_image_layout(cmd, compute_depth.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_GENERAL);
+
+        // Every tile is in exactly one class, the classes don't overlap
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipelines[0].layout, 0, 1, &compute_set, 0, nullptr);
+        for (uint32_t tile_class = 0; tile_class < TileClasses; ++tile_class) {
+            vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_COMPUTE, compute_pipelines[tile_class].pipeline);
+            vkCmdDispatchIndirect(cmd, tile_lists.buffer, tile_class * 4 * sizeof(uint32_t));
+        }
+
+        // Depth goes R16 image -> buffer -> D16 attachment
+        libgui::change_image_layout(cmd, compute_depth.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+        VkBufferImageCopy region {
+            .imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+            .imageExtent = compute_depth.extent,
+        };
+        vkCmdCopyImageToBuffer(cmd, compute_depth.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, compute_depth_copy.buffer, 1, &region);
+
+        libgui::buffer_barrier(cmd, compute_depth_copy, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_2_TRANSFER_BIT, VK_ACCESS_2_TRANSFER_READ_BIT);
+
+        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_DEPTH_BIT;
+        vkCmdCopyBufferToImage(cmd, compute_depth_copy.buffer, scene->DrawDepth.image, VK_IMAGE_LAYOUT_GENERAL, 1, &region);
+    }
+
+    // Screen y of the water surface, pixels above it get the wet terrain displacement
+    float water_surface() const {
+        const float height = scene->DrawImage.height;
+        if (!room.hasWater()) return height;
+
+        return height - (room.water_level * 20.0f + scene->Camera.offset.y);
+    }
+
+    std::string camera_image_path(const int camera) const { return room.getImagePath(level_directory, camera); }
+
+    // The room's image sizes are checked when it's loaded (see WorldStreamer::load), this only catches files changed since
+    bool fits_gbuffer(const int camera, const int width, const int height) {
+        if (width == static_cast<int>(gbuffer.width) && height == static_cast<int>(gbuffer.height)) return true;
+
+        wlog::logf(wlog::WLOG_ERROR, "Camera image changed size since its room was loaded, not showing it: %s", camera_image_path(camera).c_str());
+        rejected[camera] = true;
+        return false;
+    }
+
+    // Shows another camera's image, the G-buffer is rebaked before the next draw. Stays on the current camera if the image can't be shown
+    void switch_camera(const int camera) {
+        if (rejected[camera]) return;
+
+        if (!camera_images[camera]) {
+            // Prefetch missed, wait for the decode or load it here
+            const std::string path = camera_image_path(camera);
+            if (decoding[camera].valid()) {
+                DecodedImage decoded = decoding[camera].get();
+                if (!fits_gbuffer(camera, decoded.width, decoded.height)) return;
+
+                camera_images[camera] = scene->TextureLeaser->upload(scene->ImmediateCmd, decoded, path);
+            }
+            else {
+                camera_images[camera] = scene->TextureLeaser->load_file(scene->ImmediateCmd, path.c_str(), path);
+            }
+            prefetch_misses++;
+        }
+
+        if (!fits_gbuffer(camera, camera_images[camera]->image.width, camera_images[camera]->image.height)) {
+            camera_images[camera].reset();
+            return;
+        }
+
+        level_image = camera_images[camera];
+        baked = { -1, -1 };
+
+        scene->Camera.index = camera;
+        scene->Camera.offset = cameras.getOffset(camera);
+    }
+
+    // Uploads finished decodes, follows the camera target and queues decodes for the views it's heading to.
+    // Only call while the GPU is idle
+    void update_camera() {
+        const SceneCamera &camera = scene->Camera;
+        const std::vector<int> wanted = cameras.neighbours(camera.index, camera.target, camera.target_velocity, PrefetchTicks, PrefetchRadius);
+        const auto is_wanted = [&](const int i) { return i == camera.index || std::ranges::find(wanted, i) != wanted.end(); };
+
+        for (int i = 0; i < cameras.getCount(); ++i) {
+            if (!decoding[i].valid() || decoding[i].wait_for(std::chrono::seconds(0)) != std::future_status::ready) continue;
+
+            DecodedImage decoded = decoding[i].get();
+            if (is_wanted(i) && fits_gbuffer(i, decoded.width, decoded.height)) camera_images[i] = scene->TextureLeaser->upload(scene->ImmediateCmd, decoded, camera_image_path(i));
+        }
+
+        if (const int next = cameras.update(camera.index, camera.target); next != camera.index) switch_camera(next);
+
+        for (int i = 0; i < cameras.getCount(); ++i) {
+            // Dropped images stay in the texture cache until it needs the room
+            if (!is_wanted(i)) {
+                camera_images[i].reset();
+                continue;
+            }
+
+            if (camera_images[i] || decoding[i].valid() || rejected[i]) continue;
+
+            const std::string path = camera_image_path(i);
+            if (scene->TextureLeaser->try_get(path, &camera_images[i])) continue;
+
+            decoding[i] = jobs::JobSystem::shared().async("decode camera image", [path] { return TextureLease::decode_file(path.c_str()); });
+        }
+    }
+
+    UniformLevelInfo level_info() const {
+        return UniformLevelInfo(
+            glm::ivec2(1400, 800),
+            0,
+            0,
+            glm::vec2(0, 0),
+
+            glm::vec2(0, 0),
+
+            glm::vec4(room.light_angle, 1.0f / scene->DrawImage.width, 1.0f / scene->DrawImage.height),
+            0,
+            water_surface(),
+            1,
+            0,
+            0,
+            0,
+            1,
+            1,
+            1,
+            0,
+            0,
+
+            0,
+
+            glm::vec4(1),
+            0,
+
+            palette_a,
+            palette_b,
+            palette_blend
+        );
+    }
+
 public:
-    explicit SceneLevel(const std::shared_ptr<Scene> &scene, const char *level_asset) : scene(scene) {
-        if (!scene->TextureLeaser.try_get(level_asset, &level_image))
-            level_image = scene->TextureLeaser.load_file(scene->ImmediateCmd, level_asset, level_asset);
+    explicit SceneLevel(const std::shared_ptr<Scene> &scene, const char *level_directory, const RoomDescriptor &room)
+        : scene(scene), room(room), cameras(room), level_directory(level_directory),
+          camera_images(room.cameras.size()), decoding(room.cameras.size()), rejected(room.cameras.size()) {
+        // Starts on the first camera, looking at its middle until something reports a target
+        scene->Camera = {
+            .index = 0,
+            .offset = cameras.getOffset(0),
+            .target = cameras.getOrigin(0) + glm::vec2(RoomCameras::ViewWidth, RoomCameras::ViewHeight) / 2.0f,
+        };
+
+        const std::string first_image = camera_image_path(0);
+        level_image = scene->TextureLeaser->load_file(scene->ImmediateCmd, first_image.c_str(), first_image);
+        camera_images[0] = level_image;
+
+        palette_image = scene->TextureLeaser->load_array(scene->ImmediateCmd, PalettePaths, "palettes");
+
+        if (!scene->TextureLeaser->try_get("perlin64", &noise_image))
+            noise_image = scene->TextureLeaser->load_file(scene->ImmediateCmd, "assets/noise.png", "perlin64");
+
+        // G-buffer and its bake pass
+        libgui::create_image(
+            scene->VMA, scene->GPU, &gbuffer,
+            level_image->image.width, level_image->image.height, 0,
+            VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 0,
+            libgui::MemoryCategory::RenderTargets, GBufferLayers
+        );
+
+        VK_ASSERT( libgui::descriptor_set_layout(
+            scene->GPU,
+            {
+                VkDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+                VkDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+                VkDescriptorSetLayoutBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            },
+
+            &bake_layout
+        ) );
+
+        VkShaderModule bake_comp;
+        VK_ASSERT( libgui::vulkan_create_shader_from_file(scene->GPU, &bake_comp, "shaders/level_bake.comp.spv") );
+        bake_pipeline = libgui::create_compute_pipeline(scene->GPU, bake_comp, { bake_layout }, sizeof(PushLevelBake));
+        vkDestroyShaderModule(scene->GPU, bake_comp, nullptr);
+
+        // Tile classification, runs with every bake
+        tiles_x = (scene->DrawImage.width + TileSize - 1) / TileSize;
+        tiles_y = (scene->DrawImage.height + TileSize - 1) / TileSize;
+        VK_ASSERT( libgui::create_buffer(scene->VMA, &tile_lists, (TileClasses * 4 + TileClasses * tiles_x * tiles_y) * sizeof(uint32_t), VMA_MEMORY_USAGE_GPU_ONLY, 0, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, libgui::MemoryCategory::RenderTargets) );
+
+        VK_ASSERT( libgui::descriptor_set_layout(
+            scene->GPU,
+            {
+                VkDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+                VkDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            },
+
+            &classify_layout
+        ) );
+
+        classify_set = scene->DescriptorLeaser.allocate(scene->GPU, classify_layout);
+
+        libgui::DescriptorLayoutHelper()
+            .image(0, gbuffer.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+            .buffer(1, tile_lists.buffer, tile_lists.size, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+            .update_set(scene->GPU, classify_set);
+
+        VkShaderModule classify_comp;
+        VK_ASSERT( libgui::vulkan_create_shader_from_file(scene->GPU, &classify_comp, "shaders/level_classify.comp.spv") );
+        classify_pipeline = libgui::create_compute_pipeline(scene->GPU, classify_comp, { classify_layout }, sizeof(PushLevelClassify));
+        vkDestroyShaderModule(scene->GPU, classify_comp, nullptr);
 
-        if (!scene->TextureLeaser.try_get("palette0", &palette_image))
-            palette_image = scene->TextureLeaser.load_file(scene->ImmediateCmd, "assets/palettes/palette0.png", "palette0");
+        bake();
 
-        if (!scene->TextureLeaser.try_get("perlin64", &noise_image))
-            noise_image = scene->TextureLeaser.load_file(scene->ImmediateCmd, "assets/noise.png", "perlin64");
+        VK_ASSERT( uniforms.create(scene->VMA) );
+        uniforms.assign(level_info());
+        uniforms.flush();
 
-        scene->ensure_uniform_size(sizeof(UniformLevelInfo));
         VK_ASSERT( libgui::descriptor_set_layout(
             scene->GPU,
             {
@@ -36,16 +399,6 @@ public:
             &set_layout
         ) );
 
-        set = scene->DescriptorLeaser.allocate(scene->TextureLeaser.GPU, set_layout);
-
-        libgui::DescriptorLayoutHelper()
-            .buffer(0, scene->PerDrawUniform.buffer, scene->PerDrawUniform.size, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
-            .image(1, level_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
-            .image(2, palette_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
-            .image(3, noise_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
-            .image(4, scene->DrawDepth.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
-            .update_set(scene->GPU, set);
-
         // basic sprite pipeline
         VkShaderModule level_vert;
         VkShaderModule level_frag;
@@ -63,6 +416,66 @@ public:
 
         vkDestroyShaderModule(scene->GPU, level_vert, nullptr);
         vkDestroyShaderModule(scene->GPU, level_frag, nullptr);
+
+        // compute renderer
+        libgui::create_image(
+            scene->VMA, scene->GPU, &compute_depth,
+            scene->DrawImage.width, scene->DrawImage.height, 0,
+            VK_FORMAT_R16_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 0,
+            libgui::MemoryCategory::RenderTargets
+        );
+        VK_ASSERT( libgui::create_buffer(scene->VMA, &compute_depth_copy, scene->DrawImage.width * scene->DrawImage.height * sizeof(uint16_t), VMA_MEMORY_USAGE_GPU_ONLY, 0, VK_BUFFER_USAGE_TRANSFER_SRC_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, libgui::MemoryCategory::RenderTargets) );
+
+        VK_ASSERT( libgui::descriptor_set_layout(
+            scene->GPU,
+            {
+                VkDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+                VkDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+                VkDescriptorSetLayoutBinding(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+                VkDescriptorSetLayoutBinding(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+                VkDescriptorSetLayoutBinding(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+                VkDescriptorSetLayoutBinding(5, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+                VkDescriptorSetLayoutBinding(6, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+                VkDescriptorSetLayoutBinding(7, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1, VK_SHADER_STAGE_COMPUTE_BIT),
+            },
+
+            &compute_layout
+        ) );
+
+        build_permutations(uniforms.get().SwarmRoom > 0, uniforms.get().WetTerrain >= .5f);
+    }
+
+    // Shows another room, its first camera image should already be uploaded (see WorldStreamer).
+    // Only call while the GPU is idle
+    void set_room(const RoomDescriptor &next, const TexturePtr &first_image) {
+        room = next;
+        cameras = RoomCameras(room);
+
+        // Decodes still running for the old room finish on their own, their results are dropped
+        camera_images.assign(room.cameras.size(), nullptr);
+        decoding = std::vector<std::future<DecodedImage>>(room.cameras.size());
+        rejected.assign(room.cameras.size(), false);
+        camera_images[0] = first_image;
+
+        scene->Camera.target = cameras.getOrigin(0) + glm::vec2(RoomCameras::ViewWidth, RoomCameras::ViewHeight) / 2.0f;
+        scene->Camera.target_velocity = glm::vec2(0);
+        switch_camera(0);
+    }
+
+    ~SceneLevel() override {
+        vkDestroyDescriptorSetLayout(scene->GPU, set_layout, nullptr);
+        vkDestroyDescriptorSetLayout(scene->GPU, bake_layout, nullptr);
+        bake_pipeline.dispose();
+        gbuffer.dispose();
+
+        vkDestroyDescriptorSetLayout(scene->GPU, compute_layout, nullptr);
+        for (auto &compute_pipeline : compute_pipelines) compute_pipeline.dispose();
+        vkDestroyDescriptorSetLayout(scene->GPU, classify_layout, nullptr);
+        classify_pipeline.dispose();
+        tile_lists.dispose();
+        uniforms.dispose();
+        compute_depth.dispose();
+        compute_depth_copy.dispose();
     }
 
     void physics_tick(Scene *scene) override {
@@ -70,39 +483,83 @@ public:
     }
 
     void frame_update(Scene *scene) override {
+        ImGui::Begin("Level");
 
-    }
+        ImGui::Combo("Palette A", &palette_a, PaletteNames, std::size(PaletteNames));
+        ImGui::Combo("Palette B", &palette_b, PaletteNames, std::size(PaletteNames));
+        ImGui::SliderFloat("Blend", &palette_blend, 0, 1);
 
-    void poll_draw() override {
-        constexpr glm::vec2 pos { 700, 400 };
+        ImGui::SeparatorText("Camera");
+        ImGui::Text("Camera %d of %d", scene->Camera.index + 1, cameras.getCount());
+        ImGui::Text("Resident: %d, decoding: %d", static_cast<int>(std::ranges::count_if(camera_images, [](const TexturePtr &image) { return image != nullptr; })), static_cast<int>(std::ranges::count_if(decoding, [](const std::future<DecodedImage> &decode) { return decode.valid(); })));
+        ImGui::Text("Prefetch misses: %u", prefetch_misses);
 
-        const auto level_info = std::make_shared<UniformLevelInfo>(
-            glm::ivec2(1400, 800),
-            0,
-            0,
-            glm::vec2(0, 0),
+        ImGui::SeparatorText("Renderer");
+        ImGui::Checkbox("Compute", &use_compute);
+        ImGui::Text("GPU shadows: %.3f ms", scene->Timings.shadow_ms);
+        ImGui::Text("GPU compute: %.3f ms", scene->Timings.compute_ms);
+        ImGui::Text("GPU raster: %.3f ms", scene->Timings.raster_ms);
 
-            glm::vec2(0, 0),
+        const libgui::DescriptorLeaseStats descriptors = scene->DescriptorLeaser.stats();
+        ImGui::Text("Descriptor pools: %u (%u full), sets: %llu", descriptors.pools, descriptors.full_pools, static_cast<unsigned long long>(descriptors.sets_allocated));
 
-            glm::vec4(0, 0, 0, 0),
-            0,
-            0,
-            1,
-            0,
-            0,
-            0,
-            1,
-            1,
-            1,
-            0,
-            0,
+        // Unfenced resets must stay 0, anything else means a slot was reset while its submit could still be running
+        const libgui::DescriptorLeaseStats frame_descriptors = scene->FrameDescriptors.stats();
+        ImGui::Text("Frame pools: %u (%u full), sets: %llu", frame_descriptors.pools, frame_descriptors.full_pools, static_cast<unsigned long long>(frame_descriptors.sets_allocated));
+        ImGui::Text("Frame resets: %llu, unfenced: %llu", static_cast<unsigned long long>(frame_descriptors.resets), static_cast<unsigned long long>(frame_descriptors.unfenced_resets));
 
-            0,
+        ImGui::End();
 
-            glm::vec4(1),
-            0
-        );
+        update_camera();
 
-        pipeline->poller.make_sprite(pos, glm::vec2(1400, 800), 0, 1, scene->UniversalSet, set, std::move(level_info));
+        // The GPU is idle between frames, safe to overwrite the G-buffer
+        if (baked != PushLevelBake { palette_a, palette_b }) bake();
+
+        // Nothing reads the uniforms until the next submit
+        uniforms.assign(level_info());
+        uniforms.flush();
+
+        const UniformLevelInfo &info = uniforms.get();
+        if (permutations_swarm != (info.SwarmRoom > 0) || permutations_wet != (info.WetTerrain >= .5f))
+            build_permutations(info.SwarmRoom > 0, info.WetTerrain >= .5f);
+    }
+
+    // Switching or fading palettes only changes the uniform, the array holds all of them
+    void set_palettes(const int a, const int b, const float blend) {
+        palette_a = a;
+        palette_b = b;
+        palette_blend = blend;
+    }
+
+    void poll_draw() override {
+        if (use_compute) {
+            const VkDescriptorSet compute_set = scene->FrameDescriptors.allocate(scene->GPU, compute_layout);
+            libgui::DescriptorLayoutHelper()
+                .buffer(0, uniforms.Buffer.buffer, uniforms.Buffer.size, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+                .image(1, gbuffer.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+                .image(2, palette_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+                .image(3, noise_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+                .image(4, scene->ShadowMask.view, scene->DefaultLinearSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+                .image(5, scene->DrawImage.view, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+                .image(6, compute_depth.view, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_GENERAL, VK_DESCRIPTOR_TYPE_STORAGE_IMAGE)
+                .buffer(7, tile_lists.buffer, tile_lists.size, 0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER)
+                .update_set(scene->GPU, compute_set);
+
+            scene->ComputePasses.emplace_back([this, compute_set](const VkCommandBuffer cmd) { draw_compute(cmd, compute_set); });
+            return;
+        }
+
+        const VkDescriptorSet set = scene->FrameDescriptors.allocate(scene->GPU, set_layout);
+        libgui::DescriptorLayoutHelper()
+            .buffer(0, uniforms.Buffer.buffer, uniforms.Buffer.size, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
+            .image(1, gbuffer.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+            .image(2, palette_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+            .image(3, noise_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+            .image(4, scene->ShadowMask.view, scene->DefaultLinearSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
+            .update_set(scene->GPU, set);
+
+        // The uniforms are already in their own buffer, nothing to upload per draw
+        constexpr glm::vec2 pos { 700, 400 };
+        pipeline->poller.make_sprite(pos, glm::vec2(1400, 800), 0, 1, scene->UniversalSet, set, 0, UVOrigin::Top);
     }
 };
@@ -18,14 +18,20 @@
 #include <filesystem>
 
 // GLOB BREAKS so here's a bad fix
+#include <jobs.cpp>
 #include <draw_poller.cpp>
 #include <textures.cpp>
+#include <atlas.cpp>
 #include <pipelines.cpp>
 #include <scene.cpp>
+#include <simulation.cpp>
 #include <circle.cpp>
 #include <level.cpp>
 #include <simpleCollider.cpp>
+#include <creature.cpp>
+#include <vines.cpp>
 #include <debuggeo.cpp>
+#include <world.cpp>
 
 static libgui::GUIManager GUI;
 
@@ -34,14 +40,6 @@ static std::shared_ptr<Scene> MainScene;
 
 #define FIXED_UPDATE_MS 25 // 40 FPS
 
-static std::chrono::steady_clock::time_point LastDelta;
-static std::chrono::steady_clock::time_point LastFixed;
-
-static float FixedStacker;
-
-static float DeltaTime;
-static float FixedTime;
-
 void dispose();
 
 int main(int, char**) {
@@ -89,20 +87,39 @@ int main(int, char**) {
         throw std::runtime_error(imgui_error.value());
 
     Textures = std::make_shared<TextureLease>(GUI.GPU, GUI.VMA);
-    MainScene = std::make_shared<Scene>(GUI.GPU, *Textures);
+    MainScene = std::make_shared<Scene>(GUI.GPU, Textures);
+
+    // Physics and rope batches go wide on the shared job system, the results don't depend on how many workers it has
+    const auto wide = [](const size_t count, const std::function<void(size_t)> &batch) {
+        jobs::JobSystem::shared().parallel_for(0, count, 1, [&](const size_t begin, const size_t end) {
+            for (size_t i = begin; i < end; ++i) batch(i);
+        });
+    };
+    MainScene->Physics.setRunner(wide);
+    MainScene->Ropes.setRunner(wide);
 
-    glm::vec2 camOffset = custom::getCamOffsetFromFile("assets/levels/SU_A40.txt");
-    RoomGeometry geo = RoomGeometry::fromFile("assets/levels/SU_A40.txt");
+    // Rooms are parsed once by the streamer, the level and colliders share them
+    WorldStreamer world(MainScene, "assets/world/world_su.txt", "assets/levels/");
+    StreamedRoomPtr room = world.enter("SU_A40");
 
-    MainScene->SceneObjects.push_back(std::make_unique<SceneLevel>(MainScene, "assets/levels/SU_A40.png"));
+    auto level = std::make_unique<SceneLevel>(MainScene, "assets/levels/", room->descriptor);
+    SceneLevel *current_level = level.get();
+    MainScene->SceneObjects.push_back(std::move(level));
     // MainScene->SceneObjects.push_back(std::make_unique<SceneCircle>(MainScene, glm::vec2(500, 500)));
     // MainScene->SceneObjects.push_back(std::make_unique<SceneCircle>(MainScene, glm::vec2(400, 300)));
-    MainScene->SceneObjects.push_back(std::make_unique<SimpleCollider>(MainScene, glm::vec2(200,700), glm::vec2(0,-100), camOffset, geo));
+    MainScene->SceneObjects.push_back(std::make_unique<SimpleCollider>(MainScene, demo::playerStart(), demo::gravity(), room->geometry));
+    MainScene->SceneObjects.push_back(std::make_unique<Creature>(MainScene, demo::wormStart(), demo::gravity(), room->geometry));
+    MainScene->Recording = InputLog(world.current_room());
 
-    SceneDebugGeo scene_debug_geo {geo, camOffset};
+    auto vines = std::make_unique<SceneVines>(MainScene, room->geometry);
+    SceneVines *current_vines = vines.get();
+    MainScene->SceneObjects.push_back(std::move(vines));
 
-    LastDelta = std::chrono::steady_clock::now();
-    LastFixed = std::chrono::steady_clock::now();
+    SceneDebugGeo scene_debug_geo {room->geometry};
+
+    // Physics ticks on its own thread from here on, frames interpolate between the states it publishes
+    SceneSimulation simulation(MainScene, std::chrono::milliseconds(FIXED_UPDATE_MS));
+    simulation.start();
 
     // frame process
     while (GUI.WindowOpen) {
@@ -112,22 +129,26 @@ int main(int, char**) {
 
         libgui::imgui_frame_begin();
 
-        // Fixed update
-        FixedStacker += DeltaTime;
-        while (FixedStacker >= FIXED_UPDATE_MS) {
-            MainScene->physics_tick();
-
-            auto now = std::chrono::steady_clock::now();
-            auto fms = now - LastFixed;
-            FixedTime = std::chrono::duration_cast<std::chrono::milliseconds>(fms).count();
-            LastFixed = now;
-
-            FixedStacker -= FIXED_UPDATE_MS;
+        // Room changes are a swap to an already loaded room, the GPU is idle here.
+        // The simulation moves over before its next tick, the command keeps the last room alive until then
+        if (StreamedRoomPtr entered = world.frame_update()) {
+            current_level->set_room(entered->descriptor, entered->image);
+            scene_debug_geo = SceneDebugGeo(entered->geometry);
+
+            MainScene->post([entered, last = room, name = world.current_room(), current_vines](Scene &scene) {
+                scene.Physics.setRoom(entered->geometry);
+                scene.History.clear(); // Its chunks point into the last room
+                scene.Input.enteredRoom(name);
+                current_vines->plant(entered->geometry);
+            });
+            room = entered;
         }
 
         // Frame update
         MainScene->frame_update();
-        scene_debug_geo.frame_update();
+        simulation.frame_update();
+        scene_debug_geo.frame_update(MainScene->Camera.offset);
+        libgui::imgui_memory_panel(GUI.VMA);
 
         MainScene->poll_and_draw();
 
@@ -142,12 +163,17 @@ int main(int, char**) {
             libgui::imgui_draw(cmd, draw_img);
         });
 
-        auto now = std::chrono::steady_clock::now();
-        auto dms = now - LastDelta;
-        DeltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(dms).count();
-        LastDelta = now;
+        // Scene work is fenced by now, safe to drop textures
+        Textures->end_frame();
+        libgui::Memory.end_frame();
     }
 
+    simulation.stop();
+
+    // rwpp_replay last_run.rwinput plays this run again without a window
+    MainScene->Recording.setChecksum(MainScene->Physics.checksum());
+    MainScene->Recording.save("last_run.rwinput");
+
     MainScene->dispose();
     Textures->dispose_all();
     dispose();
@@ -27,6 +27,7 @@ LeasedPipeline PipelineLease::ensure_pipeline(const VkDevice device, const VkFor
         .push_vertex_field(0, VK_FORMAT_R32G32B32_SFLOAT, 0) // vec3 pos
         .push_vertex_field(1, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)) // vec2 uv
         .push_vertex_field(2, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, color)) // vec4 color
+        .push_vertex_field(3, VK_FORMAT_R32_UINT, offsetof(Vertex, texture)) // uint texture
         .push_vertex_binding<Vertex>();
 
     for (const auto layout: set_layouts) {
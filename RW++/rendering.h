@@ -13,6 +13,10 @@ struct Vertex {
     glm::vec3 pos;
     glm::vec2 uv;
     glm::vec4 color;
+    // Bindless texture index, see TextureLease. Draws aren't instanced: a poller batches every sprite into one
+    // vertex stream and one indexed draw, so this is the only place that can tell sprites of different textures apart.
+    // Constant across a sprite's four vertices, the shaders read it flat
+    uint32_t texture;
 };
 
 // Mesh data
@@ -38,6 +42,12 @@ struct RenderDescription {
     uint32_t uniform_size;
 };
 
+// Which edge of a sprite v = 0 sits on. Quads are built in scene space, where the top edge is +y
+enum class UVOrigin {
+    Bottom, // Plain textures
+    Top,    // Atlas regions, uniform driven sprites and anything else that reads its uv like a screen position
+};
+
 // Poller belonging to a pipeline, records render descs
 class DrawPoller {
 public:
@@ -47,13 +57,34 @@ public:
 
     void make_custom(const RenderDescription &desc);
 
+    // uv origin is at the top, see UVOrigin
     template<typename T>
-    void make_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, std::shared_ptr<T> uniform);
+    void make_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, std::shared_ptr<T> uniform, uint32_t texture = 0);
+
+    // Nothing to upload, objects whose uniforms already live in a buffer bound by object_set pass UVOrigin::Top
+    void make_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, uint32_t texture = 0, UVOrigin origin = UVOrigin::Bottom);
 
-    void make_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set);
+    // Sprite sampling a sub-rectangle of a bindless texture, object_set is expected to be the bindless set
+    void make_sprite(glm::vec2 pos, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, const AtlasRegion &region);
 
     template<typename T>
-    static RenderDescription cache_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, std::shared_ptr<T> uniform);
+    static RenderDescription cache_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, std::shared_ptr<T> uniform, uint32_t texture = 0);
+
+    static RenderDescription cache_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, uint32_t texture = 0, UVOrigin origin = UVOrigin::Bottom);
+
+    // Most bytes a description may upload, vkCmdUpdateBuffer's limit
+    static constexpr size_t MaxUploadBytes = 65536;
+
+    /**
+     * @brief Quads between consecutive vertex pairs of outline, see RopeSystem::outline. Strips are packed together into as
+     * few descriptions (draws) as the upload limit allows, a strip that doesn't fit carries on in the next one
+     * @param strips number of pairs every strip takes from outline, in order
+     * @param offset added to every vertex, the camera offset for room positions
+     * @param region sampled at its centre only, a plain white sprite tinted by color draws solid shapes
+     */
+    void make_strips(std::span<const glm::vec2> outline, std::span<const uint32_t> strips, glm::vec2 offset, float depth, glm::vec4 color, VkDescriptorSet scene_set, VkDescriptorSet object_set, const AtlasRegion &region);
 
-    static RenderDescription cache_sprite(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set);
+private:
+    // The one quad every sprite overload builds, uv_min and uv_max span the sampled rectangle
+    static RenderDescription sprite_description(glm::vec2 pos, glm::vec2 size, float depth, float scale, VkDescriptorSet scene_set, VkDescriptorSet object_set, glm::vec2 uv_min, glm::vec2 uv_max, UVOrigin origin, uint32_t texture, std::shared_ptr<void> uniform, uint32_t uniform_size);
 };
@@ -2,22 +2,27 @@
 #include "scene.h"
 #include "uniforms.h"
 #include "glm_fix.h"
+#include "custom/demo.h"
 
-Scene::Scene(const vkb::Device &device, const TextureLease &texture_lease) : VMA(texture_lease.VMA), GPU(device), TextureLeaser(texture_lease) {
+Scene::Scene(const vkb::Device &device, const std::shared_ptr<TextureLease> &texture_lease) : VMA(texture_lease->VMA), GPU(device), TextureLeaser(texture_lease), Atlas(texture_lease) {
     graphics_queue = device.get_queue(vkb::QueueType::graphics).value();
     graphics_idx = device.get_queue_index(vkb::QueueType::graphics).value();
 
     disposal = libgui::AutoDisposal();
 
     DrawImage = {};
-    libgui::create_image(VMA, device, &DrawImage, 1400, 800, 0, VK_FORMAT_R8G8B8A8_UNORM);
+    libgui::create_image(VMA, device, &DrawImage, 1400, 800, 0, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT, 0, libgui::MemoryCategory::RenderTargets);
 
     DrawDepth = {};
-    libgui::create_image(VMA, device, &DrawDepth, 1400, 800, 0, VK_FORMAT_D16_UNORM, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT);
+    libgui::create_image(VMA, device, &DrawDepth, 1400, 800, 0, VK_FORMAT_D16_UNORM, VK_IMAGE_ASPECT_DEPTH_BIT, VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 0, libgui::MemoryCategory::RenderTargets);
+
+    ShadowMask = {};
+    libgui::create_image(VMA, device, &ShadowMask, 1400 / 2, 800 / 2, 0, VK_FORMAT_R8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, 0, libgui::MemoryCategory::RenderTargets);
 
     disposal.push_back([&] {
         DrawImage.dispose();
         DrawDepth.dispose();
+        ShadowMask.dispose();
     });
 
     // pipeline leaser
@@ -32,6 +37,19 @@ Scene::Scene(const vkb::Device &device, const TextureLease &texture_lease) : VMA
         vkDestroyFence(GPU, fence, nullptr);
     });
 
+    // GPU timestamps: frame start, after shadows, after compute, after draws
+    const VkQueryPoolCreateInfo timestamps_create {
+        .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+        .queryType = VK_QUERY_TYPE_TIMESTAMP,
+        .queryCount = 4,
+    };
+    VK_ASSERT(vkCreateQueryPool(GPU, &timestamps_create, nullptr, &timestamps));
+    timestamp_period = device.physical_device.properties.limits.timestampPeriod;
+
+    disposal.push_back([&] {
+        vkDestroyQueryPool(GPU, timestamps, nullptr);
+    });
+
     // Command Pool
     cmd_pool = VK_NULL_HANDLE;
     const VkCommandPoolCreateInfo pool_create {
@@ -59,9 +77,9 @@ Scene::Scene(const vkb::Device &device, const TextureLease &texture_lease) : VMA
 
     mesh_buffers = {};
 
-    VK_ASSERT( libgui::create_buffer(VMA, &mesh_buffers.vertices, 64, VMA_MEMORY_USAGE_GPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT) );
+    VK_ASSERT( libgui::create_buffer(VMA, &mesh_buffers.vertices, 64, VMA_MEMORY_USAGE_GPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, libgui::MemoryCategory::MeshRings) );
 
-    VK_ASSERT( libgui::create_buffer(VMA, &mesh_buffers.indices, 64, VMA_MEMORY_USAGE_GPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT) );
+    VK_ASSERT( libgui::create_buffer(VMA, &mesh_buffers.indices, 64, VMA_MEMORY_USAGE_GPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, libgui::MemoryCategory::MeshRings) );
 
     disposal.push_back([&] {
         mesh_buffers.vertices.dispose();
@@ -107,11 +125,24 @@ Scene::Scene(const vkb::Device &device, const TextureLease &texture_lease) : VMA
         DescriptorLeaser.destroy_pools(GPU);
     });
 
+    // Per-frame descriptor ring, the frame being recorded and the one being polled
+    std::vector<libgui::DescriptorLease::PoolSizeRatio> frame_desc_sizes = {
+        { VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 1 },
+        { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 1 },
+        { VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1 },
+        { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4 },
+    };
+
+    FrameDescriptors.init(GPU, 2, 64, frame_desc_sizes);
+    disposal.push_back([&] {
+        FrameDescriptors.destroy_pools(GPU);
+    });
+
     PerDrawUniform = {};
-    VK_ASSERT( libgui::create_buffer(VMA, &PerDrawUniform, 64, VMA_MEMORY_USAGE_GPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) );
+    VK_ASSERT( libgui::create_buffer(VMA, &PerDrawUniform, 64, VMA_MEMORY_USAGE_GPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 0, libgui::MemoryCategory::Uniforms) );
 
     SceneInfoUniform = {};
-    VK_ASSERT( libgui::create_buffer(VMA, &SceneInfoUniform, 64, VMA_MEMORY_USAGE_GPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT) );
+    VK_ASSERT( libgui::create_buffer(VMA, &SceneInfoUniform, 64, VMA_MEMORY_USAGE_GPU_ONLY, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 0, libgui::MemoryCategory::Uniforms) );
 
     disposal.push_back([&] {
         SceneInfoUniform.dispose();
@@ -130,18 +161,149 @@ Scene::Scene(const vkb::Device &device, const TextureLease &texture_lease) : VMA
     libgui::DescriptorLayoutHelper()
         .buffer(0, SceneInfoUniform.buffer, SceneInfoUniform.size, 0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER)
         .update_set(device, UniversalSet);
+
+    // Shadow occluders, only coverage matters so no depth or blending
+    VkShaderModule shadow_vert;
+    VkShaderModule shadow_frag;
+
+    VK_ASSERT( libgui::vulkan_create_shader_from_file(device, &shadow_vert, "shaders/basic_sprite.vert.spv") );
+    VK_ASSERT( libgui::vulkan_create_shader_from_file(device, &shadow_frag, "shaders/shadow.frag.spv") );
+
+    shadow_pipeline = libgui::PipelineBuilder()
+        .color_attachment_format(ShadowMask.format)
+        .multisampling()
+        .color_blending_none()
+
+        .topology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
+        .polygon_mode(VK_POLYGON_MODE_FILL)
+        .cull_mode(VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
+        .depth_test_none()
+
+        .push_vertex_field(0, VK_FORMAT_R32G32B32_SFLOAT, 0) // vec3 pos
+        .push_vertex_field(1, VK_FORMAT_R32G32_SFLOAT, offsetof(Vertex, uv)) // vec2 uv
+        .push_vertex_field(2, VK_FORMAT_R32G32B32A32_SFLOAT, offsetof(Vertex, color)) // vec4 color
+        .push_vertex_field(3, VK_FORMAT_R32_UINT, offsetof(Vertex, texture)) // uint texture
+        .push_vertex_binding<Vertex>()
+
+        .push_layout(UniversalSetLayout)
+        .push_layout(TextureLeaser->BindlessLayout)
+        .push_shader(shadow_vert, VK_SHADER_STAGE_VERTEX_BIT)
+        .push_shader(shadow_frag, VK_SHADER_STAGE_FRAGMENT_BIT)
+        .build(device);
+
+    vkDestroyShaderModule(device, shadow_vert, nullptr);
+    vkDestroyShaderModule(device, shadow_frag, nullptr);
+
+    disposal.push_back([&] { shadow_pipeline.dispose(); });
 }
 
 void Scene::frame_update() {
+    States.update();
+    const SceneState &state = States.front();
+    const std::chrono::duration<float> since = std::chrono::steady_clock::now() - state.due;
+    Alpha = glm::clamp(since / std::chrono::duration<float>(state.period), 0.0f, 1.0f);
+
+    // Never waits for the simulation, the objects read States and post their edits
     for (const auto &obj: SceneObjects) {
         obj->frame_update(this);
     }
 }
 
+void Scene::publish_state(const std::chrono::steady_clock::time_point due, const std::chrono::steady_clock::duration period) {
+    SceneState &state = States.back();
+    state.tick = Physics.getTicks();
+    state.due = due;
+    state.period = period;
+
+    // Chunks are trivially copyable, a slot that held as many before doesn't allocate
+    state.chunks.clear();
+    for (size_t i = 0; i < Physics.getCount(); ++i) state.chunks.push_back(Physics.getChunk(i));
+
+    const size_t last_count = published_positions.size();
+    published_positions.resize(state.chunks.size());
+    state.from.resize(state.chunks.size());
+    for (size_t i = 0; i < state.chunks.size(); ++i) {
+        // Chunks added since start where they are
+        const glm::vec2 position = state.chunks[i].getPosition();
+        state.from[i] = last_count == state.chunks.size() ? published_positions[i] : position;
+        published_positions[i] = position;
+    }
+
+    // Ropes added or removed since, no way to match the old outline up
+    Ropes.outline(state.rope_to, state.rope_strips);
+    state.rope_from = published_outline.size() == state.rope_to.size() ? published_outline : state.rope_to;
+    published_outline = state.rope_to;
+
+    state.active_chunks = Physics.getActiveCount();
+    state.history_ticks = History.getCount();
+    state.history_capacity = History.getCapacity();
+    state.constraint_stats = Physics.getConstraints().getStats();
+    state.distance_constraints = Physics.getConstraints().getDistanceCount();
+    state.angle_constraints = Physics.getConstraints().getAngleCount();
+    state.rope_stats = Ropes.getStats();
+    state.rope_count = Ropes.getRopeCount();
+    state.rope_points = Ropes.getPointCount();
+
+    States.publish();
+}
+
+glm::vec2 Scene::chunk_position(const size_t chunk) const {
+    const SceneState &state = States.front();
+    return glm::mix(state.from.at(chunk), state.chunks.at(chunk).getPosition(), Alpha);
+}
+
+void Scene::rope_outline(std::vector<glm::vec2> &vertices, std::vector<uint32_t> &strips) const {
+    const SceneState &state = States.front();
+    vertices.resize(state.rope_to.size());
+    for (size_t i = 0; i < vertices.size(); ++i) vertices[i] = glm::mix(state.rope_from[i], state.rope_to[i], Alpha);
+    strips = state.rope_strips;
+}
+
 void Scene::physics_tick() {
+    std::vector<std::function<void(Scene&)>> posted;
+    {
+        std::lock_guard lock(command_lock);
+        posted.swap(commands);
+    }
+
+    for (const auto &command: posted) command(*this);
+
+    run_tick(Input.take());
+}
+
+void Scene::post(std::function<void(Scene&)> command) {
+    std::lock_guard lock(command_lock);
+    commands.push_back(std::move(command));
+}
+
+void Scene::rewind(const size_t ticks) {
+    Input.rewound(static_cast<uint32_t>(ticks));
+}
+
+void Scene::resimulate(std::vector<InputFrame> inputs) {
+    if (inputs.empty()) return;
+
+    inputs[0].rewind += static_cast<uint32_t>(inputs.size());
+    for (const InputFrame &input: inputs) run_tick(input);
+}
+
+// Room changes are applied by whoever swaps the room, rwpp_replay does the rest in the same order
+void Scene::run_tick(InputFrame input) {
+    // Rewinds asked for between two ticks add up, they can't go further back than the history
+    input.rewind = std::min(input.rewind, static_cast<uint32_t>(History.getCount()));
+    if (input.rewind) History.rollback(Physics, input.rewind);
+    History.save(Physics);
+
+    Recording.push(input);
+    TickInput = input;
+    demo::applyEdits(Physics, input);
+
     for (const auto &obj: SceneObjects) {
         obj->physics_tick(this);
     }
+
+    Physics.step();
+    Ropes.step();
 }
 
 void Scene::poll_and_draw() {
@@ -151,6 +313,8 @@ void Scene::poll_and_draw() {
     const VkCommandBufferBeginInfo cmdBeginInfo = libgui::command_buffer_begin_info();
     VK_ASSERT(vkBeginCommandBuffer(cmd, &cmdBeginInfo));
 
+    vkCmdResetQueryPool(cmd, timestamps, 0, 4);
+
     const UniformSceneInfo screen_mat {
         .transform = ortho(0, DrawImage.width, DrawImage.height, 0, 0, 30), // X+ right, Y+ up, Z+ away
     };
@@ -173,9 +337,59 @@ void Scene::poll_and_draw() {
     const auto clear_range_depth = libgui::image_subresource_range(VK_IMAGE_ASPECT_DEPTH_BIT);
     vkCmdClearDepthStencilImage(cmd, DrawDepth.image, VK_IMAGE_LAYOUT_GENERAL, &clear_depth, 1, &clear_range_depth);
 
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, timestamps, 0);
+
+    // Shadow occluders into the half resolution mask.
+    // Last frame's reads finished before its fence, so the old contents can go without waiting on anything
+    libgui::image_barrier(
+        cmd, ShadowMask.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+        VK_PIPELINE_STAGE_2_NONE, VK_ACCESS_2_NONE,
+        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT
+    );
+
+    const VkViewport shadow_viewport { 0, 0, static_cast<float>(ShadowMask.width), static_cast<float>(ShadowMask.height), 0.0f, 1.0f };
+    vkCmdSetViewport(cmd, 0, 1, &shadow_viewport);
+
+    const VkRect2D shadow_area { 0, 0, ShadowMask.width, ShadowMask.height };
+    vkCmdSetScissor(cmd, 0, 1, &shadow_area);
+
+    // Clear once, every draw after loads
+    VkRenderingAttachmentInfo shadow_attachment = libgui::attachment_info(ShadowMask.view, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    shadow_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    VkRenderingInfo shadow_target = libgui::rendering_info(shadow_area, &shadow_attachment);
+    vkCmdBeginRendering(cmd, &shadow_target);
+    vkCmdEndRendering(cmd);
+
+    shadow_attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, shadow_pipeline.pipeline);
+    for (const auto &desc: ShadowPoller.Descriptions) {
+        draw_once(shadow_pipeline, desc, shadow_target);
+    }
+
+    // occluders -> level fragment or compute shader sampling them
+    libgui::image_barrier(
+        cmd, ShadowMask.image, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+        VK_PIPELINE_STAGE_2_COLOR_ATTACHMENT_OUTPUT_BIT, VK_ACCESS_2_COLOR_ATTACHMENT_WRITE_BIT,
+        VK_PIPELINE_STAGE_2_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_2_COMPUTE_SHADER_BIT, VK_ACCESS_2_SHADER_SAMPLED_READ_BIT
+    );
+
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, timestamps, 1);
+
+    // Pre-draw compute passes
+    if (!ComputePasses.empty()) {
+        // clears -> compute writes
+        libgui::change_image_layout(cmd, DrawImage.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL);
+        libgui::change_image_layout(cmd, DrawDepth.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_ASPECT_DEPTH_BIT);
+
+        for (const auto &pass: ComputePasses) {
+            pass(cmd);
+        }
+    }
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, timestamps, 2);
+
     // draw and depth images GENERAL -> ATTACHMENT
     libgui::change_image_layout(cmd, DrawImage.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-    libgui::change_image_layout(cmd, DrawDepth.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_IMAGE_ASPECT_DEPTH_BIT);
+    libgui::change_image_layout(cmd, DrawDepth.image, VK_IMAGE_LAYOUT_GENERAL, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL, VK_IMAGE_ASPECT_DEPTH_BIT);
 
     const VkViewport render_viewport { 0, 0, static_cast<float>(DrawImage.width), static_cast<float>(DrawImage.height), 0.0f, 1.0f };
     vkCmdSetViewport(cmd, 0, 1, &render_viewport);
@@ -183,47 +397,66 @@ void Scene::poll_and_draw() {
     const VkRect2D render_scissor { 0, 0, DrawImage.width, DrawImage.height };
     vkCmdSetScissor(cmd, 0, 1, &render_scissor);
 
+    const VkRenderingAttachmentInfo color_attachment = libgui::attachment_info(DrawImage.view, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+    const VkRenderingAttachmentInfo depth_attachment = libgui::attachment_info(DrawDepth.view, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
+    const VkRenderingInfo scene_target = libgui::rendering_info(render_scissor, &color_attachment, &depth_attachment);
+
     // Draw all pipelines
     for (const auto &pipeline: PipelineLeaser.Pipelines | std::views::values) {
         const auto locked = pipeline.lock();
         vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, locked->pipeline.pipeline);
 
         for (const auto &desc: locked->poller.Descriptions) {
-            draw_once(locked->pipeline, desc);
+            draw_once(locked->pipeline, desc, scene_target);
         }
     }
 
+    vkCmdWriteTimestamp2(cmd, VK_PIPELINE_STAGE_2_ALL_COMMANDS_BIT, timestamps, 3);
+
     vkEndCommandBuffer(cmd);
 
     const VkCommandBufferSubmitInfo cmd_info = libgui::command_buffer_submit_info(cmd);
     const VkSubmitInfo2 submit = libgui::submit_info(&cmd_info, nullptr, nullptr);
 
     VK_ASSERT(vkQueueSubmit2(graphics_queue, 1, &submit, fence));
+    const uint32_t submitted_frame = FrameDescriptors.current_frame();
 
-    // Reset all pollers and poll all objects for next frame
+    // Reset all pollers and poll all objects for next frame.
+    // The frame descriptors we move onto were last used by the previous submit, which we waited for last call
     PipelineLeaser.reset_pollers();
+    ShadowPoller.reset();
+    ComputePasses.clear();
+    FrameDescriptors.next_frame(GPU);
     for (const auto &obj : SceneObjects) {
         obj->poll_draw();
     }
 
     VK_ASSERT(vkWaitForFences(GPU, 1, &fence, true, 9999999999)); // :trolley:
+    FrameDescriptors.retire(submitted_frame);
+
+    uint64_t ticks[4];
+    if (vkGetQueryPoolResults(GPU, timestamps, 0, 4, sizeof(ticks), ticks, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) == VK_SUCCESS) {
+        Timings.shadow_ms = static_cast<float>(ticks[1] - ticks[0]) * timestamp_period / 1e6f;
+        Timings.compute_ms = static_cast<float>(ticks[2] - ticks[1]) * timestamp_period / 1e6f;
+        Timings.raster_ms = static_cast<float>(ticks[3] - ticks[2]) * timestamp_period / 1e6f;
+    }
 }
 
-void Scene::draw_once(const libgui::VkCompletePipeline &pipeline, const RenderDescription &desc) {
+void Scene::draw_once(const libgui::VkCompletePipeline &pipeline, const RenderDescription &desc, const VkRenderingInfo &target) {
     const uint32_t size_of_vertices = sizeof(Vertex) * desc.mesh_vertices.size();
     const uint32_t size_of_indices = sizeof(uint16_t) * desc.mesh_indices.size();
 
     // Resize buffers if needed
     if (mesh_buffers.vertices.size < size_of_vertices) {
         mesh_buffers.vertices.dispose();
-        VK_ASSERT( libgui::create_buffer(VMA, &mesh_buffers.vertices, size_of_vertices, VMA_MEMORY_USAGE_GPU_ONLY, 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT) );
+        VK_ASSERT( libgui::create_buffer(VMA, &mesh_buffers.vertices, size_of_vertices, VMA_MEMORY_USAGE_GPU_ONLY, 0, VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, libgui::MemoryCategory::MeshRings) );
 
         wlog::logf(wlog::WLOG_INFO, "RESIZED VERTEX BUFFER: %d", mesh_buffers.vertices.size);
     }
 
     if (mesh_buffers.indices.size < size_of_indices) {
         mesh_buffers.indices.dispose();
-        VK_ASSERT( libgui::create_buffer(VMA, &mesh_buffers.indices, size_of_indices, VMA_MEMORY_USAGE_GPU_ONLY, 0, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT) );
+        VK_ASSERT( libgui::create_buffer(VMA, &mesh_buffers.indices, size_of_indices, VMA_MEMORY_USAGE_GPU_ONLY, 0, VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, libgui::MemoryCategory::MeshRings) );
 
         wlog::logf(wlog::WLOG_INFO, "RESIZED INDEX BUFFER: %d", mesh_buffers.indices.size);
     }
@@ -248,10 +481,7 @@ void Scene::draw_once(const libgui::VkCompletePipeline &pipeline, const RenderDe
     libgui::uniform_write_barrier(cmd, PerDrawUniform, 0);
 
     // Start rendering
-    const VkRenderingAttachmentInfo color_attachment = libgui::attachment_info(DrawImage.view, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
-    const VkRenderingAttachmentInfo depth_attachment = libgui::attachment_info(DrawDepth.view, VK_IMAGE_LAYOUT_DEPTH_ATTACHMENT_OPTIMAL);
-    const VkRenderingInfo renderInfo = libgui::rendering_info(VkRect2D { 0, 0, DrawImage.width, DrawImage.height }, &color_attachment, &depth_attachment);
-    vkCmdBeginRendering(cmd, &renderInfo);
+    vkCmdBeginRendering(cmd, &target);
 
     const VkDescriptorSet sets[2] = { desc.scene_set, desc.object_set };
     vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline.layout, 0, 2, sets, 0, nullptr);
@@ -267,7 +497,7 @@ void Scene::draw_once(const libgui::VkCompletePipeline &pipeline, const RenderDe
 void Scene::ensure_uniform_size(const size_t size) {
     if (PerDrawUniform.size < size) {
         PerDrawUniform.dispose();
-        VK_ASSERT( libgui::create_buffer(VMA, &PerDrawUniform, size, VMA_MEMORY_USAGE_GPU_ONLY, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT) );
+        VK_ASSERT( libgui::create_buffer(VMA, &PerDrawUniform, size, VMA_MEMORY_USAGE_GPU_ONLY, 0, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, 0, libgui::MemoryCategory::Uniforms) );
 
         wlog::logf(wlog::WLOG_INFO, "RESIZED UNIFORM BUFFERS: %d", size);
     }
@@ -275,6 +505,10 @@ void Scene::ensure_uniform_size(const size_t size) {
 
 
 void Scene::dispose() {
+    // Objects hold the scene, drop them here or their pipelines and layouts never get destroyed
+    SceneObjects.clear();
+
+    Atlas.dispose();
     PerDrawUniform.dispose();
     disposal.dispose();
 }
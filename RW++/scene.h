@@ -2,10 +2,20 @@
 
 #include "rendering.h"
 #include "pipelines.h"
+#include "atlas.h"
+#include "custom/history.h"
+#include "custom/input.h"
+#include "custom/physics.h"
+#include "custom/rope.h"
+#include "custom/triple.h"
 
 #include <libgui_vkutils.h>
+#include <chrono>
 #include <cstdint>
+#include <functional>
 #include <memory>
+#include <mutex>
+#include <vector>
 
 class Scene;
 
@@ -23,6 +33,47 @@ public:
 // In-Scene scene object
 typedef std::unique_ptr<SceneObject_T> SceneObject;
 
+// GPU time of a frame's passes, in milliseconds
+struct SceneTimings {
+    float shadow_ms = 0;  // Shadow occluder pass
+    float compute_ms = 0; // Pre-draw compute passes
+    float raster_ms = 0;  // Every pipeline's draws
+};
+
+// Which room camera is on screen. The level picks the camera, the tracked object reports where it is
+struct SceneCamera {
+    int index = 0;
+    glm::vec2 offset {0};          // Room pixels + offset = screen pixels, y up
+    glm::vec2 target {0};          // Room position the camera follows
+    glm::vec2 target_velocity {0}; // Room pixels per physics tick
+};
+
+// What the render thread sees of a finished physics tick, published by the simulation thread. All it ever reads of the simulation.
+// Frames between two ticks show positions moving from `from` to the chunks' positions, over the period after the tick was due
+struct SceneState {
+    uint64_t tick = 0;
+    std::chrono::steady_clock::time_point due;
+    std::chrono::steady_clock::duration period {1};
+
+    std::vector<glm::vec2> from;       // Chunk positions as the last state had them, by chunk index
+    std::vector<BodyChunk> chunks;     // Copies of the chunks after this tick, their rooms aren't the render thread's to read
+
+    std::vector<glm::vec2> rope_from;  // Rope outline the same way, see RopeSystem::outline
+    std::vector<glm::vec2> rope_to;
+    std::vector<uint32_t> rope_strips;
+
+    // For the debug windows
+    size_t active_chunks = 0;
+    size_t history_ticks = 0;
+    size_t history_capacity = 0;
+    ConstraintSolver::Stats constraint_stats;
+    size_t distance_constraints = 0;
+    size_t angle_constraints = 0;
+    RopeSystem::Stats rope_stats;
+    size_t rope_count = 0;
+    size_t rope_points = 0;
+};
+
 // Global scene
 class Scene {
 private:
@@ -33,25 +84,47 @@ private:
     VkCommandBuffer cmd;
     VkFence fence;
 
+    VkQueryPool timestamps;
+    float timestamp_period; // Nanoseconds per timestamp tick
+
+    libgui::VkCompletePipeline shadow_pipeline; // Flat occluders into ShadowMask
+
     MeshBuffers mesh_buffers;
 
     libgui::AutoDisposal disposal;
 
+    void run_tick(InputFrame input);
+
+    // Simulation thread side of the published states
+    std::vector<glm::vec2> published_positions;
+    std::vector<glm::vec2> published_outline;
+
+    // Posted by the render thread, run by the simulation thread before its next tick
+    std::mutex command_lock;
+    std::vector<std::function<void(Scene&)>> commands;
+
 public:
     VmaAllocator VMA;
     VkDevice GPU;
 
     libgui::VkAllocatedImage DrawImage;
     libgui::VkAllocatedImage DrawDepth;
+    libgui::VkAllocatedImage ShadowMask; // Half resolution occluders, the level samples it as its shadow grabpass
 
     PipelineLease PipelineLeaser;
-    TextureLease TextureLeaser;
-    libgui::DescriptorLease DescriptorLeaser;
+    std::shared_ptr<TextureLease> TextureLeaser;
+    SpriteAtlas Atlas;
+    libgui::DescriptorLease DescriptorLeaser;        // Long-lived sets, e.g. per-object textures
+    libgui::FrameDescriptorLease FrameDescriptors;   // Transient sets, only valid for the frame being polled
     libgui::VkImmediateCommandBuffer ImmediateCmd;
 
     VkSampler DefaultLinearSampler;
     VkSampler DefaultNearestSampler;
 
+    // Shadow casters, drawn with a flat shader into ShadowMask before any other pass.
+    // Takes the same sprites as the pipeline pollers, bindless set included
+    DrawPoller ShadowPoller;
+
     libgui::VkSizedBuffer PerDrawUniform;
     libgui::VkSizedBuffer SceneInfoUniform;
 
@@ -60,21 +133,59 @@ public:
 
     std::vector<SceneObject> SceneObjects = {};
 
-    explicit Scene(const vkb::Device &device, const TextureLease &texture_lease);
+    // Compute work recorded before any draws, DrawImage and DrawDepth are in GENERAL.
+    // Filled while polling like the draw pollers and cleared once the frame is recorded
+    std::vector<std::function<void(VkCommandBuffer)>> ComputePasses = {};
+
+    SceneTimings Timings;
+    SceneCamera Camera;
+    PhysicsWorld Physics; // Stepped after every object's physics_tick
+    RopeSystem Ropes;     // and after Physics
+    PhysicsHistory History; // Physics from before every tick, ropes are decoration and aren't part of it
+
+    InputLatch Input;     // Filled by the objects' frame_update, taken by the next physics tick. Safe from either thread
+    InputFrame TickInput; // What the objects' physics_tick apply, with its edits the only input that may change Physics
+    InputLog Recording;   // Every tick's input since the scene started, rwpp_replay plays it back
+
+    // Physics, Ropes, History, TickInput and Recording belong to the simulation thread once it started.
+    // The render thread sends input and physics edits through Input, everything else through post, and reads States
+    TripleBuffer<SceneState> States; // Written after every tick, the render thread reads the front
+    float Alpha = 0;                 // How far the frame is through the front state's period, set by frame_update
+
+    explicit Scene(const vkb::Device &device, const std::shared_ptr<TextureLease> &texture_lease);
 
+    // Simulation thread, runs the posted commands and then a tick
     void physics_tick();
     void frame_update();
 
+    // Render thread, command runs on the simulation thread right before its next tick. How room swaps and the rope windows
+    // change the simulation, anything that changes Physics has to go through Input as a PhysicsEdit so it's recorded.
+    // Commands that ran are destroyed there too, whatever they hold lives until then
+    void post(std::function<void(Scene&)> command);
+
+    // Simulation thread, after a tick
+    void publish_state(std::chrono::steady_clock::time_point due, std::chrono::steady_clock::duration period);
+
+    // Render thread, interpolated between the front state's positions
+    glm::vec2 chunk_position(size_t chunk) const;
+    void rope_outline(std::vector<glm::vec2> &vertices, std::vector<uint32_t> &strips) const;
+
+    // Puts Physics back to before the last ticks it stepped, at the start of the next tick so it's part of its input.
+    // Objects keep their own state
+    void rewind(size_t ticks);
+    // Rewinds by as many ticks as there are inputs and runs them again with these. Same inputs give the same physics
+    void resimulate(std::vector<InputFrame> inputs);
+
     void poll_and_draw();
-    void draw_once(const libgui::VkCompletePipeline &pipeline, const RenderDescription &desc);
+    void draw_once(const libgui::VkCompletePipeline &pipeline, const RenderDescription &desc, const VkRenderingInfo &target);
 
     void ensure_uniform_size(size_t size);
 
     void dispose();
 
-    Scene(Scene &&other) noexcept = default;
-
-    Scene & operator=(Scene&& other) noexcept = default;
+    // The simulation thread and the states hold on to this one
+    Scene(Scene&&) = delete;
+    Scene& operator=(Scene&&) = delete;
 
     Scene(const Scene&) = delete;
     Scene& operator=(const Scene&) = delete;
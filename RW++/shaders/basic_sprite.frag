@@ -1,13 +1,17 @@
 ﻿#version 450
+#extension GL_EXT_nonuniform_qualifier : require
 
 layout(location = 0) in vec2 f_uv;
 layout(location = 1) in vec4 f_color;
+layout(location = 2) flat in uint f_tex;
 
 layout(location = 0) out vec4 out_color;
 
-layout(binding = 0, set = 1) uniform sampler2D tex;
+// Bindless texture table, see TextureLease
+layout(binding = 0, set = 1) uniform sampler smp;
+layout(binding = 1, set = 1) uniform texture2D textures[];
 
 void main() {
-    out_color = texture(tex, f_uv) * f_color;
+    out_color = texture(sampler2D(textures[nonuniformEXT(f_tex)], smp), f_uv) * f_color;
     if (out_color.a == 0) discard;
 }
@@ -0,0 +1,23 @@
+// Layout of the baked level G-buffer, written by level_bake.comp and read by the level renderers.
+// Everything in here only depends on the level image and the active palettes. The colors are baked for both palettes,
+// they are linear in the palette so the renderers blend them by paletteBlend and fading never needs a rebake
+
+const int GBUF_SHADOW0   = 0; // color when shadow = 0 with palette A, effect colors included
+const int GBUF_SHADOW1   = 1; // color when shadow = 1 with palette A, effect colors included
+const int GBUF_PALETTE_B = 2; // add to the above for palette B's colors
+const int GBUF_DECAL     = 4; // raw decal color from the level's decal row
+const int GBUF_DATA      = 5; // r: depth 0-29, g: flags, b: level blue, a: level red % 90
+const int GBUF_LAYERS    = 6;
+
+const uint FLAG_SKY             = 1u;  // empty pixel, only the background color
+const uint FLAG_NOT_FLOOR_DARK  = 2u;
+const uint FLAG_SHADOW_ELIGIBLE = 4u;  // red > 90, gets cloud shadows
+const uint FLAG_GRIME           = 8u;
+const uint FLAG_DECAL           = 16u;
+const uint FLAG_SWARM           = 32u;
+const uint FLAG_PALETTE2        = 64u; // third palette color, decals get brightened
+
+// 0-255 integers are stored in rgba8 unorm channels
+uint gbuf_byte(float value) {
+    return uint(round(value * 255));
+}
@@ -0,0 +1,207 @@
+// The level shading shared by level.frag and level.comp.
+// Includers declare the LevelInfo block as 'level', gTex, nTex, sTex, 'vec4 palette(ivec2)' and 'vec4 out_color'
+
+#include "level_gbuffer.glsl"
+
+// Specialization constants, level.comp builds one permutation per tile class (see level_tiles.glsl)
+// and turns off what the room doesn't use. The defaults are the full shader, which level.frag runs
+layout (constant_id = 0) const bool SHADE_SKY    = true;
+layout (constant_id = 1) const bool SHADE_SOLID  = true;
+layout (constant_id = 2) const bool SHADE_DECALS = true;
+layout (constant_id = 3) const bool SHADE_SWARM  = true;
+layout (constant_id = 4) const bool SHADE_WET    = true;
+
+#define PI 3.1415926535897932384626433832795
+// Originally 3.14, GLSL doesn't have fixed, half, etc and I also couldn't be
+// bothered to make floats of varying precisions so, here, fully precise PI as joar intended
+
+// Comments that start with 'Joar:' are comments or code carried from the original file
+
+float level_depth; // 0-1 depth of the shaded pixel, 1 for the sky
+
+vec3 applyHue(vec3 aColor, float aHue) {
+	float angle = radians(aHue);
+	vec3 k = vec3(0.57735);
+	float cosAngle = cos(angle);
+
+	//Rodrigues' rotation formula
+	return aColor * cosAngle + cross(k, aColor) * sin(angle) + k * dot(k, aColor) * (1 - cosAngle);
+}
+
+void colorParams(int red, int not_floor_dark, vec2 screen_pos) {
+    /* Wack, modified from Joar:
+    float clamp_red = 1.0;
+    if (red < 10) {
+        clamp_red = mix(not_floor_dark, 1.0, .5);
+    }
+    */
+    float clamp_red = int(red < 10) * mix(not_floor_dark, 1.0, .5) + int(red >= 10); // Added for clarity
+
+    out_color = mix(
+        out_color,
+        palette(ivec2(1.5, 7.5)),
+        clamp(red * clamp_red * level.fogAmount / 30.0, 0, 1)
+    );
+
+    // Joar: Color Adjustment params
+    out_color.rgb *= level.darkness;
+    out_color.rgb = ((out_color.rgb - 0.5) * level.contrast) + 0.5;
+    float greyscale = dot(out_color.rgb, vec3(.222, .707, .071));  // Joar: Convert to greyscale numbers with magic luminance numbers
+    out_color.rgb = mix(vec3(greyscale, greyscale, greyscale), out_color.rgb, level.saturation);
+    out_color.rgb = applyHue(out_color.rgb, level.hue);
+    out_color.rgb += level.brightness;
+}
+
+// shorthand for G-buffer reads
+vec4 gbuf(vec2 uv, int layer) {
+    return texture(gTex, vec3(uv, layer));
+}
+
+// baked color of GBUF_SHADOW0 or GBUF_SHADOW1, blended between the two active palettes
+vec4 gbuf_color(vec2 uv, int layer) {
+    return mix(gbuf(uv, layer), gbuf(uv, layer + GBUF_PALETTE_B), level.paletteBlend);
+}
+
+// Static terms (depth, palette colors, flags, decals) are baked by level_bake.comp,
+// only the animated ones are left here: rain displacement, cloud shadows, shadow grabpass and grime shimmer.
+// Writes out_color and level_depth
+void shade_level(vec2 f_uv, vec2 f_uv2, vec2 fragCoord) {
+    out_color = vec4(0.0, 0.0, 0.0, 1.0);
+    level_depth = 1;
+
+    /* Joar:
+    vec2 screenPos = vec2(mix(level.spriteRect.x + level.spriteRect.x, level.spriteRect.z + level.screenOffset.x, f_uv.x), mix(level.spriteRect.y + level.screenOffset.y, level.spriteRect.w + level.screenOffset.y, f_uv.y));
+    */
+    vec2 screenPos = level.screenOffset + fragCoord;
+
+    float displace = 0;
+    if (SHADE_WET) {
+        // I've no idea what 'ugh' does but here's what it's supposed to be:
+        // take the level's red value modulo 90 (baked)
+        // decrement by 1 and modulo with 30
+        // divide by 300
+        float ugh = mod(float(gbuf_byte(gbuf(f_uv, GBUF_DATA).a)) - 1, 30) / 300.0;
+
+        // I've got no damn idea
+        displace = texture(nTex, vec2((f_uv.x * 1.5) - ugh + (level.rain * .01), (f_uv.y * .25) - ugh + level.rain * 0.05)).x;
+
+        // what?
+        displace = clamp(
+            (sin((displace + f_uv.x + f_uv.y + level.rain * .1) * 3 * PI) - 0.95) * 20,
+            0,
+            1
+        );
+
+        // if we're not wet enough or the pixel is above the water, do not displace pixels down
+        /* Joar:
+            if (level.wetTerrain < .5 || 1 - screenPos.y > level.waterLevel) displace = 0;
+        */
+        displace *= int(!(level.wetTerrain < .5 || /*1 - */screenPos.y > level.waterLevel));
+    }
+
+    vec2 uv = vec2(f_uv2.x, f_uv2.y + displace * .001);
+    vec4 data = gbuf(uv, GBUF_DATA);
+
+    int red = int(gbuf_byte(data.r));
+    uint flags = gbuf_byte(data.g);
+    int notFloorDark = int((flags & FLAG_NOT_FLOOR_DARK) != 0u);
+
+    // Early return for white (empty) pixels, sky-only permutations never get past this
+    if (SHADE_SKY && (!SHADE_SOLID || (flags & FLAG_SKY) != 0u)) {
+        /* Joar:
+        if (level.rimFix > .5) {
+            out_color = level.aboveCloudsAtmosphereColor;
+        }
+        */
+        out_color = mix(
+            gbuf_color(uv, GBUF_SHADOW0), /*Bg color*/
+            level.aboveCloudsAtmosphereColor,
+            level.rimFix /*ceil(level.rimFix)*/
+        );
+
+        colorParams(255, notFloorDark, screenPos);
+        return;
+    }
+
+    float subtract_red = mod(float(gbuf_byte(data.a)), 30.0) * 0.003; // Added for clarity
+    float shadow = texture(
+        nTex,
+        vec2(
+            (f_uv.x * .5) + (level.rain * .1 * level.cloudsSpeed) - subtract_red,
+            1 - (f_uv.y * .5) + (level.rain * .2 * level.cloudsSpeed) - subtract_red
+        )
+    ).x;
+
+    shadow = .5 + sin(
+        mod(
+            shadow + (level.rain * .1 * level.cloudsSpeed) - f_uv.y,
+            1
+        ) * PI * 2
+    ) * .5;
+
+    shadow = clamp(((shadow - .5) * 6) + .5 - (level.light * 4), 0, 1);
+
+    /* Joar:
+    if (red > 90) {
+        red -= 90;
+    }
+    else {
+        shadow = 1.0;
+    }
+    */
+    int shadowEligible = int((flags & FLAG_SHADOW_ELIGIBLE) != 0u);
+    shadow = shadow * shadowEligible + (1 - shadowEligible);
+
+    level_depth = (red * notFloorDark) / 30.0;
+
+    if (shadow != 1.0 && red >= 5) {
+        // Joar's grab coordinates are 0-1 screen positions, zw is the size of a pixel in them
+        vec2 grabUV = fragCoord * level.lightDirAndPixelSize.zw;
+        vec2 grabPos = vec2(grabUV.x + -level.lightDirAndPixelSize.x * level.lightDirAndPixelSize.z * (red - 5), /*1 - */grabUV.y + level.lightDirAndPixelSize.y * level.lightDirAndPixelSize.w * (red - 5));
+        grabPos = ((grabPos - vec2(0.5, 0.3)) * (1 + (red - 5.0) / 460.0)) + vec2(0.5, 0.3);
+        vec4 sColor = texture(sTex, grabPos); // shadow color
+
+        /* Joar:
+        if (sColor.x != 0.0 || sColor.y != 0.0 || sColor.z != 0.0) {
+            shadow = 1.0;
+        }
+        */
+        float shadowExists = sColor.x + sColor.y + sColor.z;
+        shadow = shadow * int(shadowExists <= 0) + int(shadowExists > 0);
+    }
+
+    // NOW we're getting the color to output, effect colors are already mixed in
+    out_color = mix(gbuf_color(uv, GBUF_SHADOW0), gbuf_color(uv, GBUF_SHADOW1), shadow);
+
+    float rbcol = (sin((level.rain + (texture(nTex, vec2(f_uv.x * 2, f_uv.y * 2) ).x * 4) + red / 12.0) * PI * 2) * 0.5) + 0.5;
+    out_color = mix(out_color, palette(ivec2(5 + rbcol * 25, 6)), ((flags & FLAG_GRIME) != 0u ? 0.2 : 0.0) * level.grime);
+
+    if (SHADE_DECALS && (flags & FLAG_DECAL) != 0u) {
+        vec4 decalCol = gbuf(uv, GBUF_DECAL);
+        if ((flags & FLAG_PALETTE2) != 0u) decalCol = mix(decalCol, vec4(1), 0.2 - shadow * 0.1);
+        decalCol = mix(decalCol, palette(ivec2(1, 7)), red / 60.0); // mix decal with palette base color
+
+        out_color = mix(
+            mix(
+                out_color,
+                decalCol,
+                .7
+            ),
+            out_color * decalCol * 1.5,
+            mix(
+                .9,
+                .3 + .4 * shadow,
+                clamp((red - 3.5) * .3, 0, 1)
+            )
+        );
+
+        colorParams(red, notFloorDark, screenPos);
+        return;
+    }
+
+    if (SHADE_SWARM && (flags & FLAG_SWARM) != 0u) {
+        out_color = mix(out_color, vec4(1), data.b * level.swarmRoom);
+    }
+
+    colorParams(red, notFloorDark, screenPos);
+}
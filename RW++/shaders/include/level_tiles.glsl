@@ -0,0 +1,19 @@
+// Screen tiles of the compute level renderer, sorted by level_classify.comp and shaded by level.comp.
+// The tile list buffer starts with one VkDispatchIndirectCommand per class, padded to 16 bytes,
+// followed by TILE_CLASSES lists of tileStride packed tile positions (x | y << 16)
+
+const int TILE_SIZE = 8; // level.comp's group size
+
+const uint TILE_SKY     = 0u; // only sky pixels
+const uint TILE_SOLID   = 1u; // no sky, decals or swarm pixels
+const uint TILE_MIXED   = 2u; // sky next to geometry or swarm pixels, no decals
+const uint TILE_DECAL   = 3u; // has decals, runs the full shader
+const uint TILE_CLASSES = 4u;
+
+uint tile_pack(ivec2 tile) {
+    return uint(tile.x) | (uint(tile.y) << 16);
+}
+
+ivec2 tile_unpack(uint packed) {
+    return ivec2(packed & 0xffffu, packed >> 16);
+}
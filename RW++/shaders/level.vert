@@ -26,6 +26,10 @@ layout (binding = 0, set = 1) uniform LevelInfo {
     float brightness;
     vec4  aboveCloudsAtmosphereColor;
     float rimFix;
+
+    int   paletteA;
+    int   paletteB;
+    float paletteBlend;
 } level;
 
 layout(location = 0) in vec3 v_pos;
@@ -0,0 +1,19 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// Flat shadow caster drawn into the scene's ShadowMask, anything opaque blocks the level's light
+
+layout(location = 0) in vec2 f_uv;
+layout(location = 1) in vec4 f_color;
+layout(location = 2) flat in uint f_tex;
+
+layout(location = 0) out vec4 out_mask;
+
+// Bindless texture table, see TextureLease
+layout(binding = 0, set = 1) uniform sampler smp;
+layout(binding = 1, set = 1) uniform texture2D textures[];
+
+void main() {
+    if (texture(sampler2D(textures[nonuniformEXT(f_tex)], smp), f_uv).a * f_color.a == 0) discard;
+    out_mask = vec4(1);
+}
@@ -1,45 +1,28 @@
 #include "rendering.h"
 #include "custom/bodychunk.h"
+#include "custom/demo.h"
 #include "custom/geometry.h"
 
 class SimpleCollider final : public SceneObject_T {
     std::shared_ptr<Scene> scene;
-    glm::vec2 camOffset;
 
     glm::vec2 gravity;
 
-    TexturePtr circle_image;
-    VkDescriptorSetLayout texture_layout;
-    VkDescriptorSet texture_set;
+    AtlasRegion circle_region;
     LeasedPipeline pipeline;
 
-    BodyChunk bodychunk;
+    size_t body; // Chunk in the scene's physics world
+    BodyChunk controls; // Settings the Collider Controls window edits, sent to body as a PhysicsEdit
+
+    int rewind_ticks = 40;
 
 public:
-    explicit SimpleCollider(const std::shared_ptr<Scene> &scene, const glm::vec2 pos, const glm::vec2 g, const glm::vec2 offset, RoomGeometry &room)
+    explicit SimpleCollider(const std::shared_ptr<Scene> &scene, const glm::vec2 pos, const glm::vec2 g, RoomGeometry &room)
         : scene(scene),
           gravity(g),
-          bodychunk(pos, 1.0f, 16.0f, 0.55f, 0.05f, room) {
-        if (!this->scene->TextureLeaser.try_get("circle32", &circle_image))
-            circle_image = this->scene->TextureLeaser.load_file(this->scene->ImmediateCmd, "assets/circle.png", "circle32");
-
-        texture_layout = {};
-        VK_ASSERT( libgui::descriptor_set_layout(
-            scene->GPU,
-            {
-                VkDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr),
-            },
-
-            &texture_layout
-        ) );
-
-        camOffset.x = -offset.x + 10.0f;
-        camOffset.y = 800.0f + offset.y - (room.getYSize())*20.0f;
-
-        texture_set = scene->DescriptorLeaser.allocate(scene->TextureLeaser.GPU, texture_layout);
-        libgui::DescriptorLayoutHelper()
-            .image(0, circle_image->image.view, scene->DefaultNearestSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER)
-            .update_set(scene->GPU, texture_set);
+          body(demo::addPlayer(scene->Physics, pos, g, room)),
+          controls(scene->Physics.getChunk(body)) {
+        circle_region = this->scene->Atlas.load_file(this->scene->ImmediateCmd, "assets/circle.png", "circle32");
 
         // basic sprite pipeline
         VkShaderModule basic_vert;
@@ -51,7 +34,7 @@ public:
         pipeline = scene->PipelineLeaser.ensure_pipeline(
             scene->GPU,
             scene->DrawImage.format,
-            { scene->UniversalSetLayout, texture_layout },
+            { scene->UniversalSetLayout, scene->TextureLeaser->BindlessLayout },
             { "shaders/basic_sprite.vert.spv", "shaders/basic_sprite.frag.spv" },
             { {basic_vert, VK_SHADER_STAGE_VERTEX_BIT}, {basic_frag, VK_SHADER_STAGE_FRAGMENT_BIT} }
         );
@@ -60,40 +43,67 @@ public:
         vkDestroyShaderModule(scene->GPU, basic_frag, nullptr);
     }
 
+    // Stepped by the scene's physics world, moves by the tick's input
     void physics_tick(Scene *scene) override {
-        bodychunk.Update(gravity);
+        demo::applyPlayerInput(scene->Physics, body, scene->TickInput);
     }
 
     void frame_update(Scene *scene) override {
-        // CONTROLS
-        if (ImGui::IsKeyDown(ImGuiKey_D)) bodychunk.addVelocity(glm::vec2(10, 0));
-        if (ImGui::IsKeyDown(ImGuiKey_A)) bodychunk.addVelocity(glm::vec2(-10, 0));
-        if (ImGui::IsKeyPressed(ImGuiKey_W)) bodychunk.addVelocity(glm::vec2(0, 50));
+        const SceneState &state = scene->States.front();
+        const BodyChunk &bodychunk = state.chunks.at(body);
+
+        // The camera follows this collider where the frame shows it
+        scene->Camera.target = scene->chunk_position(body);
+        scene->Camera.target_velocity = bodychunk.getVelocity();
+        const glm::vec2 camOffset = scene->Camera.offset;
+
+        // CONTROLS, applied by the next physics tick
+        uint8_t held = 0;
+        if (ImGui::IsKeyDown(ImGuiKey_D)) held |= InputRight;
+        if (ImGui::IsKeyDown(ImGuiKey_A)) held |= InputLeft;
+        if (ImGui::IsKeyPressed(ImGuiKey_W)) scene->Input.press(InputJump);
 
         if (ImGui::IsMouseDown(ImGuiMouseButton_Right)) {
             const auto mouse_pos = ImGui::GetMousePos();
             const auto set_pos_y = scene->DrawImage.height - mouse_pos.y;
-            bodychunk.setPosition(glm::vec2(mouse_pos.x, set_pos_y) - camOffset);
+            scene->Input.setCursor(glm::vec2(mouse_pos.x, set_pos_y) - camOffset);
+            held |= InputTeleport;
         }
+        scene->Input.hold(held);
 
         // BODYCHUNK IMGUI
-        bodychunk.draw_ui(camOffset, scene->DrawImage.height);
+        if (controls.draw_ui(scene->Camera.target + camOffset, bodychunk.getVelocity(), scene->DrawImage.height)) {
+            scene->Input.edit(demo::chunkSettingsEdit(body, controls));
+        }
 
         // IMGUI
         ImGui::Begin("Player Control");
 
         // Draw line to the collider on-screen
         const auto dl = ImGui::GetBackgroundDrawList();
-        const auto pos = bodychunk.getPosition() + camOffset;
+        const auto pos = scene->Camera.target + camOffset;
         dl->AddLine(ImGui::GetWindowPos(), ImVec2(pos.x, scene->DrawImage.height - pos.y), ImGui::GetColorU32(ImVec4(1, 1, 1, 1)), 2);
 
-        ImGui::DragFloat("Gravity", &gravity.y, 50, -200, 200);
+        if (ImGui::DragFloat("Gravity", &gravity.y, 50, -200, 200)) {
+            scene->Input.edit(PhysicsEdit { .kind = PhysicsEdit::ChunkGravity, .chunk = static_cast<uint32_t>(body), .gravity = gravity });
+        }
+
+        ImGui::Text("%s, awake chunks: %zu / %zu", bodychunk.isAsleep() ? "Asleep" : "Awake", state.active_chunks, state.chunks.size());
+
+        // Back to before a glitch, stepping on from there does the same thing again unless something's changed
+        ImGui::SliderInt("Rewind ticks", &rewind_ticks, 1, static_cast<int>(state.history_capacity));
+        ImGui::BeginDisabled(state.history_ticks < static_cast<size_t>(rewind_ticks));
+        if (ImGui::Button("Rewind")) scene->rewind(rewind_ticks);
+        ImGui::EndDisabled();
+        ImGui::SameLine();
+        ImGui::Text("%zu ticks stored", state.history_ticks);
 
         ImGui::End();
     }
 
     void poll_draw() override {
-        glm::vec2 onScreenPos = bodychunk.getPosition() + camOffset;
-        pipeline->poller.make_sprite(onScreenPos, glm::vec2(32), -5, 1, scene->UniversalSet, texture_set);
+        glm::vec2 onScreenPos = scene->chunk_position(body) + scene->Camera.offset;
+        pipeline->poller.make_sprite(onScreenPos, -5, 1, scene->UniversalSet, scene->TextureLeaser->BindlessSet, circle_region);
+        scene->ShadowPoller.make_sprite(onScreenPos, -5, 1, scene->UniversalSet, scene->TextureLeaser->BindlessSet, circle_region);
     }
 };
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "scene.h"
+#include "custom/fixedstep.h"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <stop_token>
+#include <thread>
+
+// Runs the scene's physics ticks at a fixed rate on a thread of its own, publishing a SceneState after each.
+// Rendering never waits for a tick and ticks never wait for a frame, see Scene::post for how frames change the simulation
+class SceneSimulation {
+    std::shared_ptr<Scene> scene;
+    FixedStep step;
+    std::jthread thread;
+
+    // Written by the simulation thread, shown by frame_update
+    std::atomic<uint64_t> dropped { 0 };
+    std::atomic<float> tick_ms { 0 };
+
+public:
+    explicit SceneSimulation(const std::shared_ptr<Scene> &scene, const std::chrono::steady_clock::duration period)
+        : scene(scene), step(period, std::chrono::steady_clock::now()) {}
+
+    ~SceneSimulation() {
+        stop();
+    }
+
+    SceneSimulation(const SceneSimulation&) = delete;
+    SceneSimulation& operator=(const SceneSimulation&) = delete;
+
+    // Publishes the scene as it is so the first frame has something to draw, then starts ticking
+    void start() {
+        scene->publish_state(std::chrono::steady_clock::now(), step.getPeriod());
+
+        thread = std::jthread([this](const std::stop_token &stop) { run(stop); });
+    }
+
+    // Finishes the tick in flight, the scene is the render thread's again afterwards
+    void stop() {
+        if (!thread.joinable()) return;
+
+        thread.request_stop();
+        thread.join();
+    }
+
+    void frame_update() {
+        ImGui::Begin("Simulation");
+
+        const float period_ms = std::chrono::duration<float, std::milli>(step.getPeriod()).count();
+        ImGui::Text("Tick: %.3f ms of %.0f ms", tick_ms.load(std::memory_order_relaxed), period_ms);
+        ImGui::Text("Dropped ticks: %llu", static_cast<unsigned long long>(dropped.load(std::memory_order_relaxed)));
+        ImGui::Text("Interpolation: %.2f", scene->Alpha);
+
+        ImGui::End();
+    }
+
+private:
+    void run(const std::stop_token &stop) {
+        while (!stop.stop_requested()) {
+            for (int due = step.due(std::chrono::steady_clock::now()); due > 0; --due) {
+                const auto start = std::chrono::steady_clock::now();
+                const auto tick = step.advance();
+
+                scene->physics_tick();
+                scene->publish_state(tick, step.getPeriod());
+
+                const std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+                tick_ms.store(elapsed.count(), std::memory_order_relaxed);
+            }
+            dropped.store(step.getDropped(), std::memory_order_relaxed);
+
+            std::this_thread::sleep_until(step.getNext());
+        }
+    }
+};
@@ -0,0 +1,413 @@
+#include "level_cpu.h"
+#include "../jobs.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace soft {
+
+namespace {
+
+constexpr float Pi = 3.1415926535897932384626433832795f;
+
+// Flags of the G-buffer's data layer, see level_gbuffer.glsl
+constexpr uint8_t FlagSky            = 1;
+constexpr uint8_t FlagNotFloorDark   = 2;
+constexpr uint8_t FlagShadowEligible = 4;
+constexpr uint8_t FlagGrime          = 8;
+constexpr uint8_t FlagDecal          = 16;
+constexpr uint8_t FlagSwarm          = 32;
+constexpr uint8_t FlagPalette2       = 64;
+
+struct Color {
+    float r, g, b, a;
+};
+
+Color mix(const Color &x, const Color &y, const float t) {
+    return { x.r + (y.r - x.r) * t, x.g + (y.g - x.g) * t, x.b + (y.b - x.b) * t, x.a + (y.a - x.a) * t };
+}
+
+// GLSL mod, the result has the sign of y
+float glsl_mod(const float x, const float y) {
+    return x - y * std::floor(x / y);
+}
+
+float unorm(const uint8_t value) {
+    return static_cast<float>(value) / 255.0f;
+}
+
+// Same rounding as storing into an 8-bit unorm image
+uint8_t to_unorm(const float value) {
+    return static_cast<uint8_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f);
+}
+
+int wrap(const int value, const int size) {
+    const int wrapped = value % size;
+    return wrapped < 0 ? wrapped + size : wrapped;
+}
+
+// Nearest sample of the red channel with repeat addressing, how nTex is sampled
+float sample_nearest_r(const Image &image, const float u, const float v) {
+    const int x = wrap(static_cast<int>(std::floor(u * image.width)), image.width);
+    const int y = wrap(static_cast<int>(std::floor(v * image.height)), image.height);
+    return unorm(image.pixels[(static_cast<size_t>(y) * image.width + x) * 4]);
+}
+
+// Bilinear sample of r + g + b with repeat addressing, what the shadow grab tests
+float sample_linear_rgb(const Image &image, const float u, const float v) {
+    const float fx = u * image.width - 0.5f;
+    const float fy = v * image.height - 0.5f;
+    const float x0f = std::floor(fx);
+    const float y0f = std::floor(fy);
+    const float ax = fx - x0f;
+    const float ay = fy - y0f;
+
+    const auto texel = [&](const int x, const int y) {
+        const uint8_t *p = &image.pixels[(static_cast<size_t>(wrap(y, image.height)) * image.width + wrap(x, image.width)) * 4];
+        return unorm(p[0]) + unorm(p[1]) + unorm(p[2]);
+    };
+
+    const int x0 = static_cast<int>(x0f);
+    const int y0 = static_cast<int>(y0f);
+    const float top = texel(x0, y0) + (texel(x0 + 1, y0) - texel(x0, y0)) * ax;
+    const float bottom = texel(x0, y0 + 1) + (texel(x0 + 1, y0 + 1) - texel(x0, y0 + 1)) * ax;
+    return top + (bottom - top) * ay;
+}
+
+// The two active palettes blended once, 32x16
+class Palette {
+    Color colors[16][32];
+
+public:
+    // A single palette, how level_bake.comp reads one layer of pTex
+    explicit Palette(const Image &image) : Palette(image, image, 0) {}
+
+    Palette(const Image &a, const Image &b, const float blend) {
+        for (int y = 0; y < 16; ++y) {
+            for (int x = 0; x < 32; ++x) {
+                const uint8_t *pa = &a.pixels[(static_cast<size_t>(y) * a.width + x) * 4];
+                const uint8_t *pb = &b.pixels[(static_cast<size_t>(y) * b.width + x) * 4];
+                colors[y][x] = mix(
+                    Color { unorm(pa[0]), unorm(pa[1]), unorm(pa[2]), unorm(pa[3]) },
+                    Color { unorm(pb[0]), unorm(pb[1]), unorm(pb[2]), unorm(pb[3]) },
+                    blend
+                );
+            }
+        }
+    }
+
+    const Color &operator()(const int x, const int y) const {
+        return colors[std::clamp(y, 0, 15)][std::clamp(x, 0, 31)];
+    }
+};
+
+// Calls fn(row) for every row, rows are interleaved between jobs so sky and geometry heavy bands even out.
+// The jobs go to the shared job system, the calling thread runs its share too
+template<typename Fn>
+void parallel_rows(const int height, unsigned threads, const Fn &fn) {
+    jobs::JobSystem &system = jobs::JobSystem::shared();
+    if (threads == 0) threads = system.worker_count() + 1;
+    threads = std::min(threads, static_cast<unsigned>(std::max(height, 1)));
+
+    const auto band = [&](const size_t first) {
+        for (int y = static_cast<int>(first); y < height; y += static_cast<int>(threads)) fn(y);
+    };
+
+    if (threads == 1) {
+        band(0);
+        return;
+    }
+
+    system.parallel_for(0, threads, 1, [&](const size_t begin, const size_t end) {
+        for (size_t first = begin; first < end; ++first) band(first);
+    });
+}
+
+void store_color(LevelGBuffer &out, const int layer, const size_t i, const Color &color) {
+    out.layers[layer][i + 0] = to_unorm(color.r);
+    out.layers[layer][i + 1] = to_unorm(color.g);
+    out.layers[layer][i + 2] = to_unorm(color.b);
+    out.layers[layer][i + 3] = to_unorm(color.a);
+}
+
+void store_colors(LevelGBuffer &out, const int x, const int y, const int palette_offset, const Color &shadow0, const Color &shadow1) {
+    const size_t i = (static_cast<size_t>(y) * out.width + x) * 4;
+    store_color(out, LevelGBuffer::Shadow0 + palette_offset, i, shadow0);
+    store_color(out, LevelGBuffer::Shadow1 + palette_offset, i, shadow1);
+}
+
+void store_data(LevelGBuffer &out, const int x, const int y, const Color &decal, const int red, const uint8_t flags, const uint8_t blue, const int red90) {
+    const size_t i = (static_cast<size_t>(y) * out.width + x) * 4;
+
+    store_color(out, LevelGBuffer::Decal, i, decal);
+    out.layers[LevelGBuffer::Data][i + 0] = static_cast<uint8_t>(red);
+    out.layers[LevelGBuffer::Data][i + 1] = flags;
+    out.layers[LevelGBuffer::Data][i + 2] = blue;
+    out.layers[LevelGBuffer::Data][i + 3] = static_cast<uint8_t>(red90);
+}
+
+Color texel_color(const LevelGBuffer &gbuffer, const int layer, const int x, const int y) {
+    const uint8_t *p = gbuffer.texel(layer, x, y);
+    return { unorm(p[0]), unorm(p[1]), unorm(p[2]), unorm(p[3]) };
+}
+
+// One of the baked colors blended between the palettes, gbuf_color in level_shade.glsl
+Color gbuf_color(const LevelGBuffer &gbuffer, const int layer, const int x, const int y, const float blend) {
+    return mix(texel_color(gbuffer, layer, x, y), texel_color(gbuffer, layer + LevelGBuffer::PaletteB, x, y), blend);
+}
+
+}
+
+void bake_level(const Image &level, const Image &palette_a, const Image &palette_b, LevelGBuffer &out, const unsigned threads) {
+    out.width = level.width;
+    out.height = level.height;
+    for (auto &layer: out.layers) layer.assign(static_cast<size_t>(level.width) * level.height * 4, 0);
+
+    // Indexed by palette offset / GBUF_PALETTE_B
+    const Palette palettes[2] = { Palette(palette_a), Palette(palette_b) };
+
+    parallel_rows(level.height, threads, [&](const int y) {
+        for (int x = 0; x < level.width; ++x) {
+            const uint8_t *texcol = &level.pixels[(static_cast<size_t>(y) * level.width + x) * 4];
+
+            int red = texcol[0];
+            int green = texcol[1];
+            const int red90 = red % 90;
+            const float blue = unorm(texcol[2]);
+
+            // Empty pixels only show the background color
+            if (texcol[0] == 255 && texcol[1] == 255 && texcol[2] == 255 && texcol[3] == 255) {
+                store_data(out, x, y, Color {}, 0, FlagSky, texcol[2], red90);
+                for (int p = 0; p < 2; ++p) store_colors(out, x, y, p * LevelGBuffer::PaletteB, palettes[p](0, 0), palettes[p](0, 0));
+                continue;
+            }
+
+            uint8_t flags = 0;
+
+            if (green < 16) flags |= FlagNotFloorDark;
+            green %= 16;
+
+            const bool render_decals = green >= 8;
+            green %= 8;
+
+            if (red > 90) flags |= FlagShadowEligible;
+            red = red90;
+
+            const int palette_color = std::clamp(static_cast<int>(std::floor((red - 1) / 30.0f)), 0, 2);
+
+            red = static_cast<int>(glsl_mod(static_cast<float>(red) - 1.0f, 30.0f));
+            const int depth = red * ((flags & FlagNotFloorDark) != 0);
+
+            Color decal {};
+            bool effect_colors = false;
+
+            if (green >= 4) flags |= FlagGrime;
+
+            if (render_decals) {
+                flags |= FlagDecal;
+                if (palette_color == 2) flags |= FlagPalette2;
+
+                const uint8_t *d = &level.pixels[(static_cast<size_t>(level.height - 1) * level.width + (255 - texcol[2])) * 4];
+                decal = { unorm(d[0]), unorm(d[1]), unorm(d[2]), unorm(d[3]) };
+            }
+            else if (green > 0 && green < 3) {
+                effect_colors = true;
+            }
+            else if (green == 3) {
+                flags |= FlagSwarm;
+            }
+
+            store_data(out, x, y, decal, red, flags, texcol[2], red90);
+
+            for (int p = 0; p < 2; ++p) {
+                const Palette &palette = palettes[p];
+
+                Color shadow0 = palette(depth, palette_color + 6);
+                Color shadow1 = palette(depth, palette_color + 3);
+
+                if (effect_colors) {
+                    // Effect colors are linear in shadow, so they fold into both ends
+                    const int row = (green - 1) * 2;
+                    shadow0 = mix(shadow0, mix(palette(30, 5 - row), palette(30, 4 - row), red / 30.0f), blue);
+                    shadow1 = mix(shadow1, mix(palette(31, 5 - row), palette(31, 4 - row), red / 30.0f), blue);
+                }
+
+                store_colors(out, x, y, p * LevelGBuffer::PaletteB, shadow0, shadow1);
+            }
+        }
+    });
+}
+
+void shade_level(const UniformLevelInfo &info, const LevelGBuffer &gbuffer, const Image &palette_a, const Image &palette_b, const Image &noise, const Image &shadow, const LevelTarget &target, const unsigned threads) {
+    const Palette palette(palette_a, palette_b, info.paletteBlend);
+
+    // Uniform terms, worked out once instead of per pixel
+    const float hue = info.hue * Pi / 180.0f;
+    const float hue_cos = std::cos(hue);
+    const float hue_sin = std::sin(hue);
+    constexpr float k = 0.57735f;
+
+    const float clouds = info.rain * info.cloudsSpeed;
+    const bool wet = info.WetTerrain >= .5f;
+    const bool has_shadow = shadow.pixels != nullptr;
+    const Color fog = palette(1, 7);
+    const float size_x = static_cast<float>(target.width);
+    const float size_y = static_cast<float>(target.height);
+
+    parallel_rows(target.height, threads, [&](const int y) {
+        const float frag_y = static_cast<float>(y) + 0.5f;
+        const float v = frag_y / size_y;
+        const float v2 = v - info.texelSize.y * .5f * info.rimFix;
+        const float screen_y = info.screenOffset.y + frag_y;
+
+        // Rain only displaces pixels under the water line, which is the same for a whole row
+        const bool displaced = wet && !(screen_y > info.waterLevel);
+
+        for (int x0 = 0; x0 < target.width; x0 += Lanes) {
+            float u[Lanes], displace[Lanes], shadow_amount[Lanes], depth[Lanes];
+            int red[Lanes], gx[Lanes], gy[Lanes];
+            uint8_t flags[Lanes];
+            Color color[Lanes];
+
+            for (int l = 0; l < Lanes; ++l) {
+                u[l] = (static_cast<float>(std::min(x0 + l, target.width - 1)) + 0.5f) / size_x;
+                displace[l] = 0;
+            }
+
+            if (displaced) {
+                for (int l = 0; l < Lanes; ++l) {
+                    const int ux = wrap(static_cast<int>(std::floor(u[l] * gbuffer.width)), gbuffer.width);
+                    const int uy = wrap(static_cast<int>(std::floor(v * gbuffer.height)), gbuffer.height);
+                    const float ugh = glsl_mod(static_cast<float>(gbuffer.texel(LevelGBuffer::Data, ux, uy)[3]) - 1, 30) / 300.0f;
+
+                    const float n = sample_nearest_r(noise, u[l] * 1.5f - ugh + info.rain * .01f, v * .25f - ugh + info.rain * 0.05f);
+                    displace[l] = std::clamp((std::sin((n + u[l] + v + info.rain * .1f) * 3 * Pi) - 0.95f) * 20, 0.0f, 1.0f);
+                }
+            }
+
+            // G-buffer reads at the displaced coordinates
+            for (int l = 0; l < Lanes; ++l) {
+                const float u2 = u[l] - info.texelSize.x * .5f * info.rimFix;
+                gx[l] = wrap(static_cast<int>(std::floor(u2 * gbuffer.width)), gbuffer.width);
+                gy[l] = wrap(static_cast<int>(std::floor((v2 + displace[l] * .001f) * gbuffer.height)), gbuffer.height);
+
+                const uint8_t *data = gbuffer.texel(LevelGBuffer::Data, gx[l], gy[l]);
+                red[l] = data[0];
+                flags[l] = data[1];
+            }
+
+            // Cloud shadows
+            for (int l = 0; l < Lanes; ++l) {
+                const float subtract_red = glsl_mod(static_cast<float>(gbuffer.texel(LevelGBuffer::Data, gx[l], gy[l])[3]), 30.0f) * 0.003f;
+                float s = sample_nearest_r(noise, u[l] * .5f + info.rain * .1f * info.cloudsSpeed - subtract_red, 1 - v * .5f + info.rain * .2f * info.cloudsSpeed - subtract_red);
+
+                s = .5f + std::sin(glsl_mod(s + clouds * .1f - v, 1) * Pi * 2) * .5f;
+                s = std::clamp(((s - .5f) * 6) + .5f - info.light * 4, 0.0f, 1.0f);
+
+                shadow_amount[l] = (flags[l] & FlagShadowEligible) != 0 ? s : 1.0f;
+                depth[l] = static_cast<float>(red[l] * ((flags[l] & FlagNotFloorDark) != 0)) / 30.0f;
+            }
+
+            // Shadow grab, anything in the occluder mask at the light offset lights the pixel back up
+            if (has_shadow) {
+                for (int l = 0; l < Lanes; ++l) {
+                    if (shadow_amount[l] == 1.0f || red[l] < 5) continue;
+
+                    // Joar's grab coordinates are 0-1 screen positions, zw is the size of a pixel in them
+                    const float offset = static_cast<float>(red[l] - 5);
+                    float grab_x = u[l] * size_x * info.lightDirAndPixelSize.z - info.lightDirAndPixelSize.x * info.lightDirAndPixelSize.z * offset;
+                    float grab_y = frag_y * info.lightDirAndPixelSize.w + info.lightDirAndPixelSize.y * info.lightDirAndPixelSize.w * offset;
+                    grab_x = (grab_x - 0.5f) * (1 + offset / 460.0f) + 0.5f;
+                    grab_y = (grab_y - 0.3f) * (1 + offset / 460.0f) + 0.3f;
+
+                    if (sample_linear_rgb(shadow, grab_x, grab_y) > 0) shadow_amount[l] = 1.0f;
+                }
+            }
+
+            // Geometry color, grime and decals
+            for (int l = 0; l < Lanes; ++l) {
+                const float sh = shadow_amount[l];
+
+                color[l] = mix(
+                    gbuf_color(gbuffer, LevelGBuffer::Shadow0, gx[l], gy[l], info.paletteBlend),
+                    gbuf_color(gbuffer, LevelGBuffer::Shadow1, gx[l], gy[l], info.paletteBlend),
+                    sh
+                );
+
+                const float rbcol = std::sin((info.rain + sample_nearest_r(noise, u[l] * 2, v * 2) * 4 + red[l] / 12.0f) * Pi * 2) * 0.5f + 0.5f;
+                color[l] = mix(color[l], palette(static_cast<int>(5 + rbcol * 25), 6), ((flags[l] & FlagGrime) != 0 ? 0.2f : 0.0f) * info.Grime);
+
+                if ((flags[l] & FlagDecal) != 0) {
+                    const uint8_t *d = gbuffer.texel(LevelGBuffer::Decal, gx[l], gy[l]);
+                    Color decal { unorm(d[0]), unorm(d[1]), unorm(d[2]), unorm(d[3]) };
+                    if ((flags[l] & FlagPalette2) != 0) decal = mix(decal, Color { 1, 1, 1, 1 }, 0.2f - sh * 0.1f);
+                    decal = mix(decal, fog, red[l] / 60.0f);
+
+                    const Color multiplied { color[l].r * decal.r * 1.5f, color[l].g * decal.g * 1.5f, color[l].b * decal.b * 1.5f, color[l].a * decal.a * 1.5f };
+                    const float amount = .9f + ((.3f + .4f * sh) - .9f) * std::clamp((red[l] - 3.5f) * .3f, 0.0f, 1.0f);
+                    color[l] = mix(mix(color[l], decal, .7f), multiplied, amount);
+                }
+                else if ((flags[l] & FlagSwarm) != 0) {
+                    const float blue = unorm(gbuffer.texel(LevelGBuffer::Data, gx[l], gy[l])[2]);
+                    color[l] = mix(color[l], Color { 1, 1, 1, 1 }, blue * info.SwarmRoom);
+                }
+            }
+
+            // Sky pixels only show the background, as fully red for the fog
+            for (int l = 0; l < Lanes; ++l) {
+                if ((flags[l] & FlagSky) == 0) continue;
+
+                color[l] = mix(
+                    gbuf_color(gbuffer, LevelGBuffer::Shadow0, gx[l], gy[l], info.paletteBlend),
+                    Color { info.aboveCloudsAtmosphereColor.x, info.aboveCloudsAtmosphereColor.y, info.aboveCloudsAtmosphereColor.z, info.aboveCloudsAtmosphereColor.w },
+                    info.rimFix
+                );
+                red[l] = 255;
+                depth[l] = 1;
+            }
+
+            // colorParams
+            for (int l = 0; l < Lanes; ++l) {
+                const float not_floor_dark = (flags[l] & FlagNotFloorDark) != 0 ? 1.0f : 0.0f;
+                const float clamp_red = red[l] < 10 ? (not_floor_dark + 1.0f) * .5f : 1.0f;
+                Color c = mix(color[l], fog, std::clamp(red[l] * clamp_red * info.fogAmount / 30.0f, 0.0f, 1.0f));
+
+                c.r = ((c.r * info.darkness - 0.5f) * info.contrast) + 0.5f;
+                c.g = ((c.g * info.darkness - 0.5f) * info.contrast) + 0.5f;
+                c.b = ((c.b * info.darkness - 0.5f) * info.contrast) + 0.5f;
+
+                const float grey = c.r * .222f + c.g * .707f + c.b * .071f;
+                c.r = grey + (c.r - grey) * info.saturation;
+                c.g = grey + (c.g - grey) * info.saturation;
+                c.b = grey + (c.b - grey) * info.saturation;
+
+                // applyHue, Rodrigues' rotation around the grey axis
+                const float dot = k * (c.r + c.g + c.b) * (1 - hue_cos);
+                const float cross_r = k * (c.b - c.g);
+                const float cross_g = k * (c.r - c.b);
+                const float cross_b = k * (c.g - c.r);
+                color[l] = {
+                    c.r * hue_cos + cross_r * hue_sin + k * dot + info.brightness,
+                    c.g * hue_cos + cross_g * hue_sin + k * dot + info.brightness,
+                    c.b * hue_cos + cross_b * hue_sin + k * dot + info.brightness,
+                    c.a,
+                };
+            }
+
+            const int count = std::min(Lanes, target.width - x0);
+            const size_t first = static_cast<size_t>(y) * target.width + x0;
+            for (int l = 0; l < count; ++l) {
+                target.color[(first + l) * 4 + 0] = to_unorm(color[l].r);
+                target.color[(first + l) * 4 + 1] = to_unorm(color[l].g);
+                target.color[(first + l) * 4 + 2] = to_unorm(color[l].b);
+                target.color[(first + l) * 4 + 3] = to_unorm(color[l].a);
+            }
+
+            if (target.depth != nullptr) {
+                for (int l = 0; l < count; ++l) target.depth[first + l] = depth[l];
+            }
+        }
+    });
+}
+
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "../uniforms.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Software port of the level renderer: level_bake.comp and level_shade.glsl on the CPU.
+// Used as a fallback when there's no GPU, as the reference for GPU output and to measure what the shader costs
+namespace soft {
+
+// Pixels shaded per batch. Each step of the shader runs over the whole batch before the next one starts,
+// which keeps a step's loads together. The steps gather from the G-buffer and the noise and branch per pixel,
+// so this is not SIMD: the compiler only vectorizes the final color adjustment
+constexpr int Lanes = 8;
+
+// Tightly packed RGBA8 image, what stb_image gives with 4 channels
+struct Image {
+    const uint8_t *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+};
+
+// CPU copy of the level G-buffer, same layers and 8-bit quantization as the GPU one.
+// See shaders/include/level_gbuffer.glsl
+struct LevelGBuffer {
+    static constexpr int Shadow0 = 0;  // GBUF_SHADOW0
+    static constexpr int Shadow1 = 1;  // GBUF_SHADOW1
+    static constexpr int PaletteB = 2; // GBUF_PALETTE_B
+    static constexpr int Decal = 4;    // GBUF_DECAL
+    static constexpr int Data = 5;     // GBUF_DATA
+    static constexpr int Layers = 6;   // GBUF_LAYERS
+
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> layers[Layers]; // RGBA8 each
+
+    const uint8_t *texel(const int layer, const int x, const int y) const {
+        return &layers[layer][(static_cast<size_t>(y) * width + x) * 4];
+    }
+};
+
+// Where shade_level writes, color is RGBA8 like the draw image and depth is 0-1 like the depth attachment
+struct LevelTarget {
+    uint8_t *color = nullptr; // width * height * 4
+    float *depth = nullptr;   // width * height, can be null
+    int width = 0;
+    int height = 0;
+};
+
+/**
+ * @brief Bakes the static terms of a level, the CPU version of level_bake.comp. Colors are baked for both palettes,
+ * shade_level blends them so fading doesn't need a rebake
+ * @param level level image, its last row holds the decal colors
+ * @param palette_a palette blended from, 32x16
+ * @param palette_b palette blended to, 32x16
+ * @param out resized to the level
+ * @param threads jobs the rows are split into on jobs::JobSystem::shared(), 0 for one per worker plus the caller
+ */
+void bake_level(const Image &level, const Image &palette_a, const Image &palette_b, LevelGBuffer &out, unsigned threads = 0);
+
+/**
+ * @brief Shades a baked level, the CPU version of level_shade.glsl as level.comp runs it
+ * @param info same uniforms the GPU renderers get, paletteBlend blends palette_a and palette_b
+ * @param gbuffer from bake_level with the same two palettes
+ * @param noise noise texture, sampled with repeat like nTex
+ * @param shadow occluder mask, sampled bilinearly through its red channel, empty for no occluders
+ * @param target output, usually the size of the draw image
+ * @param threads jobs the rows are split into on jobs::JobSystem::shared(), 0 for one per worker plus the caller
+ */
+void shade_level(const UniformLevelInfo &info, const LevelGBuffer &gbuffer, const Image &palette_a, const Image &palette_b, const Image &noise, const Image &shadow, const LevelTarget &target, unsigned threads = 0);
+
+}
@@ -1,71 +1,353 @@
 ﻿#include "textures.h"
 
-Texture::Texture(const TextureLease &lease, const uint32_t width, const uint32_t height, const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM) : owner(lease) {
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <ranges>
+#include <span>
+
+Texture::Texture(TextureLease &lease, const uint32_t width, const uint32_t height, const VkFormat format = VK_FORMAT_R8G8B8A8_UNORM, const uint32_t layers) : owner(&lease) {
     image = {};
-    libgui::create_image(lease.VMA, lease.GPU, &image, width, height, 0, format);
+    libgui::create_image(lease.VMA, lease.GPU, &image, width, height, 0, format, VK_IMAGE_ASPECT_COLOR_BIT, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, 0, libgui::MemoryCategory::Textures, layers);
 }
 
 
 Texture::~Texture() {
-    image.dispose();
+    if (index != NoIndex) owner->unbind(*this);
+    if (image.image != VK_NULL_HANDLE) image.dispose();
+}
+
+// FNV-1a, good enough to tell level images apart. Pass the previous hash as seed to hash several files as one
+static uint64_t hash_content(const std::span<const uint8_t> bytes, uint64_t hash = 14695981039346656037ull) {
+    for (const uint8_t byte: bytes) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+static std::vector<uint8_t> read_file(const char *path) {
+    if (!std::filesystem::exists(path)) throw std::runtime_error("Given path doesn't exist: " + std::string(path));
+
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator(file), std::istreambuf_iterator<char>());
+}
+
+static DecodedImage decode_bytes(const std::vector<uint8_t> &bytes, const char *path, const uint64_t content_hash) {
+    int w, h, c;
+    const auto stbi_handle = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &w, &h, &c, STBI_rgb_alpha);
+    if (stbi_handle == nullptr) throw std::runtime_error("Couldn't decode image: " + std::string(path));
+
+    DecodedImage decoded { std::vector<uint8_t>(stbi_handle, stbi_handle + w * h * 4), w, h, content_hash };
+    stbi_image_free(stbi_handle);
+
+    return decoded;
 }
 
 TextureLease::TextureLease(const vkb::Device &device, const VmaAllocator vma) {
     GPU = device;
     VMA = vma;
+
+    // Bindless table
+    constexpr VkSamplerCreateInfo sampler_create {
+        .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+        .magFilter = VK_FILTER_NEAREST,
+        .minFilter = VK_FILTER_NEAREST,
+    };
+    VK_ASSERT( vkCreateSampler(GPU, &sampler_create, nullptr, &BindlessSampler) );
+
+    constexpr VkDescriptorBindingFlags binding_flags[2] = {
+        0,
+        VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT,
+    };
+
+    const VkDescriptorSetLayoutBindingFlagsCreateInfo flags_create {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+        .bindingCount = 2,
+        .pBindingFlags = binding_flags,
+    };
+
+    VK_ASSERT( libgui::descriptor_set_layout(
+        GPU,
+        {
+            VkDescriptorSetLayoutBinding(0, VK_DESCRIPTOR_TYPE_SAMPLER, 1, VK_SHADER_STAGE_FRAGMENT_BIT, &BindlessSampler),
+            VkDescriptorSetLayoutBinding(1, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, MaxBindlessTextures, VK_SHADER_STAGE_FRAGMENT_BIT, nullptr),
+        },
+        &BindlessLayout,
+        VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT,
+        &flags_create
+    ) );
+
+    const libgui::PoolSizeRatio bindless_sizes[2] = {
+        { VK_DESCRIPTOR_TYPE_SAMPLER, 1 },
+        { VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, MaxBindlessTextures },
+    };
+    bindless_pool = libgui::create_descriptor_pool(GPU, 1, bindless_sizes, VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT);
+
+    const VkDescriptorSetAllocateInfo alloc_info {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+        .descriptorPool = bindless_pool,
+        .descriptorSetCount = 1,
+        .pSetLayouts = &BindlessLayout,
+    };
+    VK_ASSERT( vkAllocateDescriptorSets(GPU, &alloc_info, &BindlessSet) );
 }
 
-TexturePtr TextureLease::load_file(const libgui::VkImmediateCommandBuffer &cmd, const char *path, const char *name) {
-    if (!std::filesystem::exists(path)) throw std::runtime_error("Given path doesn't exist: " + std::string(path));
+TexturePtr TextureLease::load_file(const libgui::VkImmediateCommandBuffer &cmd, const char *path, const std::string &name) {
+    if (TexturePtr cached; try_get(name, &cached)) return cached;
 
+    const std::vector<uint8_t> bytes = read_file(path);
+
+    // Same image under another name, share it instead of uploading it twice
+    const uint64_t content_hash = hash_content(bytes);
+    if (const auto found = content_names.find(content_hash); found != content_names.end()) {
+        if (TexturePtr cached; try_get(found->second, &cached)) {
+            insert(name, cached, content_hash);
+            return cached;
+        }
+    }
+
+    return upload(cmd, decode_bytes(bytes, path, content_hash), name);
+}
+
+DecodedImage TextureLease::decode_file(const char *path) {
+    const std::vector<uint8_t> bytes = read_file(path);
+    return decode_bytes(bytes, path, hash_content(bytes));
+}
+
+glm::ivec2 TextureLease::image_size(const char *path) {
     int w, h, c;
-    const auto stbi_handle = stbi_load(path, &w, &h, &c, STBI_rgb_alpha);
+    if (!stbi_info(path, &w, &h, &c)) throw std::runtime_error("Couldn't read image header: " + std::string(path) + " (" + stbi_failure_reason() + ")");
+
+    return { w, h };
+}
+
+TexturePtr TextureLease::upload(const libgui::VkImmediateCommandBuffer &cmd, const DecodedImage &decoded, const std::string &name) {
+    if (TexturePtr cached; try_get(name, &cached)) return cached;
+
+    if (const auto found = content_names.find(decoded.content_hash); found != content_names.end()) {
+        if (TexturePtr cached; try_get(found->second, &cached)) {
+            insert(name, cached, decoded.content_hash);
+            return cached;
+        }
+    }
+
+    const int w = decoded.width;
+    const int h = decoded.height;
 
+    // Creates the VkImage and its view
     const auto return_created = std::make_shared<Texture>(*this, w, h, VK_FORMAT_R8G8B8A8_UNORM);
 
-    // Create the VkImage
-    const auto image_create = libgui::image_create_info(return_created->image.format, VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, VkExtent3D(w, h, 1));
-    constexpr VmaAllocationCreateInfo alloc_create {
-        .usage = VMA_MEMORY_USAGE_GPU_ONLY,
-        .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-    };
+    // Copy the decoded pixels to the VkImage
+    libgui::VkSizedBuffer staging {};
+
+    libgui::cmd_immediate(cmd, [&] {
+        libgui::change_image_layout(cmd.cmd, return_created->image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        libgui::data_to_image(cmd.cmd, staging, VMA, decoded.pixels.data(), w * h * 1 * 4, 0, return_created->image.image, w, h);
+        libgui::change_image_layout(cmd.cmd, return_created->image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    });
+
+    staging.dispose();
+
+    bind(*return_created);
+    insert(name, return_created, decoded.content_hash);
+
+    return return_created;
+}
+
+TexturePtr TextureLease::load_array(const libgui::VkImmediateCommandBuffer &cmd, const std::span<const char* const> paths, const std::string &name) {
+    if (TexturePtr cached; try_get(name, &cached)) return cached;
+    if (paths.empty()) throw std::runtime_error("Texture array needs at least one layer: " + name);
+
+    std::vector<stbi_uc*> layers;
+    uint64_t content_hash = 14695981039346656037ull;
+    int w = 0, h = 0;
 
-    VK_ASSERT(vmaCreateImage(VMA, &image_create, &alloc_create, &return_created->image.image, &return_created->image.allocation, nullptr));
+    for (const char *path: paths) {
+        const std::vector<uint8_t> bytes = read_file(path);
+        content_hash = hash_content(bytes, content_hash);
 
-    // Copy our stbi image to the VkImage
-    libgui::VkSizedBuffer upload {};
+        int layer_w, layer_h, c;
+        const auto stbi_handle = stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &layer_w, &layer_h, &c, STBI_rgb_alpha);
+        if (stbi_handle == nullptr) throw std::runtime_error("Couldn't decode image: " + std::string(path));
+
+        if (layers.empty()) {
+            w = layer_w;
+            h = layer_h;
+        }
+        else if (layer_w != w || layer_h != h) {
+            stbi_image_free(stbi_handle);
+            for (const auto layer: layers) stbi_image_free(layer);
+            throw std::runtime_error("Texture array layers must be the same size: " + std::string(path));
+        }
+
+        layers.push_back(stbi_handle);
+    }
+
+    const auto return_created = std::make_shared<Texture>(*this, w, h, VK_FORMAT_R8G8B8A8_UNORM, static_cast<uint32_t>(layers.size()));
+
+    std::vector<libgui::VkSizedBuffer> uploads(layers.size());
 
     libgui::cmd_immediate(cmd, [&] {
         libgui::change_image_layout(cmd.cmd, return_created->image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        libgui::data_to_image(cmd.cmd, upload, VMA, stbi_handle, w * h * 1 * 4, 0, return_created->image.image, w, h);
+        for (uint32_t i = 0; i < layers.size(); ++i) {
+            libgui::data_to_image(cmd.cmd, uploads[i], VMA, layers[i], w * h * 4, 0, return_created->image.image, w, h, 0, 0, i);
+        }
         libgui::change_image_layout(cmd.cmd, return_created->image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
     });
 
-    stbi_image_free(stbi_handle);
-    upload.dispose();
+    for (const auto layer: layers) stbi_image_free(layer);
+    for (const auto &upload: uploads) upload.dispose();
+
+    insert(name, return_created, content_hash);
+
+    return return_created;
+}
+
+TexturePtr TextureLease::create_empty(const libgui::VkImmediateCommandBuffer &cmd, const uint32_t width, const uint32_t height, const char *name) {
+    const auto return_created = std::make_shared<Texture>(*this, width, height, VK_FORMAT_R8G8B8A8_UNORM);
+
+    libgui::cmd_immediate(cmd, [&] {
+        constexpr VkClearColorValue clear = { {0, 0, 0, 0} };
+        const auto clear_range = libgui::image_subresource_range(VK_IMAGE_ASPECT_COLOR_BIT);
 
-    // Create the view
-    const VkImageViewCreateInfo view_create = libgui::imageview_create_info(return_created->image.format, return_created->image.image, VK_IMAGE_ASPECT_COLOR_BIT);
-    VK_ASSERT(vkCreateImageView(GPU, &view_create, nullptr, &return_created->image.view));
+        libgui::change_image_layout(cmd.cmd, return_created->image.image, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+        vkCmdClearColorImage(cmd.cmd, return_created->image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, &clear, 1, &clear_range);
+        libgui::change_image_layout(cmd.cmd, return_created->image.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    });
 
-    Textures.emplace(name, return_created);
+    bind(*return_created);
+    if (name != nullptr) insert(name, return_created, 0);
 
     return return_created;
 }
 
-bool TextureLease::try_get(const char *name, TexturePtr *texture) const {
-    if (!Textures.contains(name)) return false;
+bool TextureLease::try_get(const std::string &name, TexturePtr *texture) {
+    const auto found = Textures.find(name);
+    if (found == Textures.end()) return false;
+
+    TextureCacheEntry &entry = found->second;
+    TexturePtr alive = entry.texture.lock();
+    if (alive == nullptr) return false;
 
-    *texture = Textures.at(name);
+    entry.pinned = alive;
+    entry.last_used = frame;
+    *texture = std::move(alive);
 
     return true;
 }
 
+void TextureLease::insert(const std::string &name, const TexturePtr &texture, const uint64_t content_hash) {
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(VMA, texture->image.allocation, &info);
+
+    Textures.insert_or_assign(name, TextureCacheEntry {
+        .pinned = texture,
+        .texture = texture,
+        .content_hash = content_hash,
+        .last_used = frame,
+        .bytes = info.size,
+    });
+
+    if (content_hash != 0) content_names.try_emplace(content_hash, name);
+}
+
+void TextureLease::erase_expired() {
+    for (auto it = Textures.begin(); it != Textures.end();) {
+        if (!it->second.texture.expired()) {
+            ++it;
+            continue;
+        }
+
+        if (const auto hashed = content_names.find(it->second.content_hash); hashed != content_names.end() && hashed->second == it->first)
+            content_names.erase(hashed);
+
+        it = Textures.erase(it);
+    }
+}
+
+void TextureLease::end_frame(const float budget_fraction) {
+    ++frame;
+    vmaSetCurrentFrameIndex(VMA, static_cast<uint32_t>(frame));
+
+    const VkPhysicalDeviceMemoryProperties *memory_props;
+    vmaGetMemoryProperties(VMA, &memory_props);
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(VMA, budgets);
+
+    // Integrated GPUs report system RAM as a device local heap too, so this covers both
+    VkDeviceSize over_budget = 0;
+    for (uint32_t i = 0; i < memory_props->memoryHeapCount; ++i) {
+        if (!(memory_props->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)) continue;
+
+        const auto limit = static_cast<VkDeviceSize>(static_cast<double>(budgets[i].budget) * budget_fraction);
+        if (budgets[i].usage > limit) over_budget += budgets[i].usage - limit;
+    }
+
+    if (over_budget > 0) {
+        std::vector<TextureCacheEntry*> candidates;
+        for (auto &entry: Textures | std::views::values)
+            if (entry.pinned != nullptr && entry.last_used < frame - 1) candidates.push_back(&entry);
+
+        std::ranges::sort(candidates, {}, &TextureCacheEntry::last_used);
+
+        // Dropping the pin only frees memory if nothing else holds the texture, keep going until enough was freed
+        for (TextureCacheEntry *entry: candidates) {
+            if (over_budget == 0) break;
+
+            entry->pinned.reset();
+            if (entry->texture.expired()) over_budget -= std::min(over_budget, entry->bytes);
+        }
+    }
+
+    erase_expired();
+}
+
+VkDeviceSize TextureLease::resident_bytes() const {
+    VkDeviceSize total = 0;
+    for (const auto &entry: Textures | std::views::values)
+        if (!entry.texture.expired()) total += entry.bytes;
+
+    return total;
+}
+
+void TextureLease::bind(Texture &texture) {
+    if (!free_indices.empty()) {
+        texture.index = free_indices.back();
+        free_indices.pop_back();
+    }
+    else {
+        if (next_index >= MaxBindlessTextures) throw std::runtime_error("Ran out of bindless texture slots");
+        texture.index = next_index++;
+    }
+
+    libgui::DescriptorLayoutHelper()
+        .image(1, texture.image.view, VK_NULL_HANDLE, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, texture.index)
+        .update_set(GPU, BindlessSet);
+}
+
+void TextureLease::unbind(Texture &texture) {
+    // Slot is partially bound, it can stay stale until it's handed out again
+    free_indices.push_back(texture.index);
+    texture.index = Texture::NoIndex;
+}
+
 void TextureLease::dispose_all() {
     // destructors be damned!
-    for (const auto &texture: Textures | std::views::values) {
+    for (const auto &entry: Textures | std::views::values) {
+        const TexturePtr texture = entry.texture.lock();
+        if (texture == nullptr || texture->image.image == VK_NULL_HANDLE) continue;
+
         texture->image.dispose();
+        texture->image = {};
+        texture->index = Texture::NoIndex;
     }
 
     Textures.clear();
+    content_names.clear();
+
+    vkDestroyDescriptorPool(GPU, bindless_pool, nullptr);
+    vkDestroyDescriptorSetLayout(GPU, BindlessLayout, nullptr);
+    vkDestroySampler(GPU, BindlessSampler, nullptr);
 }
@@ -7,38 +7,130 @@
 
 #include <stb_image.h>
 
-#include <map>
+#include <glm/vec2.hpp>
+
 #include <memory>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
 struct Texture;
 
 // Shared Ptr of Texture
 typedef std::shared_ptr<Texture> TexturePtr;
 
-// TODO: WEAK PTRS FOR THE LIST AS TEXTURES WON'T BE DESTROYED AUTOMATICALLY
-// A leaser for automatically managing textures
+// A cached texture. The cache pins it until it gets evicted, after that only a weak ref is kept
+// so it's still reused for as long as something else holds on to it
+struct TextureCacheEntry {
+    TexturePtr pinned;
+    std::weak_ptr<Texture> texture;
+
+    uint64_t content_hash = 0; // FNV-1a of the source file, 0 for textures made in code
+    uint64_t last_used = 0;    // Frame of the last lookup, for LRU eviction
+    VkDeviceSize bytes = 0;
+};
+
+// An image decoded to RGBA8 but not uploaded yet. Decoding doesn't touch Vulkan so it can happen on any thread
+struct DecodedImage {
+    std::vector<uint8_t> pixels;
+    int width = 0;
+    int height = 0;
+    uint64_t content_hash = 0; // Of the source file, see TextureLease::load_file
+};
+
+// A leaser for automatically managing textures.
+// Textures are cached by name and by file content, unused ones get evicted when VRAM runs low.
+// Every texture is also written into one global bindless table, shaders pick their texture with Texture::index
 class TextureLease {
+    VkDescriptorPool bindless_pool = VK_NULL_HANDLE;
+
+    std::vector<uint32_t> free_indices;
+    uint32_t next_index = 0;
+
+    std::unordered_map<uint64_t, std::string> content_names; // content hash -> first name it was loaded as
+    uint64_t frame = 0;
+
+    void insert(const std::string &name, const TexturePtr &texture, uint64_t content_hash);
+
+    void erase_expired();
+
 public:
+    static constexpr uint32_t MaxBindlessTextures = 1024;
+
+    // Fraction of a device local heap's budget the cache tries to stay under
+    static constexpr float DefaultBudgetFraction = 0.8f;
+
     vkb::Device GPU;
     VmaAllocator VMA;
-    std::pmr::map<const char*, TexturePtr> Textures;
+    std::unordered_map<std::string, TextureCacheEntry> Textures;
+
+    // binding 0: immutable nearest sampler, binding 1: texture2D[MaxBindlessTextures], partially bound
+    VkSampler BindlessSampler = VK_NULL_HANDLE;
+    VkDescriptorSetLayout BindlessLayout = VK_NULL_HANDLE;
+    VkDescriptorSet BindlessSet = VK_NULL_HANDLE;
 
     TextureLease(const vkb::Device &device, VmaAllocator vma);
 
-    TexturePtr load_file(const libgui::VkImmediateCommandBuffer &cmd, const char *path, const char *name);
+    TextureLease(const TextureLease&) = delete;
+    TextureLease& operator=(const TextureLease&) = delete;
 
-    bool try_get(const char *name, TexturePtr *texture) const;
+    // Returns the cached texture if either the name or the file's content was already loaded
+    TexturePtr load_file(const libgui::VkImmediateCommandBuffer &cmd, const char *path, const std::string &name);
+
+    // Reads and decodes an image file. Thread safe, pair it with upload on the render thread
+    static DecodedImage decode_file(const char *path);
+
+    // Reads only the header of an image file. Thread safe, throws if it isn't an image
+    static glm::ivec2 image_size(const char *path);
+
+    // Uploads a decoded image, or returns the cached texture if the name or the content was already loaded
+    TexturePtr upload(const libgui::VkImmediateCommandBuffer &cmd, const DecodedImage &decoded, const std::string &name);
+
+    // Loads same sized images into the layers of one 2D array texture, in order.
+    // Array textures can't go in the bindless table, bind their view directly
+    TexturePtr load_array(const libgui::VkImmediateCommandBuffer &cmd, std::span<const char* const> paths, const std::string &name);
+
+    // Creates a transparent texture to be filled in later, e.g. an atlas page. Not listed if name is null
+    TexturePtr create_empty(const libgui::VkImmediateCommandBuffer &cmd, uint32_t width, uint32_t height, const char *name);
+
+    // Looks up a texture by name, re-pins it if it was evicted but is still alive
+    bool try_get(const std::string &name, TexturePtr *texture);
+
+    // Advances the LRU clock and evicts least recently used textures while a device local heap is over budget.
+    // Call once per frame after the GPU is done with the frame's work
+    void end_frame(float budget_fraction = DefaultBudgetFraction);
+
+    // Bytes of textures the cache still holds alive
+    VkDeviceSize resident_bytes() const;
+
+    // Takes a free slot of the bindless table and points it at the texture
+    void bind(Texture &texture);
+
+    // Returns the texture's slot to the free list
+    void unbind(Texture &texture);
 
     void dispose_all();
 };
 
 // A VMA allocated image with a leaser
 struct Texture {
-    TextureLease owner;
+    static constexpr uint32_t NoIndex = UINT32_MAX;
+
+    TextureLease *owner;
 
     libgui::VkAllocatedImage image {};
+    uint32_t index = NoIndex; // Slot in the bindless table
 
-    explicit Texture(const TextureLease &lease, uint32_t width, uint32_t height, VkFormat format);
+    explicit Texture(TextureLease &lease, uint32_t width, uint32_t height, VkFormat format, uint32_t layers = 1);
 
     ~Texture();
 };
+
+// A sub-rectangle of a texture, e.g. a sprite packed into an atlas page
+struct AtlasRegion {
+    uint32_t texture = Texture::NoIndex; // Bindless index of the page
+    glm::vec2 uv_min {0};
+    glm::vec2 uv_max {1};
+    glm::vec2 size {0}; // Size of the sprite in pixels
+};
@@ -1,6 +1,7 @@
 ﻿#pragma once
 
 #include <glm/glm.hpp>
+#include <cstdint>
 
 // Standard scene info
 struct UniformSceneInfo {
@@ -34,4 +35,22 @@ struct UniformLevelInfo {
 
     glm::vec4 aboveCloudsAtmosphereColor;
     float     rimFix;
+
+    int       paletteA;     // Layers of the palette array
+    int       paletteB;
+    float     paletteBlend; // 0 is all A, 1 is all B
+};
+
+// Push constants of level_bake.comp
+struct PushLevelBake {
+    int paletteA;
+    int paletteB;
+
+    bool operator==(const PushLevelBake&) const = default;
+};
+
+// Push constants of level_classify.comp
+struct PushLevelClassify {
+    glm::ivec2 screenSize;
+    uint32_t   tileStride; // Tiles in each class' list
 };
@@ -0,0 +1,112 @@
+#include "rendering.h"
+#include "custom/geometry.h"
+#include "custom/rope.h"
+
+#include <vector>
+
+// Vines hanging from the ceilings of the room, all of them ropes in the scene's rope system drawn in a few batched draws
+class SceneVines final : public SceneObject_T {
+    std::shared_ptr<Scene> scene;
+
+    AtlasRegion white_region;
+    LeasedPipeline pipeline;
+
+    // Filled by every poll, kept so drawing doesn't allocate
+    std::vector<glm::vec2> outline;
+    std::vector<uint32_t> strips;
+
+    glm::vec2 wind {0};
+    int iterations; // The rope system's, set between ticks
+
+public:
+    static constexpr int ColumnStep = 3;       // Tiles between vines
+    static constexpr float SegmentLength = 5.0f;
+    static constexpr float Radius = 1.5f;
+
+    explicit SceneVines(const std::shared_ptr<Scene> &scene, RoomGeometry &room)
+        : scene(scene) {
+        constexpr uint8_t white[4] = { 255, 255, 255, 255 };
+        white_region = this->scene->Atlas.add_pixels(this->scene->ImmediateCmd, "white", 1, 1, white);
+
+        // basic sprite pipeline
+        VkShaderModule basic_vert;
+        VkShaderModule basic_frag;
+
+        libgui::vulkan_create_shader_from_file(scene->GPU, &basic_vert, "shaders/basic_sprite.vert.spv");
+        libgui::vulkan_create_shader_from_file(scene->GPU, &basic_frag, "shaders/basic_sprite.frag.spv");
+
+        pipeline = scene->PipelineLeaser.ensure_pipeline(
+            scene->GPU,
+            scene->DrawImage.format,
+            { scene->UniversalSetLayout, scene->TextureLeaser->BindlessLayout },
+            { "shaders/basic_sprite.vert.spv", "shaders/basic_sprite.frag.spv" },
+            { {basic_vert, VK_SHADER_STAGE_VERTEX_BIT}, {basic_frag, VK_SHADER_STAGE_FRAGMENT_BIT} }
+        );
+
+        vkDestroyShaderModule(scene->GPU, basic_vert, nullptr);
+        vkDestroyShaderModule(scene->GPU, basic_frag, nullptr);
+
+        plant(room);
+        iterations = scene->Ropes.getIterations();
+    }
+
+    // Replaces every rope of the scene with vines under the ceilings of room, on the simulation thread once it started
+    void plant(RoomGeometry &room) {
+        RopeSystem &ropes = scene->Ropes;
+        ropes.clear();
+        ropes.setRoom(room);
+
+        for (int x = 1; x < room.getXSize(); x += ColumnStep) {
+            for (int y = room.getYSize() - 1; y > 0; --y) {
+                // Air under solid, a vine of 2 to 7 tiles grows down from the bottom edge
+                if (room.getTileType(x, y) != 1 || room.getTileType(x, y - 1) == 1) continue;
+
+                int length = 2 + (x * 7 + y * 3) % 6;
+                for (int free = 1; free <= length; ++free) {
+                    if (y - free < 0 || room.getTileType(x, y - free) == 1) {
+                        length = free - 1;
+                        break;
+                    }
+                }
+                if (length < 1) continue;
+
+                const glm::vec2 top(static_cast<float>(x) * 20.0f + 10.0f, static_cast<float>(y) * 20.0f);
+                const glm::vec2 bottom = top - glm::vec2(0, static_cast<float>(length) * 20.0f - Radius);
+                const size_t rope = ropes.add(top, bottom, static_cast<uint32_t>(glm::length(top - bottom) / SegmentLength), Radius);
+                ropes.pin(rope, 0);
+            }
+        }
+    }
+
+    // Stepped by the scene's rope system on the simulation thread
+    void physics_tick(Scene *scene) override {
+
+    }
+
+    void frame_update(Scene *scene) override {
+        const SceneState &state = scene->States.front();
+
+        ImGui::Begin("Vines");
+
+        if (ImGui::SliderFloat("Wind", &wind.x, -0.5f, 0.5f)) {
+            scene->post([gravity = glm::vec2(wind.x, -0.5f)](Scene &sim) { sim.Ropes.setGravity(gravity); });
+        }
+
+        if (ImGui::SliderInt("Iterations", &iterations, 1, 32)) {
+            scene->post([iterations = iterations](Scene &sim) { sim.Ropes.setIterations(iterations); });
+        }
+
+        ImGui::Text("%zu ropes, %zu points", state.rope_count, state.rope_points);
+        ImGui::Text("Step: %.3f ms, average %.3f ms", state.rope_stats.last_ms, state.rope_stats.average_ms);
+
+        ImGui::End();
+    }
+
+    void poll_draw() override {
+        scene->rope_outline(outline, strips);
+
+        constexpr glm::vec4 green { 0.2f, 0.45f, 0.15f, 1.0f };
+        pipeline->poller.make_strips(outline, strips, scene->Camera.offset, -4, green, scene->UniversalSet, scene->TextureLeaser->BindlessSet, white_region);
+        scene->ShadowPoller.make_strips(outline, strips, scene->Camera.offset, -4, green, scene->UniversalSet, scene->TextureLeaser->BindlessSet, white_region);
+    }
+};
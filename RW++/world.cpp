@@ -0,0 +1,189 @@
+#pragma once
+
+#include "custom/cameras.h"
+#include "custom/descriptor.h"
+#include "custom/geometry.h"
+#include "custom/region.h"
+#include "jobs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+// Everything a room needs to become the current one, prepared off the main thread
+struct StreamedRoom {
+    RoomDescriptor descriptor;
+    RoomGeometry geometry;
+
+    DecodedImage first_image; // First camera's level image, emptied once uploaded
+    TexturePtr image;         // Set on the main thread, the room is ready once this is
+
+    size_t bytes = 0; // Geometry and level image, counted against WorldStreamer::Budget
+};
+
+typedef std::shared_ptr<StreamedRoom> StreamedRoomPtr;
+
+// Keeps the current room of a region and its neighbours loaded.
+// Rooms are read, parsed and decoded on worker threads, only the texture upload happens in frame_update.
+// Entering a loaded room is a pointer swap, rooms far away get evicted once the loaded ones go over budget
+class WorldStreamer {
+    std::shared_ptr<Scene> scene;
+    RegionMap region;
+    std::string level_directory;
+
+    std::unordered_map<std::string, StreamedRoomPtr> loaded;
+    std::unordered_map<std::string, std::future<StreamedRoomPtr>> loading;
+
+    std::string current;
+    std::string requested; // Picked in the UI, entered once it's ready
+
+    size_t loaded_bytes = 0;
+    uint32_t evictions = 0;
+    uint32_t failures = 0; // Loads that threw, see frame_update
+
+    static StreamedRoomPtr load(const std::string &level_directory, const std::string &name) {
+        const std::string file = level_directory + name + ".txt";
+
+        auto room = std::make_shared<StreamedRoom>(RoomDescriptor::fromFile(file), RoomGeometry::fromFile(file));
+
+        // SceneLevel's G-buffer is one view in size, a camera image that doesn't match can't be shown
+        const glm::ivec2 view_size(RoomCameras::ViewWidth, RoomCameras::ViewHeight);
+        for (size_t camera = 0; camera < room->descriptor.cameras.size(); ++camera) {
+            const std::string path = room->descriptor.getImagePath(level_directory, static_cast<int>(camera));
+            if (TextureLease::image_size(path.c_str()) != view_size)
+                throw std::runtime_error("Camera image isn't the size of a view: " + path);
+        }
+
+        room->first_image = TextureLease::decode_file(room->descriptor.getImagePath(level_directory, 0).c_str());
+        room->bytes = room->geometry.getXSize() * room->geometry.getYSize() * sizeof(int) + room->first_image.pixels.size();
+
+        return room;
+    }
+
+    void start_loading(const std::string &name) {
+        if (loaded.contains(name) || loading.contains(name)) return;
+
+        loading.emplace(name, jobs::JobSystem::shared().async("load room", [directory = level_directory, name] { return load(directory, name); }));
+    }
+
+    // Takes a finished load, the upload needs the GPU to be idle
+    void finish_loading(const std::string &name, StreamedRoomPtr room) {
+        const std::string path = room->descriptor.getImagePath(level_directory, 0);
+        room->image = scene->TextureLeaser->upload(scene->ImmediateCmd, room->first_image, path);
+        room->first_image = {};
+
+        loaded_bytes += room->bytes;
+        loaded.emplace(name, std::move(room));
+    }
+
+    // Drops rooms outside of the neighbourhood until the loaded ones fit the budget
+    void evict(const std::vector<std::string> &keep) {
+        if (loaded_bytes <= Budget) return;
+
+        std::vector<std::string> far;
+        for (const auto &[name, room]: loaded) {
+            if (name != current && std::ranges::find(keep, name) == keep.end()) far.push_back(name);
+        }
+
+        for (const std::string &name: far) {
+            if (loaded_bytes <= Budget) break;
+
+            // The level and colliders may still hold on to it, the memory goes once they let go
+            loaded_bytes -= loaded[name]->bytes;
+            loaded.erase(name);
+            evictions++;
+        }
+    }
+
+public:
+    static constexpr int PrefetchDepth = 1; // Connections away from the current room that are kept loaded
+
+    size_t Budget = 64 * 1024 * 1024; // Bytes of loaded rooms before far ones get dropped
+
+    WorldStreamer(const std::shared_ptr<Scene> &scene, const char *world_file, const char *level_directory)
+        : scene(scene), region(RegionMap::fromFile(world_file)), level_directory(level_directory) {}
+
+    // Blocks until the room is loaded and makes it the current one, for the first room
+    StreamedRoomPtr enter(const std::string &name) {
+        if (!region.contains(name)) throw std::runtime_error("Room isn't in the region: " + name);
+
+        if (!loaded.contains(name)) {
+            start_loading(name);
+
+            auto pending = loading.extract(name);
+            finish_loading(name, pending.mapped().get());
+        }
+
+        current = name;
+        requested.clear();
+
+        for (const std::string &neighbour: region.neighbours(current, PrefetchDepth)) start_loading(neighbour);
+
+        return loaded[name];
+    }
+
+    const std::string & current_room() const { return current; }
+
+    // Asks for a room change, it happens in frame_update once the room is loaded
+    void request(const std::string &name) {
+        if (!region.contains(name)) throw std::runtime_error("Room isn't in the region: " + name);
+
+        requested = name;
+        start_loading(name);
+    }
+
+    /**
+     * @brief Uploads finished rooms, evicts far ones and switches to the requested room once it's ready.\n
+     * Only call while the GPU is idle
+     * @return the room that became current this frame, null if it didn't change
+     */
+    StreamedRoomPtr frame_update() {
+        for (auto it = loading.begin(); it != loading.end();) {
+            if (it->second.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+                ++it;
+                continue;
+            }
+
+            // A room that fails to load is left out, the current one and the rest stay as they are
+            try {
+                finish_loading(it->first, it->second.get());
+            }
+            catch (const std::exception &e) {
+                wlog::logf(wlog::WLOG_ERROR, "Couldn't load room %s: %s", it->first.c_str(), e.what());
+                failures++;
+                if (requested == it->first) requested.clear();
+            }
+
+            it = loading.erase(it);
+        }
+
+        StreamedRoomPtr entered;
+        if (!requested.empty() && requested != current && loaded.contains(requested)) entered = enter(requested);
+        else if (requested == current) requested.clear();
+
+        evict(region.neighbours(current, PrefetchDepth));
+
+        ImGui::Begin("World");
+
+        ImGui::Text("Room: %s", current.c_str());
+        ImGui::Text("Loaded: %zu rooms, %.1f / %.1f MB", loaded.size(), loaded_bytes / (1024.0 * 1024.0), Budget / (1024.0 * 1024.0));
+        ImGui::Text("Loading: %zu, evicted: %u, failed: %u", loading.size(), evictions, failures);
+
+        ImGui::SeparatorText("Rooms");
+        for (const RegionMap::Room &room: region.getRooms()) {
+            const char *state = loaded.contains(room.name) ? "loaded" : loading.contains(room.name) ? "loading" : "";
+            const std::string label = room.name + (room.tag.empty() ? "" : " (" + room.tag + ")");
+
+            if (ImGui::Selectable(label.c_str(), room.name == current || room.name == requested)) request(room.name);
+            ImGui::SameLine(200);
+            ImGui::TextDisabled("%s", state);
+        }
+
+        ImGui::End();
+
+        return entered;
+    }
+};
@@ -0,0 +1,121 @@
+// Physics tick cost of body chunk variants with their features compiled in, against the same features as runtime flags.
+//   bench_chunk_variants [chunks] [ticks] [repetitions]
+// Both of a pair have to end on the same checksum, only the time may differ.
+// Each pair runs several times, alternating between the two, and reports the median and the spread
+
+#include "custom/physics.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct NoSubstepFeatures : DefaultChunkFeatures {
+    static constexpr bool Substeps = false;
+};
+
+struct FloorlessFeatures : DefaultChunkFeatures {
+    static constexpr bool GoThroughFloors = true;
+};
+
+struct GhostFeatures : DefaultChunkFeatures {
+    static constexpr bool CollideWithTerrain = false;
+};
+
+// The compiled in flags of Features as runtime ones
+template<typename Features>
+RuntimeChunkFeatures runtime() {
+    return RuntimeChunkFeatures { Features::DoUpdate, Features::CollideWithTerrain, Features::GoThroughFloors, Features::Substeps };
+}
+
+struct Result {
+    double ms;
+    unsigned long long checksum;
+};
+
+template<typename Features>
+Result simulate(RoomGeometry &room, const int chunk_count, const int ticks, const Features features = {}) {
+    BasicPhysicsWorld<Features> world;
+
+    // Spread out over the room so most of the cost is the chunks against the terrain, some fast enough to substep
+    for (int i = 0; i < chunk_count; ++i) {
+        const int x = 2 + i * 2;
+        const int y = 3 + (i % 4) * 3;
+        const size_t index = world.add(BasicBodyChunk<Features>(glm::vec2(x * 20.0f + 10.0f, y * 20.0f + 10.0f), 1.0f, 6.0f, 0.02f, 0.4f, room, features), glm::vec2(0, -1));
+        world.getChunk(index).setVelocity(glm::vec2(static_cast<float>(i % 7) - 3.0f, static_cast<float>(i % 5)) * 2.0f);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; ++i) world.step();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    return Result { elapsed.count() / ticks, static_cast<unsigned long long>(world.checksum()) };
+}
+
+struct Spread {
+    double median, min, max;
+};
+
+Spread spread(std::vector<double> samples) {
+    std::ranges::sort(samples);
+
+    const size_t middle = samples.size() / 2;
+    const double median = samples.size() % 2 == 1 ? samples[middle] : (samples[middle - 1] + samples[middle]) / 2;
+    return Spread { median, samples.front(), samples.back() };
+}
+
+template<typename Features>
+void compare(const char *name, RoomGeometry &room, const int chunk_count, const int ticks, const int repetitions) {
+    std::vector<double> compiled_ms, flags_ms;
+    unsigned long long compiled_checksum = 0, flags_checksum = 0;
+    bool mismatch = false;
+
+    for (int i = 0; i < repetitions; ++i) {
+        const Result compiled = simulate<Features>(room, chunk_count, ticks);
+        const Result flags = simulate<RuntimeChunkFeatures>(room, chunk_count, ticks, runtime<Features>());
+
+        compiled_ms.push_back(compiled.ms);
+        flags_ms.push_back(flags.ms);
+        compiled_checksum = compiled.checksum;
+        flags_checksum = flags.checksum;
+        mismatch |= compiled.checksum != flags.checksum;
+    }
+
+    const Spread compiled = spread(compiled_ms);
+    const Spread flags = spread(flags_ms);
+
+    std::printf(
+        "%-10s compiled %.3f ms per tick (%.3f-%.3f), runtime flags %.3f ms (%.3f-%.3f), %.2fx, checksums %016llx %016llx%s\n",
+        name, compiled.median, compiled.min, compiled.max, flags.median, flags.min, flags.max, flags.median / compiled.median,
+        compiled_checksum, flags_checksum, mismatch ? " MISMATCH" : ""
+    );
+}
+
+}
+
+int main(const int argc, char **argv) {
+    const int chunk_count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 4000;
+    const int ticks = argc > 2 ? std::max(1, std::atoi(argv[2])) : 200;
+    const int repetitions = argc > 3 ? std::max(1, std::atoi(argv[3])) : 7;
+
+    // Long room with solid borders and a floor every few rows for the chunks to bounce between
+    const int width = chunk_count * 2 + 4;
+    const int height = 20;
+    std::vector<int> tiles(width * height, 0);
+    for (int x = 0; x < width; ++x) tiles[x] = tiles[(height - 1) * width + x] = 1;
+    for (int x = 0; x < width; x += 3) tiles[10 * width + x] = 1;
+    for (int y = 0; y < height; ++y) tiles[y * width] = tiles[y * width + width - 1] = 1;
+    RoomGeometry room(width, height, tiles);
+
+    std::printf("%d chunks, %d ticks, %d repetitions, median (min-max)\n", chunk_count, ticks, repetitions);
+    compare<DefaultChunkFeatures>("default", room, chunk_count, ticks, repetitions);
+    compare<NoSubstepFeatures>("no substep", room, chunk_count, ticks, repetitions);
+    compare<FloorlessFeatures>("floorless", room, chunk_count, ticks, repetitions);
+    compare<GhostFeatures>("ghost", room, chunk_count, ticks, repetitions);
+
+    return 0;
+}
@@ -0,0 +1,76 @@
+// Overhead and scaling of the job system: empty jobs, dependency chains and parallel_for over a compute kernel.
+//   bench_jobs [workers] [iterations]
+
+#include "jobs.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+template<typename Fn>
+double time_ms(const int iterations, const Fn &fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) fn();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+// Something with enough arithmetic per index that scaling isn't memory bound
+void kernel(std::vector<float> &data, const size_t begin, const size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        float x = data[i];
+        for (int k = 0; k < 32; ++k) x = std::sin(x) * 0.5f + std::cos(x * 1.3f);
+        data[i] = x;
+    }
+}
+
+}
+
+int main(const int argc, char **argv) {
+    const unsigned workers = argc > 1 ? static_cast<unsigned>(std::max(1, std::atoi(argv[1]))) : std::max(2u, std::thread::hardware_concurrency()) - 1;
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+    jobs::JobSystem system(workers);
+    std::printf("%u workers, %d iterations\n", system.worker_count(), iterations);
+
+    // Submit and wait on many empty jobs, the per job cost
+    constexpr int empty_jobs = 10000;
+    const double empty_ms = time_ms(iterations, [&] {
+        std::vector<jobs::JobPtr> submitted;
+        submitted.reserve(empty_jobs);
+        for (int i = 0; i < empty_jobs; ++i) submitted.push_back(system.submit("empty", [] {}));
+        for (const auto &job: submitted) system.wait(job);
+    });
+    std::printf("empty jobs:       %8.3f ms per %d, %6.0f ns per job\n", empty_ms, empty_jobs, empty_ms * 1e6 / empty_jobs);
+
+    // A chain where every job depends on the previous one, the scheduling latency
+    constexpr int chain_length = 2000;
+    const double chain_ms = time_ms(iterations, [&] {
+        jobs::JobPtr previous;
+        for (int i = 0; i < chain_length; ++i) previous = system.submit("chain", [] {}, { previous });
+        system.wait(previous);
+    });
+    std::printf("dependency chain: %8.3f ms per %d, %6.0f ns per link\n", chain_ms, chain_length, chain_ms * 1e6 / chain_length);
+
+    // parallel_for against the same work on the calling thread
+    std::vector<float> data(1 << 18);
+    for (size_t i = 0; i < data.size(); ++i) data[i] = static_cast<float>(i % 97) * 0.01f;
+
+    const double serial_ms = time_ms(iterations, [&] { kernel(data, 0, data.size()); });
+    std::printf("kernel serial:    %8.3f ms\n", serial_ms);
+
+    for (const size_t grain: { size_t(256), size_t(4096), data.size() / (system.worker_count() + 1) }) {
+        const double parallel_ms = time_ms(iterations, [&] {
+            system.parallel_for(0, data.size(), grain, [&](const size_t begin, const size_t end) { kernel(data, begin, end); });
+        });
+        std::printf("parallel_for grain %6zu: %8.3f ms, %.2fx\n", grain, parallel_ms, serial_ms / parallel_ms);
+    }
+
+    return 0;
+}
@@ -0,0 +1,116 @@
+// Throughput of the software level renderer at the draw image's 1400x800.
+// Run from the build directory so the assets resolve, optionally pass a level image and iteration count:
+//   bench_level_cpu [assets/levels/SU_A40.png] [iterations]
+
+#define STB_IMAGE_IMPLEMENTATION
+#include <stb_image.h>
+
+#include "jobs.h"
+#include "soft/level_cpu.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+struct LoadedImage {
+    stbi_uc *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+
+    explicit LoadedImage(const char *path) {
+        int channels;
+        pixels = stbi_load(path, &width, &height, &channels, STBI_rgb_alpha);
+        if (pixels == nullptr) {
+            std::fprintf(stderr, "couldn't load %s: %s\n", path, stbi_failure_reason());
+            std::exit(1);
+        }
+    }
+
+    ~LoadedImage() { stbi_image_free(pixels); }
+
+    LoadedImage(const LoadedImage&) = delete;
+    LoadedImage& operator=(const LoadedImage&) = delete;
+
+    soft::Image view() const { return { pixels, width, height }; }
+};
+
+// FNV-1a of the output, to compare runs and thread counts
+uint64_t checksum(const std::vector<uint8_t> &data) {
+    uint64_t hash = 14695981039346656037ull;
+    for (const uint8_t byte: data) {
+        hash ^= byte;
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+template<typename Fn>
+double time_ms(const int iterations, const Fn &fn) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) fn();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    return elapsed.count() / iterations;
+}
+
+}
+
+int main(const int argc, char **argv) {
+    const char *level_path = argc > 1 ? argv[1] : "assets/levels/SU_A40.png";
+    const int iterations = argc > 2 ? std::max(1, std::atoi(argv[2])) : 20;
+
+    const LoadedImage level(level_path);
+    const LoadedImage palette("assets/palettes/palette0.png");
+    const LoadedImage noise("assets/noise.png");
+
+    constexpr int width = 1400;
+    constexpr int height = 800;
+
+    // Same uniforms SceneLevel renders with
+    UniformLevelInfo info {};
+    info.texelSize = glm::ivec2(width, height);
+    info.lightDirAndPixelSize = glm::vec4(1, 1, 1.0f / width, 1.0f / height);
+    info.Grime = 1;
+    info.darkness = 1;
+    info.contrast = 1;
+    info.saturation = 1;
+    info.aboveCloudsAtmosphereColor = glm::vec4(1);
+
+    std::vector<uint8_t> color(static_cast<size_t>(width) * height * 4);
+    std::vector<float> depth(static_cast<size_t>(width) * height);
+    const soft::LevelTarget target { color.data(), depth.data(), width, height };
+
+    soft::LevelGBuffer gbuffer;
+    const unsigned hardware = jobs::JobSystem::shared().worker_count() + 1;
+
+    std::printf("level %s, %dx%d, %d iterations, %d lanes\n", level_path, width, height, iterations, soft::Lanes);
+
+    std::vector<unsigned> thread_counts { 1 };
+    if (hardware > 1) thread_counts.push_back(hardware);
+
+    for (const unsigned threads: thread_counts) {
+        const double bake_ms = time_ms(iterations, [&] {
+            soft::bake_level(level.view(), palette.view(), palette.view(), gbuffer, threads);
+        });
+
+        const double shade_ms = time_ms(iterations, [&] {
+            info.rain += 0.01f; // The animated terms move like they would between frames
+            soft::shade_level(info, gbuffer, palette.view(), palette.view(), noise.view(), {}, target, threads);
+        });
+
+        // The checksum is of a fixed frame so it's comparable between thread counts
+        info.rain = 0;
+        soft::shade_level(info, gbuffer, palette.view(), palette.view(), noise.view(), {}, target, threads);
+
+        std::printf(
+            "%2u jobs: bake %7.2f ms, shade %7.2f ms (%6.1f Mpix/s), checksum %016llx\n",
+            threads, bake_ms, shade_ms, width * height / (shade_ms * 1000.0),
+            static_cast<unsigned long long>(checksum(color))
+        );
+    }
+
+    return 0;
+}
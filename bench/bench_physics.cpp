@@ -0,0 +1,77 @@
+// Physics tick cost with many chunks in one room, mostly the chunk against chunk broadphase.
+//   bench_physics [chunks] [ticks] [workers]
+// workers 0 steps on the calling thread
+
+#include "jobs.h"
+#include "custom/history.h"
+#include "custom/physics.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+int main(const int argc, char **argv) {
+    const int chunk_count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 10000;
+    const int ticks = argc > 2 ? std::max(2, std::atoi(argv[2])) : 400;
+    const int workers = argc > 3 ? std::max(0, std::atoi(argv[3])) : 0;
+
+    // Long room with solid borders, the chunks drop from different heights and end up lying on the floor next to each other
+    const int width = chunk_count * 2 + 4;
+    const int height = 20;
+    std::vector<int> tiles(width * height, 0);
+    for (int x = 0; x < width; ++x) tiles[x] = tiles[(height - 1) * width + x] = 1;
+    for (int y = 0; y < height; ++y) tiles[y * width] = tiles[y * width + width - 1] = 1;
+    RoomGeometry room(width, height, tiles);
+
+    PhysicsWorld world;
+    std::unique_ptr<jobs::JobSystem> system;
+    if (workers > 0) {
+        system = std::make_unique<jobs::JobSystem>(workers);
+        world.setRunner([&](const size_t count, const std::function<void(size_t)> &batch) {
+            system->parallel_for(0, count, 1, [&](const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; ++i) batch(i);
+            });
+        });
+    }
+
+    for (int i = 0; i < chunk_count; ++i) {
+        const int x = 2 + i * 2;
+        const int y = 3 + (i % 4) * 3;
+        const size_t index = world.add(BodyChunk(glm::vec2(x * 20.0f + 10.0f, y * 20.0f + 10.0f), 1.0f + static_cast<float>(i % 3), 10.0f, 0.02f, 0.2f, room), glm::vec2(0, -1));
+        world.getChunk(index).setVelocity(glm::vec2(static_cast<float>(i % 7) - 3.0f, 0) * 0.5f);
+    }
+
+    // The first half is mostly falling and settling, by the second most chunks should be asleep
+    const auto time_ticks = [&](const int count) {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < count; ++i) world.step();
+        const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        return elapsed.count() / count;
+    };
+
+    const double settling_ms = time_ticks(ticks / 2);
+    const double settled_ms = time_ticks(ticks - ticks / 2);
+
+    // What the scene pays every tick to be able to roll back, two rounds through the ring so the second one finds it allocated
+    PhysicsHistory history;
+    std::chrono::duration<double, std::micro> snapshot_elapsed {0};
+    for (size_t i = 0; i < history.getCapacity() * 2; ++i) {
+        const auto snapshot_start = std::chrono::steady_clock::now();
+        history.save(world);
+        if (i >= history.getCapacity()) snapshot_elapsed += std::chrono::steady_clock::now() - snapshot_start;
+        world.step();
+    }
+    const double snapshot_us = snapshot_elapsed.count() / static_cast<double>(history.getCapacity());
+
+    std::printf(
+        "%d chunks, %d ticks, %d workers: %.3f ms per tick settling, %.3f ms settled, %zu awake at the end, %llu broadphase rebuilds, %zu buckets, %.2f us per snapshot, checksum %016llx\n",
+        chunk_count, ticks, workers, settling_ms, settled_ms, world.getActiveCount(),
+        static_cast<unsigned long long>(world.getBroadphase().getRebuilds()), world.getBroadphase().getBucketCount(), snapshot_us,
+        static_cast<unsigned long long>(world.checksum())
+    );
+
+    return 0;
+}
@@ -0,0 +1,65 @@
+// Rope tick cost for many long ropes in one room, hanging from the ceiling and draped over a row of pillars.
+//   bench_ropes [ropes] [segments] [ticks] [workers]
+// workers 0 steps on the calling thread
+
+#include "jobs.h"
+#include "custom/rope.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+int main(const int argc, char **argv) {
+    const int rope_count = argc > 1 ? std::max(1, std::atoi(argv[1])) : 500;
+    const int segments = argc > 2 ? std::max(1, std::atoi(argv[2])) : 100;
+    const int ticks = argc > 3 ? std::max(1, std::atoi(argv[3])) : 200;
+    const int workers = argc > 4 ? std::max(0, std::atoi(argv[4])) : 0;
+
+    // Solid border and a pillar every fourth column up to half the height
+    const int width = 200;
+    const int height = 60;
+    std::vector<int> tiles(width * height, 0);
+    for (int x = 0; x < width; ++x) tiles[x] = tiles[(height - 1) * width + x] = 1;
+    for (int y = 0; y < height; ++y) tiles[y * width] = tiles[y * width + width - 1] = 1;
+    for (int x = 2; x < width; x += 4) {
+        for (int y = height / 2; y < height; ++y) tiles[y * width + x] = 1;
+    }
+    RoomGeometry room(width, height, tiles);
+
+    RopeSystem ropes;
+    ropes.setRoom(room);
+    std::unique_ptr<jobs::JobSystem> system;
+    if (workers > 0) {
+        system = std::make_unique<jobs::JobSystem>(workers);
+        ropes.setRunner([&](const size_t count, const std::function<void(size_t)> &batch) {
+            system->parallel_for(0, count, 1, [&](const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; ++i) batch(i);
+            });
+        });
+    }
+
+    for (int i = 0; i < rope_count; ++i) {
+        const glm::vec2 top(40.0f + static_cast<float>(i % 190) * 20.0f + static_cast<float>(i / 190) * 3.0f, (height - 2) * 20.0f);
+        const size_t rope = ropes.add(top, top + glm::vec2(300, 0), segments, 2.0f);
+        ropes.pin(rope, 0);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; ++i) ropes.step();
+    const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::vector<glm::vec2> outline;
+    std::vector<uint32_t> strips;
+    const auto outline_start = std::chrono::steady_clock::now();
+    ropes.outline(outline, strips);
+    const std::chrono::duration<double, std::milli> outline_elapsed = std::chrono::steady_clock::now() - outline_start;
+
+    std::printf(
+        "%d ropes of %d segments, %d ticks, %d workers, %d iterations: %.3f ms per tick, %.3f ms to outline %zu vertices\n",
+        rope_count, segments, ticks, workers, ropes.getIterations(), elapsed.count() / ticks, outline_elapsed.count(), outline.size()
+    );
+
+    return 0;
+}
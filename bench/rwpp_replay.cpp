@@ -0,0 +1,65 @@
+// Plays a run the game recorded again without a window, as fast as it goes, and checks it ends where the recording did.
+//   rwpp_replay [log] [level directory] [workers] [repeats]
+// The log defaults to the game's last_run.rwinput. Every repeat replays on the calling thread and on the workers if there are any,
+// the process fails if any of them ends on another checksum than the recording
+
+#include "jobs.h"
+#include "custom/demo.h"
+#include "custom/input.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <exception>
+#include <memory>
+#include <string>
+
+int main(const int argc, char **argv) {
+    const std::string log_path = argc > 1 ? argv[1] : "last_run.rwinput";
+    const std::string level_directory = argc > 2 ? argv[2] : "assets/levels/";
+    const int workers = argc > 3 ? std::max(0, std::atoi(argv[3])) : 0;
+    const int repeats = argc > 4 ? std::max(1, std::atoi(argv[4])) : 1;
+
+    InputLog log;
+    try {
+        log = InputLog::load(log_path);
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::unique_ptr<jobs::JobSystem> system;
+    if (workers > 0) system = std::make_unique<jobs::JobSystem>(workers);
+
+    const auto replay = [&](jobs::JobSystem *runner) {
+        demo::Replay run(level_directory, log.getStartRoom());
+        if (runner) {
+            run.getPhysics().setRunner([runner](const size_t count, const std::function<void(size_t)> &batch) {
+                runner->parallel_for(0, count, 1, [&](const size_t begin, const size_t end) {
+                    for (size_t i = begin; i < end; ++i) batch(i);
+                });
+            });
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        for (size_t tick = 0; tick < log.getTickCount(); ++tick) run.tick(log.getFrame(tick));
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+        const unsigned long long checksum = run.getPhysics().checksum();
+        const bool matches = checksum == log.getChecksum();
+        std::printf(
+            "%s, %zu ticks from %s on %d workers: %.0f ticks per second, checksum %016llx, %s\n",
+            log_path.c_str(), log.getTickCount(), log.getStartRoom().c_str(), runner ? workers : 0,
+            static_cast<double>(log.getTickCount()) / elapsed.count(), checksum, matches ? "matches the recording" : "DIFFERS from the recording"
+        );
+        return matches;
+    };
+
+    bool all_match = true;
+    for (int i = 0; i < repeats; ++i) {
+        all_match &= replay(nullptr);
+        if (system) all_match &= replay(system.get());
+    }
+
+    return all_match ? 0 : 1;
+}
@@ -9,6 +9,7 @@
 #include "libgui_pipeline.h"
 #include "libgui_init.h"
 #include "libgui_barriers.h"
+#include "libgui_uniform.h"
 #include "libgui_utils.h"
 #include "libgui_vkutils.h"
 #include "libgui_vma.h"
@@ -190,10 +191,18 @@ public:
         vkb::PhysicalDeviceSelector phys_device_selector(Vulkan);
         auto physical_device_selector_return = phys_device_selector
             .set_minimum_version(1, 3)
+            .set_required_features(VkPhysicalDeviceFeatures {
+                .shaderStorageImageExtendedFormats = true, // r16 storage images
+            })
             .set_required_features_12(VkPhysicalDeviceVulkan12Features {
                 .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES,
 
                 .descriptorIndexing = true,
+                .shaderSampledImageArrayNonUniformIndexing = true,
+                .descriptorBindingSampledImageUpdateAfterBind = true,
+                .descriptorBindingUpdateUnusedWhilePending = true,
+                .descriptorBindingPartiallyBound = true,
+                .runtimeDescriptorArray = true,
                 .bufferDeviceAddress = true,
             })
             .set_required_features_13(VkPhysicalDeviceVulkan13Features {
@@ -211,6 +211,77 @@ inline void index_write_barrier(const VkCommandBuffer cmd, const VkSizedBuffer &
     vkCmdPipelineBarrier2(cmd, &barrier_dep);
 }
 
+/**
+ * @brief inserts a barrier between two uses of a whole buffer
+ * @param cmd command buffer
+ * @param buffer the buffer
+ * @param src_stage stage of the earlier use
+ * @param src_access access of the earlier use
+ * @param dst_stage stage of the later use
+ * @param dst_access access of the later use
+ */
+inline void buffer_barrier(const VkCommandBuffer cmd, const VkSizedBuffer &buffer, const VkPipelineStageFlags2 src_stage, const VkAccessFlags2 src_access, const VkPipelineStageFlags2 dst_stage, const VkAccessFlags2 dst_access) {
+    const VkBufferMemoryBarrier2 barrier {
+        .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2,
+
+        .srcStageMask = src_stage,
+        .srcAccessMask = src_access,
+        .dstStageMask = dst_stage,
+        .dstAccessMask = dst_access,
+
+        .buffer = buffer.buffer,
+        .offset = 0,
+        .size = buffer.size,
+    };
+
+    const VkDependencyInfo barrier_dep {
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+
+        .bufferMemoryBarrierCount = 1,
+        .pBufferMemoryBarriers = &barrier,
+    };
+
+    vkCmdPipelineBarrier2(cmd, &barrier_dep);
+}
+
+/**
+ * @brief inserts a barrier between two uses of an image, only waiting on the given stages unlike change_image_layout
+ * @param cmd command buffer
+ * @param image image to wait on
+ * @param old_layout layout of the earlier use, UNDEFINED to discard the contents
+ * @param new_layout layout of the later use
+ * @param src_stage stage of the earlier use
+ * @param src_access access of the earlier use
+ * @param dst_stage stage of the later use
+ * @param dst_access access of the later use
+ * @param aspect_mask aspect of the image
+ */
+inline void image_barrier(const VkCommandBuffer cmd, const VkImage image, const VkImageLayout old_layout, const VkImageLayout new_layout, const VkPipelineStageFlags2 src_stage, const VkAccessFlags2 src_access, const VkPipelineStageFlags2 dst_stage, const VkAccessFlags2 dst_access, const VkImageAspectFlags aspect_mask = VK_IMAGE_ASPECT_COLOR_BIT) {
+    const VkImageMemoryBarrier2 barrier {
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2,
+
+        .srcStageMask = src_stage,
+        .srcAccessMask = src_access,
+        .dstStageMask = dst_stage,
+        .dstAccessMask = dst_access,
+
+        .oldLayout = old_layout,
+        .newLayout = new_layout,
+
+        .image = image,
+        .subresourceRange = image_subresource_range(aspect_mask),
+    };
+
+    const VkDependencyInfo barrier_dep {
+        .sType = VK_STRUCTURE_TYPE_DEPENDENCY_INFO,
+
+        .imageMemoryBarrierCount = 1,
+        .pImageMemoryBarriers = &barrier,
+    };
+
+    vkCmdPipelineBarrier2(cmd, &barrier_dep);
+}
+
 /**
  * @brief inserts a barrier to switch the layout of the given image
  * @param cmd command buffer
@@ -1,5 +1,7 @@
 ﻿#pragma once
 
+#include "libgui_memory.h"
+
 #include <imgui_impl_sdl3.h>
 #include <imgui_impl_vulkan.h>
 #include <volk.h>
@@ -106,4 +108,58 @@ static void imgui_draw(const VkCommandBuffer cmd, const VkAllocatedImage &draw)
     vkCmdEndRendering(cmd);
 }
 
+/**
+ * @brief Heap budgets, per category usage and per frame allocation counts
+ * @param vma allocator to read the budgets of
+ * @param dump_path where the "Dump JSON" button writes to
+ */
+static void imgui_memory_panel(const VmaAllocator vma, const char *dump_path = "memory_dump.json") {
+    constexpr float MiB = 1024.0f * 1024.0f;
+
+    ImGui::Begin("GPU Memory");
+
+    const VkPhysicalDeviceMemoryProperties *memory_props;
+    vmaGetMemoryProperties(vma, &memory_props);
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(vma, budgets);
+
+    for (uint32_t i = 0; i < memory_props->memoryHeapCount; ++i) {
+        const bool device_local = memory_props->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+        const float usage = static_cast<float>(budgets[i].usage) / MiB;
+        const float budget = static_cast<float>(budgets[i].budget) / MiB;
+
+        char overlay[64];
+        snprintf(overlay, sizeof(overlay), "%.1f / %.1f MiB", usage, budget);
+
+        ImGui::Text("Heap %u%s", i, device_local ? " (device local)" : "");
+        ImGui::ProgressBar(budget > 0 ? usage / budget : 0, ImVec2(-1, 0), overlay);
+    }
+
+    ImGui::SeparatorText("Categories");
+    if (ImGui::BeginTable("memory_categories", 3)) {
+        ImGui::TableSetupColumn("Category");
+        ImGui::TableSetupColumn("MiB");
+        ImGui::TableSetupColumn("Allocations");
+        ImGui::TableHeadersRow();
+
+        for (size_t i = 0; i < Memory.categories.size(); ++i) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn(); ImGui::TextUnformatted(memory_category_name(static_cast<MemoryCategory>(i)));
+            ImGui::TableNextColumn(); ImGui::Text("%.2f", static_cast<float>(Memory.categories[i].bytes) / MiB);
+            ImGui::TableNextColumn(); ImGui::Text("%u", Memory.categories[i].allocations);
+        }
+
+        ImGui::EndTable();
+    }
+
+    ImGui::SeparatorText("Last frame");
+    ImGui::Text("Allocs: %u, Frees: %u", Memory.last_frame_allocs, Memory.last_frame_frees);
+    ImGui::Text("Total allocs: %llu, Total frees: %llu", static_cast<unsigned long long>(Memory.total_allocs), static_cast<unsigned long long>(Memory.total_frees));
+
+    if (ImGui::Button("Dump JSON")) memory_dump_json(vma, dump_path);
+
+    ImGui::End();
+}
+
 }
@@ -1,5 +1,6 @@
 ﻿#pragma once
 
+#include "libgui_memory.h"
 #include "libgui_vma.h"
 
 #include <vector>
@@ -19,14 +20,16 @@ struct VkSizedBuffer {
     VmaAllocationInfo allocation_info;
 
     void dispose() const {
+        memory_track_free(allocator, allocation);
         vmaDestroyBuffer(allocator, buffer, allocation);
     }
 };
 
 /**
  * @brief Creates a sized buffer
+ * @param category what the buffer is counted as in libgui::Memory
  */
-inline VkResult create_buffer(const VmaAllocator vma, VkSizedBuffer *buffer, const uint32_t size, const VmaMemoryUsage memory_usage, const VmaAllocationCreateFlags alloc_flags, const VkBufferUsageFlags usage, const VkBufferCreateFlags flags = 0) {
+inline VkResult create_buffer(const VmaAllocator vma, VkSizedBuffer *buffer, const uint32_t size, const VmaMemoryUsage memory_usage, const VmaAllocationCreateFlags alloc_flags, const VkBufferUsageFlags usage, const VkBufferCreateFlags flags = 0, const MemoryCategory category = MemoryCategory::Other) {
     const VkBufferCreateInfo create{
         .sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
         .flags = flags,
@@ -39,19 +42,26 @@ inline VkResult create_buffer(const VmaAllocator vma, VkSizedBuffer *buffer, con
         .flags = alloc_flags,
         .usage = memory_usage,
         .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        .pUserData = memory_user_data(category),
     };
 
     buffer->allocator = vma;
     buffer->size = size;
-    return vmaCreateBuffer(vma, &create, &alloc, &buffer->buffer, &buffer->allocation, &buffer->allocation_info);
+
+    const VkResult result = vmaCreateBuffer(vma, &create, &alloc, &buffer->buffer, &buffer->allocation, &buffer->allocation_info);
+    if (result == VK_SUCCESS) memory_track_alloc(vma, buffer->allocation);
+
+    return result;
 }
 
 /**
  * @brief Creates a descriptor set layout
+ * @param next pNext chain, e.g. VkDescriptorSetLayoutBindingFlagsCreateInfo for bindless bindings
  */
-inline VkResult descriptor_set_layout(const VkDevice device, const std::vector<VkDescriptorSetLayoutBinding> &bindings, VkDescriptorSetLayout *layout, const VkDescriptorSetLayoutCreateFlags flags = 0) {
+inline VkResult descriptor_set_layout(const VkDevice device, const std::vector<VkDescriptorSetLayoutBinding> &bindings, VkDescriptorSetLayout *layout, const VkDescriptorSetLayoutCreateFlags flags = 0, const void *next = nullptr) {
     const VkDescriptorSetLayoutCreateInfo create_layout {
         .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
+        .pNext = next,
         .flags = flags,
 
         .bindingCount = static_cast<uint32_t>(bindings.size()),
@@ -219,7 +229,7 @@ inline VkSubmitInfo2 submit_info(const VkCommandBufferSubmitInfo *cmd, const VkS
 /**
  * @brief Creates an image create info
  */
-inline VkImageCreateInfo image_create_info(const VkFormat format, const VkImageUsageFlags usage, const VkExtent3D extent, const VkImageCreateFlags flags = 0)
+inline VkImageCreateInfo image_create_info(const VkFormat format, const VkImageUsageFlags usage, const VkExtent3D extent, const VkImageCreateFlags flags = 0, const uint32_t array_layers = 1)
 {
     return VkImageCreateInfo {
         .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
@@ -229,7 +239,7 @@ inline VkImageCreateInfo image_create_info(const VkFormat format, const VkImageU
         .format = format,
         .extent = extent,
         .mipLevels = 1,
-        .arrayLayers = 1,
+        .arrayLayers = array_layers,
         .samples = VK_SAMPLE_COUNT_1_BIT,
         .tiling = VK_IMAGE_TILING_OPTIMAL,
         .usage = usage,
@@ -240,19 +250,19 @@ inline VkImageCreateInfo image_create_info(const VkFormat format, const VkImageU
 /**
  * @brief Creates an image view create info
  */
-inline VkImageViewCreateInfo imageview_create_info(const VkFormat format, const VkImage image, const VkImageAspectFlags aspect)
+inline VkImageViewCreateInfo imageview_create_info(const VkFormat format, const VkImage image, const VkImageAspectFlags aspect, const VkImageViewType view_type = VK_IMAGE_VIEW_TYPE_2D, const uint32_t layer_count = 1)
 {
     return VkImageViewCreateInfo {
         .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
         .image = image,
-        .viewType = VK_IMAGE_VIEW_TYPE_2D,
+        .viewType = view_type,
         .format = format,
         .subresourceRange = {
             .aspectMask = aspect,
             .baseMipLevel = 0,
             .levelCount = 1,
             .baseArrayLayer = 0,
-            .layerCount = 1,
+            .layerCount = layer_count,
         }
     };
 }
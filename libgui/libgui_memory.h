@@ -0,0 +1,144 @@
+﻿#pragma once
+
+#include "libgui_vma.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+namespace libgui {
+
+/**
+ * @brief What an allocation is used for, stored in the allocation's VMA user data
+ */
+enum class MemoryCategory : uint8_t {
+    Other,
+    Textures,
+    MeshRings,
+    Uniforms,
+    RenderTargets,
+    Staging,
+    Count,
+};
+
+inline const char *memory_category_name(const MemoryCategory category) {
+    switch (category) {
+        case MemoryCategory::Textures:      return "textures";
+        case MemoryCategory::MeshRings:     return "mesh_rings";
+        case MemoryCategory::Uniforms:      return "uniforms";
+        case MemoryCategory::RenderTargets: return "render_targets";
+        case MemoryCategory::Staging:       return "staging";
+        default:                            return "other";
+    }
+}
+
+/**
+ * @brief Live bytes and allocation counts per category, plus allocations made and freed per frame
+ */
+struct MemoryStats {
+    struct Category {
+        VkDeviceSize bytes = 0;
+        uint32_t allocations = 0;
+    };
+
+    std::array<Category, static_cast<size_t>(MemoryCategory::Count)> categories {};
+
+    uint32_t frame_allocs = 0, frame_frees = 0;       // Counting for the current frame
+    uint32_t last_frame_allocs = 0, last_frame_frees = 0;
+    uint64_t total_allocs = 0, total_frees = 0;
+
+    void end_frame() {
+        last_frame_allocs = frame_allocs;
+        last_frame_frees = frame_frees;
+        frame_allocs = 0;
+        frame_frees = 0;
+    }
+};
+
+// Global memory statistics, filled in by create_buffer/create_image and their disposes
+inline MemoryStats Memory {};
+
+inline void *memory_user_data(const MemoryCategory category) {
+    return reinterpret_cast<void*>(static_cast<uintptr_t>(category));
+}
+
+/**
+ * @brief Counts a fresh allocation towards the category in its user data
+ */
+inline void memory_track_alloc(const VmaAllocator vma, const VmaAllocation allocation) {
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(vma, allocation, &info);
+
+    auto &category = Memory.categories[reinterpret_cast<uintptr_t>(info.pUserData) % Memory.categories.size()];
+    category.bytes += info.size;
+    category.allocations++;
+
+    Memory.frame_allocs++;
+    Memory.total_allocs++;
+}
+
+/**
+ * @brief Call before freeing an allocation that was counted with memory_track_alloc
+ */
+inline void memory_track_free(const VmaAllocator vma, const VmaAllocation allocation) {
+    if (allocation == VK_NULL_HANDLE) return;
+
+    VmaAllocationInfo info;
+    vmaGetAllocationInfo(vma, allocation, &info);
+
+    auto &category = Memory.categories[reinterpret_cast<uintptr_t>(info.pUserData) % Memory.categories.size()];
+    category.bytes -= std::min(category.bytes, info.size);
+    if (category.allocations > 0) category.allocations--;
+
+    Memory.frame_frees++;
+    Memory.total_frees++;
+}
+
+/**
+ * @brief Writes heap budgets, our categories and VMA's own detailed stats as one JSON document
+ * @return false if the file couldn't be opened
+ */
+inline bool memory_dump_json(const VmaAllocator vma, const char *path) {
+    std::ofstream file(path);
+    if (!file.is_open()) return false;
+
+    const VkPhysicalDeviceMemoryProperties *memory_props;
+    vmaGetMemoryProperties(vma, &memory_props);
+
+    VmaBudget budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(vma, budgets);
+
+    file << "{\n  \"heaps\": [\n";
+    for (uint32_t i = 0; i < memory_props->memoryHeapCount; ++i) {
+        file << "    { \"index\": " << i
+             << ", \"device_local\": " << ((memory_props->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) ? "true" : "false")
+             << ", \"size\": " << memory_props->memoryHeaps[i].size
+             << ", \"budget\": " << budgets[i].budget
+             << ", \"usage\": " << budgets[i].usage
+             << ", \"block_bytes\": " << budgets[i].statistics.blockBytes
+             << ", \"allocation_bytes\": " << budgets[i].statistics.allocationBytes
+             << " }" << (i + 1 < memory_props->memoryHeapCount ? ",\n" : "\n");
+    }
+
+    file << "  ],\n  \"categories\": {\n";
+    for (size_t i = 0; i < Memory.categories.size(); ++i) {
+        file << "    \"" << memory_category_name(static_cast<MemoryCategory>(i)) << "\": { \"bytes\": " << Memory.categories[i].bytes
+             << ", \"allocations\": " << Memory.categories[i].allocations
+             << " }" << (i + 1 < Memory.categories.size() ? ",\n" : "\n");
+    }
+
+    file << "  },\n  \"frame\": { \"allocs\": " << Memory.last_frame_allocs << ", \"frees\": " << Memory.last_frame_frees
+         << ", \"total_allocs\": " << Memory.total_allocs << ", \"total_frees\": " << Memory.total_frees << " },\n";
+
+    // VMA's stats string is JSON already
+    char *vma_stats = nullptr;
+    vmaBuildStatsString(vma, &vma_stats, VK_TRUE);
+    file << "  \"vma\": " << vma_stats << "\n}\n";
+    vmaFreeStatsString(vma, vma_stats);
+
+    return true;
+}
+
+}
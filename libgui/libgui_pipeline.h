@@ -10,32 +10,76 @@
 namespace libgui {
 
     /**
-     * @brief A lease of Descriptor Pools.\n
+     * @brief Ratio of descriptors of a type per set in a descriptor pool
+     */
+struct PoolSizeRatio {
+    VkDescriptorType type;
+    float ratio;
+};
+
+    /**
+     * @brief Usage counters reported by the descriptor leases
+     */
+struct DescriptorLeaseStats {
+    uint32_t pools = 0;          // Pools currently owned
+    uint32_t full_pools = 0;     // Pools that ran out of space since the last reset
+    uint64_t sets_allocated = 0; // Sets handed out since the last reset
+    uint64_t resets = 0;         // Wholesale pool resets
+    uint64_t unfenced_resets = 0; // Resets of pools whose frame was never retired, the GPU may still have been reading them
+};
+
+    /**
+     * @brief Creates a descriptor pool sized for the given amount of sets
+     * @param device Vulkan GPU
+     * @param set_count Max sets of the pool
+     * @param pool_ratios Descriptors per set of each type
+     * @param flags Pool create flags
+     * @return The created pool
+     */
+inline VkDescriptorPool create_descriptor_pool(const VkDevice device, const uint32_t set_count, const std::span<const PoolSizeRatio> pool_ratios, const VkDescriptorPoolCreateFlags flags = 0) {
+    std::vector<VkDescriptorPoolSize> sizes;
+
+    for (auto [type, ratio]: pool_ratios) {
+        sizes.push_back(VkDescriptorPoolSize {
+            .type = type,
+            .descriptorCount = static_cast<uint32_t>(ratio * set_count),
+        });
+    }
+
+    const VkDescriptorPoolCreateInfo pool_info = {
+        .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
+        .flags = flags,
+        .maxSets = set_count,
+        .poolSizeCount = static_cast<uint32_t>(sizes.size()),
+        .pPoolSizes = sizes.data(),
+    };
+
+    VkDescriptorPool create;
+    VK_ASSERT(vkCreateDescriptorPool(device, &pool_info, nullptr, &create));
+
+    return create;
+}
+
+    /**
+     * @brief A lease of Descriptor Pools for long-lived sets.\n
      * Allows you to allocate descriptor sets without worry
      */
 class DescriptorLease {
 public:
-    struct PoolSizeRatio {
-        VkDescriptorType type;
-        float ratio;
-    };
+    typedef libgui::PoolSizeRatio PoolSizeRatio;
 
 private:
     std::vector<PoolSizeRatio> ratios;
     std::vector<VkDescriptorPool> full;
-    std::vector<VkDescriptorPool> ready;
+    std::vector<VkDescriptorPool> ready; // back() is the pool we allocate from
     uint32_t sets_per_pool = 0;
 
-    VkDescriptorPool get_pool(const VkDevice device) {
-        VkDescriptorPool get_new;
+    DescriptorLeaseStats counters;
 
+    VkDescriptorPool get_pool(const VkDevice device) {
         // We're out of pools!
-        if (!ready.empty()) {
-            get_new = ready.back();
-            ready.pop_back();
-        }
-        else {
-            get_new = create_pool(device, sets_per_pool, ratios);
+        if (ready.empty()) {
+            ready.push_back(create_descriptor_pool(device, sets_per_pool, ratios));
 
             // Clearly it's not going to be enough at this rate, increase set size for next pools
             sets_per_pool = sets_per_pool * 1.5;
@@ -46,30 +90,7 @@ private:
             }
         }
 
-        return get_new;
-    }
-
-    VkDescriptorPool create_pool(const VkDevice device, const uint32_t set_count, const std::span<PoolSizeRatio> pool_ratios) {
-        std::vector<VkDescriptorPoolSize> sizes;
-
-        for (auto [type, ratio]: pool_ratios) {
-            sizes.push_back(VkDescriptorPoolSize {
-                .type = type,
-                .descriptorCount = static_cast<uint32_t>(ratio * set_count),
-            });
-        }
-
-        const VkDescriptorPoolCreateInfo pool_info = {
-            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO,
-            .maxSets = set_count,
-            .poolSizeCount = static_cast<uint32_t>(sizes.size()),
-            .pPoolSizes = sizes.data(),
-        };
-
-        VkDescriptorPool create;
-        vkCreateDescriptorPool(device, &pool_info, nullptr, &create);
-
-        return create;
+        return ready.back();
     }
 
 public:
@@ -80,7 +101,7 @@ public:
             ratios.push_back(r);
         }
 
-        const VkDescriptorPool first_pool = create_pool(device, max_sets, pool_ratios);
+        const VkDescriptorPool first_pool = create_descriptor_pool(device, max_sets, pool_ratios);
 
         sets_per_pool = max_sets * 1.5;
 
@@ -98,6 +119,9 @@ public:
         }
 
         full.clear();
+
+        counters.sets_allocated = 0;
+        counters.resets++;
     }
 
     void destroy_pools(const VkDevice device) {
@@ -128,9 +152,9 @@ public:
         VkDescriptorSet ds;
         const VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &ds);
 
-        // Whoops, try again
+        // Whoops, retire the pool and try again
         if (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
-
+            ready.pop_back();
             full.push_back(use);
 
             use = get_pool(device);
@@ -139,9 +163,153 @@ public:
             VK_ASSERT(vkAllocateDescriptorSets(device, &allocInfo, &ds)); // We really cannot
         }
 
-        ready.push_back(use);
+        counters.sets_allocated++;
+        return ds;
+    }
+
+    /**
+     * @brief Fetches the usage counters of this lease
+     */
+    DescriptorLeaseStats stats() const {
+        DescriptorLeaseStats out = counters;
+        out.pools = static_cast<uint32_t>(ready.size() + full.size());
+        out.full_pools = static_cast<uint32_t>(full.size());
+
+        return out;
+    }
+};
+
+    /**
+     * @brief A ring of linear descriptor allocators, one per frame in flight.\n
+     * Sets allocated here only live for the frame they were allocated in. Once that frame comes around in the ring
+     * again every one of its pools is reset at once, so per-draw sets cost a bump allocation and no frees.
+     */
+class FrameDescriptorLease {
+    struct Frame {
+        std::vector<VkDescriptorPool> pools;
+        size_t current = 0;
+        bool retired = true; // The submit that read this frame's sets has finished
+
+        DescriptorLeaseStats counters;
+    };
+
+    std::vector<PoolSizeRatio> ratios;
+    std::vector<Frame> frames;
+    uint32_t sets_per_pool = 0;
+    uint32_t frame_idx = 0;
+
+public:
+    /**
+     * @brief Creates the ring and the first pool of every frame
+     * @param device Vulkan GPU
+     * @param frames_in_flight Size of the ring, must be at least the amount of frames the GPU may still be reading
+     * @param pool_sets Max sets of each pool
+     * @param pool_ratios Descriptors per set of each type
+     */
+    void init(const VkDevice device, const uint32_t frames_in_flight, const uint32_t pool_sets, const std::span<PoolSizeRatio> pool_ratios) {
+        ratios.assign(pool_ratios.begin(), pool_ratios.end());
+        sets_per_pool = pool_sets;
+        frame_idx = 0;
+
+        frames.clear();
+        frames.resize(frames_in_flight);
+
+        for (auto &frame : frames) {
+            frame.pools.push_back(create_descriptor_pool(device, sets_per_pool, ratios));
+        }
+    }
+
+    /**
+     * @brief Moves to the next frame of the ring and resets all of its pools
+     * @attention The fence of the frame that last used the next slot must have signalled already
+     */
+    void next_frame(const VkDevice device) {
+        frame_idx = (frame_idx + 1) % frames.size();
+
+        Frame &frame = frames[frame_idx];
+        if (!frame.retired) frame.counters.unfenced_resets++;
+
+        for (const auto p : frame.pools) {
+            vkResetDescriptorPool(device, p, 0);
+        }
+
+        frame.current = 0;
+        frame.retired = false;
+        frame.counters.sets_allocated = 0;
+        frame.counters.full_pools = 0;
+        frame.counters.resets++;
+    }
+
+    /**
+     * @brief Index of the frame slot currently being allocated from, pass it to retire once its submit is fenced
+     */
+    uint32_t current_frame() const { return frame_idx; }
+
+    /**
+     * @brief Marks a frame slot as no longer read by the GPU, call after waiting for the fence of the submit that used it
+     */
+    void retire(const uint32_t frame) { frames[frame].retired = true; }
+
+    /**
+     * @brief Allocates a set that is valid until this frame slot is reset
+     */
+    VkDescriptorSet allocate(const VkDevice device, const VkDescriptorSetLayout layout, void* next = nullptr) {
+        Frame &frame = frames[frame_idx];
+
+        VkDescriptorSetAllocateInfo allocInfo = {
+            .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
+            .pNext = next,
+
+            .descriptorPool = frame.pools[frame.current],
+            .descriptorSetCount = 1,
+            .pSetLayouts = &layout,
+        };
+
+        VkDescriptorSet ds;
+        VkResult result = vkAllocateDescriptorSets(device, &allocInfo, &ds);
+
+        // Bump to the next pool of this frame, pools are kept around for the next time this frame comes around
+        while (result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+            frame.current++;
+            frame.counters.full_pools++;
+
+            if (frame.current == frame.pools.size()) {
+                frame.pools.push_back(create_descriptor_pool(device, sets_per_pool, ratios));
+                allocInfo.descriptorPool = frame.pools[frame.current];
+
+                VK_ASSERT(vkAllocateDescriptorSets(device, &allocInfo, &ds)); // A fresh pool is empty, we really cannot
+                break;
+            }
+
+            allocInfo.descriptorPool = frame.pools[frame.current];
+            result = vkAllocateDescriptorSets(device, &allocInfo, &ds);
+        }
+
+        frame.counters.sets_allocated++;
         return ds;
     }
+
+    void destroy_pools(const VkDevice device) {
+        for (auto &frame : frames) {
+            for (const auto p : frame.pools) {
+                vkDestroyDescriptorPool(device, p, nullptr);
+            }
+
+            frame.pools.clear();
+        }
+    }
+
+    /**
+     * @brief Fetches the usage counters of the frame currently being allocated from
+     */
+    DescriptorLeaseStats stats() const {
+        const Frame &frame = frames[frame_idx];
+
+        DescriptorLeaseStats out = frame.counters;
+        out.pools = static_cast<uint32_t>(frame.pools.size());
+
+        return out;
+    }
 };
 
 /**
@@ -153,7 +321,7 @@ class DescriptorLayoutHelper {
     std::vector<VkWriteDescriptorSet> writes;
 
 public:
-    DescriptorLayoutHelper image(const uint32_t binding, const VkImageView image, const VkSampler sampler, const VkImageLayout layout, const VkDescriptorType type) {
+    DescriptorLayoutHelper image(const uint32_t binding, const VkImageView image, const VkSampler sampler, const VkImageLayout layout, const VkDescriptorType type, const uint32_t array_element = 0) {
         VkDescriptorImageInfo& info = images.emplace_back(VkDescriptorImageInfo {
             .sampler = sampler,
             .imageView = image,
@@ -165,6 +333,7 @@ public:
 
             .dstSet = VK_NULL_HANDLE, // Used only when we actually write to the set
             .dstBinding = binding,
+            .dstArrayElement = array_element,
             .descriptorCount = 1,
             .descriptorType = type,
             .pImageInfo = &info,
@@ -223,18 +392,57 @@ struct VkCompletePipeline {
     VkDevice owner_gpu;
     VkPipelineLayout layout;
     VkPipeline pipeline;
-    std::span<VkDescriptorSetLayout> set_layouts;
 
+    // Set layouts are shared between pipelines, whoever created them destroys them
     void dispose() {
         vkDestroyPipeline(owner_gpu, pipeline, nullptr);
         vkDestroyPipelineLayout(owner_gpu, layout, nullptr);
-
-        for (const auto layout: set_layouts) {
-            vkDestroyDescriptorSetLayout(owner_gpu, layout, nullptr);
-        }
     }
 };
 
+/**
+ * @brief Creates a compute pipeline and its layout
+ * @param shader compute shader module, can be destroyed after this returns
+ * @param set_layouts descriptor set layouts in set order
+ * @param push_constant_size size of the compute push constant range, 0 for none
+ * @param specialization_info specialization constants of the shader, if any
+ */
+inline VkCompletePipeline create_compute_pipeline(const VkDevice device, const VkShaderModule shader, const std::vector<VkDescriptorSetLayout> &set_layouts, const uint32_t push_constant_size = 0, const VkSpecializationInfo *specialization_info = nullptr, const VkPipelineCache cache = VK_NULL_HANDLE) {
+    const VkPushConstantRange push_range {
+        .stageFlags = VK_SHADER_STAGE_COMPUTE_BIT,
+        .offset = 0,
+        .size = push_constant_size,
+    };
+
+    const VkPipelineLayoutCreateInfo layout_create {
+        .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
+        .setLayoutCount = static_cast<uint32_t>(set_layouts.size()),
+        .pSetLayouts = set_layouts.data(),
+        .pushConstantRangeCount = push_constant_size > 0 ? 1u : 0u,
+        .pPushConstantRanges = &push_range,
+    };
+
+    VkPipelineLayout layout;
+    VK_ASSERT( vkCreatePipelineLayout(device, &layout_create, nullptr, &layout) );
+
+    const VkComputePipelineCreateInfo pipeline_create {
+        .sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO,
+        .stage = {
+            .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+            .stage = VK_SHADER_STAGE_COMPUTE_BIT,
+            .module = shader,
+            .pName = "main",
+            .pSpecializationInfo = specialization_info,
+        },
+        .layout = layout,
+    };
+
+    VkPipeline created;
+    VK_ASSERT( vkCreateComputePipelines(device, cache, 1, &pipeline_create, nullptr, &created) );
+
+    return { device, layout, created };
+}
+
 /**
  * @brief Builder class for easily creating pipelines
  */
@@ -448,6 +656,9 @@ public:
     }
 
     VkCompletePipeline build(const VkDevice device, const VkPipelineCache cache = VK_NULL_HANDLE) {
+        // Every builder call returns a copy, point the attachment formats back at this one
+        if (RenderInfo.colorAttachmentCount > 0) RenderInfo.pColorAttachmentFormats = &ColorAttachmentFormat;
+
         VkPipelineViewportStateCreateInfo viewport = {
             .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
 
@@ -515,7 +726,7 @@ public:
         VkPipeline created;
         VK_ASSERT(vkCreateGraphicsPipelines(device, cache, 1, &pipelineInfo, nullptr, &created));
 
-        return { device, layout, created, Sets };
+        return { device, layout, created };
     }
 };
 
@@ -0,0 +1,111 @@
+﻿#pragma once
+
+#include "libgui_init.h"
+#include "libgui_vma.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace libgui {
+
+/**
+ * @brief A uniform buffer that lives for as long as its owner and is only written when its contents change.\n
+ * The buffer stays mapped, writes go straight to it without a command buffer or barrier.
+ * Changes are tracked per 16 byte std140 row, flush() only copies the rows that changed.\n
+ * WRITES ARE NOT SYNCHRONISED WITH THE GPU, ONLY FLUSH WHILE NOTHING THAT READS THE BUFFER IS IN FLIGHT
+ * @tparam T std140 layout struct, see uniforms.h
+ */
+template<typename T>
+class PersistentUniform {
+    static constexpr size_t RowSize = 16;
+    static constexpr size_t Rows = (sizeof(T) + RowSize - 1) / RowSize;
+    static_assert(Rows <= 64, "PersistentUniform tracks at most 64 rows");
+
+    T value {};
+    uint64_t dirty = ~0ull; // Everything is uploaded on the first flush
+
+    void mark(const size_t offset, const size_t size) {
+        for (size_t row = offset / RowSize; row * RowSize < offset + size; ++row) dirty |= 1ull << row;
+    }
+
+public:
+    VkSizedBuffer Buffer {};
+
+    VkResult create(const VmaAllocator vma) {
+        return create_buffer(vma, &Buffer, sizeof(T), VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, 0, MemoryCategory::Uniforms);
+    }
+
+    void dispose() const { Buffer.dispose(); }
+
+    const T & get() const { return value; }
+
+    bool is_dirty() const { return dirty != 0; }
+
+    /**
+     * @brief Sets one field, its rows are only marked when the value differs
+     * @return whether the field changed
+     */
+    template<typename F>
+    bool set(F T::*field, const F &field_value) {
+        if (std::memcmp(&(value.*field), &field_value, sizeof(F)) == 0) return false;
+
+        value.*field = field_value;
+        mark(reinterpret_cast<const uint8_t*>(&(value.*field)) - reinterpret_cast<const uint8_t*>(&value), sizeof(F));
+        return true;
+    }
+
+    /**
+     * @brief Replaces the whole struct, only the rows that differ are marked
+     * @return whether anything changed
+     */
+    bool assign(const T &new_value) {
+        const auto *from = reinterpret_cast<const uint8_t*>(&new_value);
+        auto *to = reinterpret_cast<uint8_t*>(&value);
+
+        bool changed = false;
+        for (size_t row = 0; row < Rows; ++row) {
+            const size_t offset = row * RowSize;
+            const size_t size = std::min(RowSize, sizeof(T) - offset);
+            if (std::memcmp(to + offset, from + offset, size) == 0) continue;
+
+            std::memcpy(to + offset, from + offset, size);
+            dirty |= 1ull << row;
+            changed = true;
+        }
+
+        return changed;
+    }
+
+    /**
+     * @brief Copies the changed rows into the mapped buffer, consecutive rows are copied together
+     * @return bytes written, 0 when nothing changed
+     */
+    size_t flush() {
+        if (dirty == 0) return 0;
+
+        auto *mapped = static_cast<uint8_t*>(Buffer.allocation_info.pMappedData);
+        const auto *from = reinterpret_cast<const uint8_t*>(&value);
+
+        size_t written = 0;
+        size_t row = 0;
+        while (row < Rows) {
+            if ((dirty & (1ull << row)) == 0) { ++row; continue; }
+
+            const size_t first = row;
+            while (row < Rows && (dirty & (1ull << row)) != 0) ++row;
+
+            const size_t offset = first * RowSize;
+            const size_t size = std::min(row * RowSize, sizeof(T)) - offset;
+            std::memcpy(mapped + offset, from + offset, size);
+            vmaFlushAllocation(Buffer.allocator, Buffer.allocation, offset, size);
+
+            written += size;
+        }
+
+        dirty = 0;
+        return written;
+    }
+};
+
+}
@@ -171,17 +171,20 @@ struct VkAllocatedImage {
 
     uint32_t width;
     uint32_t height;
+    uint32_t layers = 1;
 
     VkAllocatedImage() = default;
 
     void dispose() const {
         vkDestroyImageView(allocator->m_hDevice, view, nullptr);
+        memory_track_free(allocator, allocation);
         vmaDestroyImage(allocator, image, allocation);
     }
 };
 
 /**
  * @brief Creates a VMA allocated image
+ * @param array_layers more than one layer creates a 2D array view
  */
 inline void create_image(
     const VmaAllocator vma,
@@ -193,11 +196,14 @@ inline void create_image(
     const VkFormat format = VK_FORMAT_R16G16B16A16_SFLOAT,
     const VkImageAspectFlags aspect = VK_IMAGE_ASPECT_COLOR_BIT,
     const VkImageUsageFlags usage = VK_IMAGE_USAGE_TRANSFER_SRC_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_STORAGE_BIT | VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT,
-    const VkImageCreateFlags flags = 0
+    const VkImageCreateFlags flags = 0,
+    const MemoryCategory category = MemoryCategory::Other,
+    const uint32_t array_layers = 1
 ) {
     image->allocator = vma;
     image->width = width;
     image->height = height;
+    image->layers = array_layers;
 
     image->format = format;
     image->extent = VkExtent3D {
@@ -206,17 +212,20 @@ inline void create_image(
         1
     };
 
-    const auto img_create = image_create_info(format, usage, image->extent, flags);
+    const auto img_create = image_create_info(format, usage, image->extent, flags, array_layers);
 
     const VmaAllocationCreateInfo alloc_info = {
         .flags = alloc_flags,
         .usage = VMA_MEMORY_USAGE_GPU_ONLY,
         .requiredFlags = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+        .pUserData = memory_user_data(category),
     };
 
     VK_ASSERT( vmaCreateImage(vma, &img_create, &alloc_info, &image->image, &image->allocation, nullptr) );
+    memory_track_alloc(vma, image->allocation);
 
-    const VkImageViewCreateInfo view_create = imageview_create_info(format, image->image, aspect);
+    const VkImageViewType view_type = array_layers > 1 ? VK_IMAGE_VIEW_TYPE_2D_ARRAY : VK_IMAGE_VIEW_TYPE_2D;
+    const VkImageViewCreateInfo view_create = imageview_create_info(format, image->image, aspect, view_type, array_layers);
     VK_ASSERT( vkCreateImageView(device, &view_create, nullptr, &image->view) );
 }
 
@@ -355,14 +364,30 @@ static void buffer_to_buffer(const VkCommandBuffer cmd, const VkBuffer &src_buff
  * @param dst_offset Buffer offset
  */
 static void data_to_buffer(const VkCommandBuffer cmd, VkSizedBuffer &upload, const VmaAllocator vma, const void *data, const uint32_t size, const uint32_t src_offset, const VkBuffer &dst_buffer, const uint32_t dst_offset) {
-    VK_ASSERT( create_buffer(vma, &upload, size, VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT) );
+    VK_ASSERT( create_buffer(vma, &upload, size, VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 0, MemoryCategory::Staging) );
     memcpy(upload.allocation_info.pMappedData, data, size);
 
     buffer_to_buffer(cmd, upload.buffer, src_offset, dst_buffer, dst_offset, size);
 }
 
-static void data_to_image(const VkCommandBuffer cmd, VkSizedBuffer &upload, const VmaAllocator vma, const void *data, const uint32_t size, const uint32_t src_offset, const VkImage dst, const uint32_t dst_w, const uint32_t dst_h) {
-    VK_ASSERT( create_buffer(vma, &upload, size, VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT) );
+/**
+ * @brief creates a staging buffer and uses it to copy given pixels to a region of a destination image
+ * @attention Don't forget to dispose of the created staging buffer!
+ * @param cmd Command buffer
+ * @param upload Pointer to an uninitialised sized buffer
+ * @param vma The VMA allocator
+ * @param data Pixels to copy
+ * @param size Size of data
+ * @param src_offset Offset of data
+ * @param dst Image to copy to, in TRANSFER_DST_OPTIMAL
+ * @param dst_w Width of the copied region
+ * @param dst_h Height of the copied region
+ * @param dst_x Left of the copied region
+ * @param dst_y Top of the copied region
+ * @param dst_layer Array layer to copy to
+ */
+static void data_to_image(const VkCommandBuffer cmd, VkSizedBuffer &upload, const VmaAllocator vma, const void *data, const uint32_t size, const uint32_t src_offset, const VkImage dst, const uint32_t dst_w, const uint32_t dst_h, const int32_t dst_x = 0, const int32_t dst_y = 0, const uint32_t dst_layer = 0) {
+    VK_ASSERT( create_buffer(vma, &upload, size, VMA_MEMORY_USAGE_CPU_TO_GPU, VMA_ALLOCATION_CREATE_MAPPED_BIT, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, 0, MemoryCategory::Staging) );
     memcpy(upload.allocation_info.pMappedData, data, size);
 
     const VkBufferImageCopy region = {
@@ -372,10 +397,10 @@ static void data_to_image(const VkCommandBuffer cmd, VkSizedBuffer &upload, cons
         .imageSubresource = {
             .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
             .mipLevel = 0,
-            .baseArrayLayer = 0,
+            .baseArrayLayer = dst_layer,
             .layerCount = 1,
         },
-        .imageOffset = VkOffset3D(0, 0, 0),
+        .imageOffset = VkOffset3D(dst_x, dst_y, 0),
         .imageExtent = VkExtent3D(dst_w, dst_h, 1),
     };
 
@@ -0,0 +1,21 @@
+#pragma once
+
+#include "physics.h"
+#include "geometry.h"
+#include <glm/glm.hpp>
+
+// A chunk on every few air tiles of the room, thrown in different directions so they hit walls and each other
+template<typename Features>
+void populate(BasicPhysicsWorld<Features> &world, RoomGeometry &room, const Features features = {}) {
+    int n = 0;
+    for (int y = 2; y < room.getYSize() - 2; y += 3) {
+        for (int x = 2; x < room.getXSize() - 2; x += 3) {
+            if (room.getTileType(x, y)) continue;
+
+            const glm::vec2 pos(x * 20.0f + 10.0f, y * 20.0f + 10.0f);
+            const size_t index = world.add(BasicBodyChunk<Features>(pos, 1.0f, 8.0f + static_cast<float>(n % 3) * 4.0f, 0.1f, 0.3f, room, features), glm::vec2(0, -1.5f));
+            world.getChunk(index).setVelocity(glm::vec2(static_cast<float>(n % 7) - 3.0f, static_cast<float>(n % 5) - 2.0f) * 3.0f);
+            n++;
+        }
+    }
+}
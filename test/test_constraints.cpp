@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "physics.h"
+#include "geometry.h"
+#include "jobs.h"
+#include <glm/glm.hpp>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+RoomGeometry emptyRoom() {
+    return RoomGeometry(20, 20, std::vector<int>(400, 0));
+}
+
+// A room with a solid bottom row
+RoomGeometry floorRoom() {
+    std::vector<int> tiles(400, 0);
+    for (int x = 0; x < 20; ++x) tiles[380 + x] = 1;
+    return RoomGeometry(20, 20, tiles);
+}
+
+// Chunks in a row, each held to the next and bending at most 45 degrees away from straight
+void addChain(PhysicsWorld &world, RoomGeometry &room, const glm::vec2 start, const int length, const glm::vec2 gravity) {
+    const uint32_t first = static_cast<uint32_t>(world.getCount());
+    for (int i = 0; i < length; ++i) {
+        world.add(BodyChunk(start + glm::vec2(i * 20.0f, 0), 1.0f + static_cast<float>(i % 2), 8.0f, 0.1f, 0.1f, room), gravity);
+    }
+
+    for (uint32_t i = first; i + 1 < first + length; ++i) world.getConstraints().addDistance(i, i + 1, 20.0f);
+    for (uint32_t i = first + 1; i + 1 < first + length; ++i) world.getConstraints().addAngle(i - 1, i, i + 1, -0.7853982f, 0.7853982f);
+}
+
+}
+
+// Test for a distance constraint pulling two chunks back to its length
+TEST(ConstraintSolverTest, Distance) {
+    RoomGeometry room = emptyRoom();
+    PhysicsWorld world;
+    world.add(BodyChunk(glm::vec2(100, 200), 1.0f, 5.0f, 0.0f, 0.0f, room), glm::vec2(0));
+    world.add(BodyChunk(glm::vec2(160, 200), 1.0f, 5.0f, 0.0f, 0.0f, room), glm::vec2(0));
+    world.getConstraints().addDistance(0, 1, 40.0f);
+    world.getConstraints().setIterations(1);
+    world.step();
+
+    EXPECT_FLOAT_EQ(world.getChunk(0).getPosition().x, 110.0f);
+    EXPECT_FLOAT_EQ(world.getChunk(1).getPosition().x, 150.0f);
+
+    // Velocity moves with the correction, so the chunks don't fly apart again
+    EXPECT_FLOAT_EQ(world.getChunk(0).getVelocity().x, 10.0f);
+    EXPECT_FLOAT_EQ(world.getChunk(1).getVelocity().x, -10.0f);
+}
+
+// Test for the heavier end moving less
+TEST(ConstraintSolverTest, MassRatio) {
+    RoomGeometry room = emptyRoom();
+    PhysicsWorld world;
+    world.add(BodyChunk(glm::vec2(100, 200), 3.0f, 5.0f, 0.0f, 0.0f, room), glm::vec2(0));
+    world.add(BodyChunk(glm::vec2(160, 200), 1.0f, 5.0f, 0.0f, 0.0f, room), glm::vec2(0));
+    world.getConstraints().addDistance(0, 1, 40.0f);
+    world.getConstraints().setIterations(1);
+    world.step();
+
+    EXPECT_FLOAT_EQ(world.getChunk(0).getPosition().x, 105.0f);
+    EXPECT_FLOAT_EQ(world.getChunk(1).getPosition().x, 145.0f);
+}
+
+// Test for an angle constraint bending a joint back into its limits
+TEST(ConstraintSolverTest, Angle) {
+    RoomGeometry room = emptyRoom();
+    PhysicsWorld world;
+    world.add(BodyChunk(glm::vec2(100, 200), 1.0f, 5.0f, 0.0f, 0.0f, room), glm::vec2(0));
+    world.add(BodyChunk(glm::vec2(140, 200), 1.0f, 5.0f, 0.0f, 0.0f, room), glm::vec2(0));
+    world.add(BodyChunk(glm::vec2(140, 240), 1.0f, 5.0f, 0.0f, 0.0f, room), glm::vec2(0));
+
+    // Bent a right angle to the left, allowed are 45 degrees either way
+    world.getConstraints().addAngle(0, 1, 2, -0.7853982f, 0.7853982f);
+    world.getConstraints().setIterations(1);
+    world.step();
+
+    const glm::vec2 to_a = world.getChunk(0).getPosition() - world.getChunk(1).getPosition();
+    const glm::vec2 to_c = world.getChunk(2).getPosition() - world.getChunk(1).getPosition();
+    const float bend = std::atan2(to_c.x * to_a.y - to_c.y * to_a.x, -glm::dot(to_a, to_c));
+
+    EXPECT_NEAR(bend, 0.7853982f, 1e-4f);
+    EXPECT_NEAR(glm::length(to_a), 40.0f, 1e-3f);
+    EXPECT_NEAR(glm::length(to_c), 40.0f, 1e-3f);
+    EXPECT_EQ(world.getChunk(1).getPosition(), glm::vec2(140, 200));
+    EXPECT_THROW(world.getConstraints().addAngle(0, 1, 2, 1.0f, -1.0f), std::invalid_argument);
+}
+
+// Test for the colouring, a chain needs two colours for its distances and three for its angles
+TEST(ConstraintSolverTest, Colouring) {
+    RoomGeometry room = emptyRoom();
+    PhysicsWorld world;
+    addChain(world, room, glm::vec2(50, 200), 10, glm::vec2(0));
+    world.step();
+
+    EXPECT_EQ(world.getConstraints().getDistanceCount(), 9);
+    EXPECT_EQ(world.getConstraints().getAngleCount(), 8);
+    EXPECT_GE(world.getConstraints().getStats().colours, 3);
+    EXPECT_GE(world.getConstraints().getStats().last_ms, 0.0f);
+}
+
+// Test for connected chunks falling asleep and waking up together
+TEST(ConstraintSolverTest, SleepTogether) {
+    RoomGeometry room = floorRoom();
+    PhysicsWorld world;
+    addChain(world, room, glm::vec2(100, 40), 4, glm::vec2(0, -1));
+
+    for (int i = 0; i < 1000 && world.getActiveCount() + (world.getTicks() == 0) > 0; ++i) world.step();
+    for (size_t i = 0; i < world.getCount(); ++i) ASSERT_TRUE(world.getChunk(i).isAsleep());
+
+    world.getChunk(3).addVelocity(glm::vec2(0, 10));
+    world.step();
+    world.step();
+    for (size_t i = 0; i < world.getCount(); ++i) EXPECT_FALSE(world.getChunk(i).isAsleep());
+}
+
+// Test for creatures on SU_A40 stepping bit identically on any number of threads
+TEST(ConstraintSolverTest, DeterministicAcrossThreads) {
+    RoomGeometry room = RoomGeometry::fromFile("assets/levels/SU_A40.txt");
+
+    const auto simulate = [&](jobs::JobSystem *system) {
+        PhysicsWorld world;
+        if (system) {
+            world.setRunner([system](const size_t count, const std::function<void(size_t)> &batch) {
+                system->parallel_for(0, count, 1, [&](const size_t begin, const size_t end) {
+                    for (size_t i = begin; i < end; ++i) batch(i);
+                });
+            });
+        }
+
+        for (int i = 0; i < 40; ++i) addChain(world, room, glm::vec2(200.0f + (i % 8) * 100.0f, 500.0f + (i / 8) * 60.0f), 5, glm::vec2(0, -1.5f));
+        world.getConstraints().setIterations(6);
+
+        for (int i = 0; i < 200; ++i) world.step();
+        return world.checksum();
+    };
+
+    const uint64_t serial = simulate(nullptr);
+
+    jobs::JobSystem many(7);
+    EXPECT_EQ(simulate(&many), serial);
+}
@@ -0,0 +1,109 @@
+#include <gtest/gtest.h>
+#include "history.h"
+#include "physics.h"
+#include "geometry.h"
+#include "physics_fixtures.h"
+#include <glm/glm.hpp>
+#include <stdexcept>
+#include <vector>
+
+// Test for rolling back and stepping again ending on the exact same state
+TEST(PhysicsHistoryTest, RollbackResimulates) {
+    RoomGeometry room = RoomGeometry::fromFile("assets/levels/SU_A40.txt");
+    PhysicsWorld world;
+    populate(world, room);
+    PhysicsHistory history(64);
+
+    std::vector<uint64_t> checksums;
+    for (int i = 0; i < 100; ++i) {
+        history.save(world);
+        world.step();
+        checksums.push_back(world.checksum());
+    }
+
+    history.rollback(world, 30);
+    EXPECT_EQ(world.getTicks(), 70u);
+    EXPECT_EQ(history.getNewestTick(), 70u);
+
+    for (int i = 70; i < 100; ++i) {
+        history.save(world);
+        world.step();
+        EXPECT_EQ(world.checksum(), checksums[i]) << "tick " << i;
+    }
+}
+
+// Test for a corrected input after a rollback giving the same result as if it had been there all along
+TEST(PhysicsHistoryTest, CorrectedInput) {
+    RoomGeometry room = RoomGeometry::fromFile("assets/levels/SU_A40.txt");
+    const auto input = [](PhysicsWorld &world, const int tick, const bool late) {
+        if (tick == 40 && !late) world.getChunk(0).addVelocity(glm::vec2(20, 30));
+        if (tick == 40) world.setGravity(1, glm::vec2(0.5f, -1.0f));
+    };
+
+    // The input arrives on time
+    PhysicsWorld expected;
+    populate(expected, room);
+    uint64_t expected_at_50 = 0;
+    for (int i = 0; i < 60; ++i) {
+        input(expected, i, false);
+        expected.step();
+        if (i == 49) expected_at_50 = expected.checksum();
+    }
+
+    // It arrives 10 ticks late, roll back and step again with it
+    PhysicsWorld world;
+    populate(world, room);
+    PhysicsHistory history(16);
+    for (int i = 0; i < 50; ++i) {
+        history.save(world);
+        input(world, i, true);
+        world.step();
+    }
+    EXPECT_NE(world.checksum(), expected_at_50);
+
+    history.rollback(world, 10);
+    for (int i = 40; i < 60; ++i) {
+        history.save(world);
+        input(world, i, false);
+        world.step();
+    }
+
+    EXPECT_EQ(world.checksum(), expected.checksum());
+}
+
+// Test for the ring keeping the newest frames and refusing ticks it lost
+TEST(PhysicsHistoryTest, Ring) {
+    RoomGeometry room(20, 20, std::vector<int>(400, 0));
+    PhysicsWorld world;
+    world.add(BodyChunk(glm::vec2(100, 300), 1.0f, 8.0f, 0.0f, 0.0f, room), glm::vec2(0, -1));
+    PhysicsHistory history(8);
+
+    for (int i = 0; i < 20; ++i) {
+        history.save(world);
+        world.step();
+    }
+
+    EXPECT_EQ(history.getCount(), 8u);
+    EXPECT_EQ(history.getOldestTick(), 12u);
+    EXPECT_EQ(history.getNewestTick(), 19u);
+    EXPECT_THROW(history.rollback(world, 9), std::out_of_range);
+    EXPECT_THROW(history.rollback(world, 21), std::out_of_range);
+
+    // Rolled back over the last three ticks, those frames are gone
+    history.rollback(world, 3);
+    EXPECT_EQ(history.getNewestTick(), 17u);
+    EXPECT_EQ(history.getCount(), 6u);
+    EXPECT_FALSE(history.has(18));
+
+    // Restored position and velocity, the chunk has fallen 17 ticks with gravity 1
+    EXPECT_FLOAT_EQ(world.getChunk(0).getVelocity().y, -17.0f);
+    EXPECT_FLOAT_EQ(world.getChunk(0).getPosition().y, 300.0f - 17.0f * 18.0f / 2.0f);
+
+    // New chunks don't fit the old frames
+    world.add(BodyChunk(glm::vec2(200, 300), 1.0f, 8.0f, 0.0f, 0.0f, room), glm::vec2(0, -1));
+    EXPECT_THROW(history.rollback(world, 1), std::invalid_argument);
+    history.save(world);
+    EXPECT_EQ(history.getCount(), 1u);
+
+    EXPECT_THROW(PhysicsHistory(0), std::invalid_argument);
+}
@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+#include "demo.h"
+#include "input.h"
+#include "jobs.h"
+#include <glm/glm.hpp>
+#include <stdexcept>
+#include <vector>
+
+namespace {
+
+// Walks right, jumps now and then, teleports for a while, rewinds once, hops the worm and makes the debug windows' edits
+InputLog scriptedRun(const int ticks, const bool edits = true) {
+    InputLog log("SU_A40");
+    for (int tick = 0; tick < ticks; ++tick) {
+        InputFrame frame;
+        if (tick % 200 < 120) frame.buttons |= InputRight;
+        if (tick % 200 >= 150) frame.buttons |= InputLeft;
+        if (tick % 90 == 30) frame.buttons |= InputJump;
+        if (tick % 250 == 100) frame.buttons |= InputHop;
+        if (tick >= 300 && tick < 310) {
+            frame.buttons |= InputTeleport;
+            frame.cursor = glm::vec2(300.0f + static_cast<float>(tick), 600.0f);
+        }
+        if (tick == 400) frame.rewind = 60;
+        if (tick == 450) frame.room = "SU_A40";
+        if (edits && tick == 200) frame.edits.push_back(PhysicsEdit { .kind = PhysicsEdit::ChunkGravity, .chunk = 0, .gravity = glm::vec2(0, -150) });
+        if (edits && tick == 220) {
+            PhysicsEdit settings { .kind = PhysicsEdit::ChunkSettings, .chunk = 0 };
+            settings.mass = 2;
+            settings.radius = 12;
+            settings.friction = 0.3f;
+            settings.bounce = 0.4f;
+            settings.projectile = true;
+            frame.edits.push_back(settings);
+            frame.edits.push_back(PhysicsEdit { .kind = PhysicsEdit::SolverIterations, .iterations = 3 });
+        }
+        log.push(frame);
+    }
+    return log;
+}
+
+uint64_t replay(const InputLog &log, jobs::JobSystem *system) {
+    demo::Replay run("assets/levels/", log.getStartRoom());
+    if (system) {
+        run.getPhysics().setRunner([system](const size_t count, const std::function<void(size_t)> &batch) {
+            system->parallel_for(0, count, 1, [&](const size_t begin, const size_t end) {
+                for (size_t i = begin; i < end; ++i) batch(i);
+            });
+        });
+    }
+
+    for (size_t tick = 0; tick < log.getTickCount(); ++tick) run.tick(log.getFrame(tick));
+    return run.getPhysics().checksum();
+}
+
+}
+
+// Test for a log reading back the exact frames it was written with, held buttons only costing bytes when they change
+TEST(InputLogTest, RoundTrip) {
+    InputLog log = scriptedRun(1000);
+    log.setChecksum(0x0123456789ABCDEFull);
+
+    const std::vector<uint8_t> bytes = log.serialize();
+    EXPECT_LT(bytes.size(), 300u);
+
+    const InputLog read = InputLog::deserialize(bytes);
+    EXPECT_EQ(read.getStartRoom(), "SU_A40");
+    EXPECT_EQ(read.getChecksum(), 0x0123456789ABCDEFull);
+    ASSERT_EQ(read.getTickCount(), log.getTickCount());
+    for (size_t tick = 0; tick < log.getTickCount(); ++tick) {
+        EXPECT_EQ(read.getFrame(tick), log.getFrame(tick)) << "tick " << tick;
+    }
+
+    // Nothing pressed at all, trailing ticks included
+    InputLog idle("SU_A40");
+    for (int i = 0; i < 50; ++i) idle.push(InputFrame {});
+    EXPECT_EQ(InputLog::deserialize(idle.serialize()).getTickCount(), 50u);
+
+    std::vector<uint8_t> cut(bytes.begin(), bytes.end() - 3);
+    EXPECT_THROW(InputLog::deserialize(cut), std::runtime_error);
+    EXPECT_THROW(InputLog::deserialize(std::vector<uint8_t> { 'R', 'W', 'I', 'X', 1 }), std::runtime_error);
+
+    // Version 1 logs have no edits, 3 idle ticks and a checksum of 7
+    const InputLog old = InputLog::deserialize(std::vector<uint8_t> { 'R', 'W', 'I', 'N', 1, 1, 'A', 3, 0x80, 7, 0, 0, 0, 0, 0, 0, 0 });
+    EXPECT_EQ(old.getStartRoom(), "A");
+    EXPECT_EQ(old.getTickCount(), 3u);
+    EXPECT_EQ(old.getChecksum(), 7u);
+}
+
+// Test for the latch keeping presses until the tick takes them and held buttons until they're let go
+TEST(InputLogTest, Latch) {
+    InputLatch latch;
+    latch.hold(InputRight);
+    latch.press(InputJump);
+    latch.hold(InputRight | InputLeft);
+
+    InputFrame frame = latch.take();
+    EXPECT_EQ(frame.buttons, InputRight | InputLeft | InputJump);
+
+    frame = latch.take();
+    EXPECT_EQ(frame.buttons, InputRight | InputLeft);
+
+    // The cursor only counts while teleporting
+    latch.hold(0);
+    latch.setCursor(glm::vec2(5, 6));
+    EXPECT_EQ(latch.take().cursor, glm::vec2(0));
+
+    latch.rewound(10);
+    latch.rewound(5);
+    EXPECT_EQ(latch.take().rewind, 15u);
+
+    latch.rewound(10);
+    latch.enteredRoom("SU_A40");
+    frame = latch.take();
+    EXPECT_EQ(frame.rewind, 0u);
+    EXPECT_EQ(frame.room, "SU_A40");
+
+    // Edits stay in order and only go to one tick
+    latch.edit(PhysicsEdit { .kind = PhysicsEdit::SolverIterations, .iterations = 2 });
+    latch.edit(PhysicsEdit { .kind = PhysicsEdit::ChunkGravity, .chunk = 1 });
+    frame = latch.take();
+    ASSERT_EQ(frame.edits.size(), 2u);
+    EXPECT_EQ(frame.edits[0].kind, PhysicsEdit::SolverIterations);
+    EXPECT_EQ(frame.edits[1].chunk, 1u);
+    EXPECT_TRUE(latch.take().edits.empty());
+}
+
+// Test for a recorded run replaying to the same checksum from its log, on any number of threads
+TEST(InputLogTest, ReplayIsDeterministic) {
+    InputLog log = scriptedRun(600);
+    log.setChecksum(replay(log, nullptr));
+
+    const InputLog read = InputLog::deserialize(log.serialize());
+    EXPECT_EQ(replay(read, nullptr), read.getChecksum());
+
+    jobs::JobSystem many(7);
+    EXPECT_EQ(replay(read, &many), read.getChecksum());
+
+    // The inputs matter, edits included
+    InputLog still("SU_A40");
+    for (int i = 0; i < 600; ++i) still.push(InputFrame {});
+    EXPECT_NE(replay(still, nullptr), read.getChecksum());
+    EXPECT_NE(replay(scriptedRun(600, false), nullptr), read.getChecksum());
+}
@@ -0,0 +1,178 @@
+#include <gtest/gtest.h>
+#include "jobs.h"
+#include <atomic>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Test for the configured worker count
+TEST(JobSystemTest, WorkerCount) {
+    jobs::JobSystem three(3);
+    EXPECT_EQ(three.worker_count(), 3);
+
+    jobs::JobSystem automatic;
+    EXPECT_GE(automatic.worker_count(), 1);
+}
+
+// Test for every submitted job running exactly once
+TEST(JobSystemTest, SubmitAndWait) {
+    jobs::JobSystem system(4);
+    std::atomic<int> counter = 0;
+
+    std::vector<jobs::JobPtr> submitted;
+    for (int i = 0; i < 1000; ++i) submitted.push_back(system.submit("increment", [&] { ++counter; }));
+    for (const auto &job: submitted) system.wait(job);
+
+    EXPECT_EQ(counter, 1000);
+}
+
+// Test for dependencies, a job only starts after everything it depends on finished
+TEST(JobSystemTest, Dependencies) {
+    jobs::JobSystem system(4);
+
+    std::mutex lock;
+    std::vector<std::string> order;
+    const auto record = [&](const char *name) {
+        return [&, name] {
+            std::lock_guard guard(lock);
+            order.emplace_back(name);
+        };
+    };
+
+    const jobs::JobPtr a = system.submit("a", record("a"));
+    const jobs::JobPtr b = system.submit("b", record("b"), { a });
+    const jobs::JobPtr c = system.submit("c", record("c"), { a });
+    const jobs::JobPtr d = system.submit("d", record("d"), { b, c });
+    system.wait(d);
+
+    ASSERT_EQ(order.size(), 4);
+    EXPECT_EQ(order.front(), "a");
+    EXPECT_EQ(order.back(), "d");
+    EXPECT_TRUE(b->is_done());
+    EXPECT_TRUE(c->is_done());
+}
+
+// Test for depending on a job that already finished
+TEST(JobSystemTest, FinishedDependency) {
+    jobs::JobSystem system(2);
+    std::atomic<int> counter = 0;
+
+    const jobs::JobPtr first = system.submit("first", [&] { ++counter; });
+    system.wait(first);
+
+    const jobs::JobPtr second = system.submit("second", [&] { ++counter; }, { first, nullptr });
+    system.wait(second);
+
+    EXPECT_EQ(counter, 2);
+}
+
+// Test for parallel_for covering every index once, with uneven chunks
+TEST(JobSystemTest, ParallelFor) {
+    jobs::JobSystem system(4);
+    std::vector<std::atomic<int>> hits(1003);
+
+    system.parallel_for(0, hits.size(), 64, [&](const size_t begin, const size_t end) {
+        for (size_t i = begin; i < end; ++i) ++hits[i];
+    });
+
+    for (const auto &hit: hits) EXPECT_EQ(hit, 1);
+
+    // Empty ranges don't call anything
+    system.parallel_for(5, 5, 1, [&](size_t, size_t) { FAIL(); });
+}
+
+// Test for waiting inside a job, the worker helps instead of deadlocking
+TEST(JobSystemTest, NestedParallelFor) {
+    jobs::JobSystem system(2);
+    std::atomic<int> counter = 0;
+
+    system.parallel_for(0, 8, 1, [&](size_t, size_t) {
+        system.parallel_for(0, 8, 1, [&](size_t, size_t) { ++counter; });
+    });
+
+    EXPECT_EQ(counter, 64);
+}
+
+// Test for exceptions coming out of wait and parallel_for
+TEST(JobSystemTest, Exceptions) {
+    jobs::JobSystem system(2);
+
+    const jobs::JobPtr job = system.submit("throws", [] { throw std::runtime_error("job failed"); });
+    EXPECT_THROW(system.wait(job), std::runtime_error);
+
+    EXPECT_THROW(system.parallel_for(0, 16, 1, [](const size_t begin, size_t) {
+        if (begin == 7) throw std::runtime_error("chunk failed");
+    }), std::runtime_error);
+}
+
+// Test for results through async
+TEST(JobSystemTest, Async) {
+    jobs::JobSystem system(2);
+
+    std::future<int> answer = system.async("answer", [] { return 42; });
+    EXPECT_EQ(answer.get(), 42);
+
+    std::future<int> failed = system.async("failed", []() -> int { throw std::runtime_error("no answer"); });
+    EXPECT_THROW(failed.get(), std::runtime_error);
+}
+
+// Test for waits never running background jobs, they're left to idle workers
+TEST(JobSystemTest, BackgroundJobs) {
+    jobs::JobSystem system(1);
+
+    std::atomic<bool> started = false, release = false;
+    std::future<void> blocker = system.async("blocker", [&] {
+        started = true;
+        while (!release) std::this_thread::yield();
+    });
+    while (!started) std::this_thread::yield();
+
+    // The only worker is busy, a helping wait would be the one to pick this up
+    std::atomic<bool> decoded = false;
+    std::future<void> decode = system.async("decode", [&] { decoded = true; });
+
+    std::atomic<int> chunks = 0;
+    system.parallel_for(0, 8, 1, [&](size_t, size_t) { ++chunks; });
+    EXPECT_EQ(chunks, 8);
+    EXPECT_FALSE(decoded);
+
+    release = true;
+    blocker.get();
+    decode.get();
+    EXPECT_TRUE(decoded);
+}
+
+// Test for the profiling hook seeing every job with its name
+TEST(JobSystemTest, Profiler) {
+    jobs::JobSystem system(2);
+
+    std::mutex lock;
+    std::vector<jobs::JobSample> samples;
+    system.set_profiler([&](const jobs::JobSample &sample) {
+        std::lock_guard guard(lock);
+        samples.push_back(sample);
+    });
+
+    system.wait(system.submit("profiled", [] {}));
+    system.parallel_for(0, 4, 1, [](size_t, size_t) {});
+
+    std::lock_guard guard(lock);
+    ASSERT_EQ(samples.size(), 5);
+    EXPECT_STREQ(samples[0].name, "profiled");
+    for (const auto &sample: samples) {
+        EXPECT_LE(sample.start, sample.end);
+        EXPECT_LT(sample.worker, 2);
+    }
+}
+
+// Test for the destructor finishing queued work
+TEST(JobSystemTest, DestructorDrains) {
+    std::atomic<int> counter = 0;
+    {
+        jobs::JobSystem system(1);
+        for (int i = 0; i < 100; ++i) system.submit("drain", [&] { ++counter; });
+    }
+
+    EXPECT_EQ(counter, 100);
+}
@@ -0,0 +1,358 @@
+#include <gtest/gtest.h>
+#include "physics.h"
+#include "geometry.h"
+#include "jobs.h"
+#include "physics_fixtures.h"
+#include <glm/glm.hpp>
+#include <cmath>
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Runs physics batches on a job system, the way the game does
+PhysicsWorld::BatchRunner jobRunner(jobs::JobSystem &system) {
+    return [&system](const size_t count, const std::function<void(size_t)> &batch) {
+        system.parallel_for(0, count, 1, [&](const size_t begin, const size_t end) {
+            for (size_t i = begin; i < end; ++i) batch(i);
+        });
+    };
+}
+
+uint64_t simulate(RoomGeometry &room, const PhysicsWorld::BatchRunner &runner, const int ticks) {
+    PhysicsWorld world;
+    world.setRunner(runner);
+    populate(world, room);
+
+    for (int i = 0; i < ticks; ++i) world.step();
+    return world.checksum();
+}
+
+struct FloorlessFeatures : DefaultChunkFeatures {
+    static constexpr bool GoThroughFloors = true;
+};
+
+struct GhostFeatures : DefaultChunkFeatures {
+    static constexpr bool CollideWithTerrain = false;
+};
+
+}
+
+// Test for a physics world stepping one chunk the same way BodyChunk::Update does
+TEST(PhysicsWorldTest, MatchesUpdate) {
+    RoomGeometry room(10, 10, std::vector<int>(100, 0));
+
+    BodyChunk chunk(glm::vec2(100, 150), 1.0f, 16.0f, 0.55f, 0.05f, room);
+    PhysicsWorld world;
+    world.add(chunk, glm::vec2(0, -2));
+
+    for (int i = 0; i < 50; ++i) {
+        chunk.Update(glm::vec2(0, -2));
+        world.step();
+    }
+
+    EXPECT_EQ(world.getChunk(0).getPosition(), chunk.getPosition());
+    EXPECT_EQ(world.getChunk(0).getVelocity(), chunk.getVelocity());
+    EXPECT_EQ(world.getTicks(), 50);
+}
+
+// Test for overlapping chunks being pushed apart evenly
+TEST(PhysicsWorldTest, ResolvesOverlap) {
+    RoomGeometry room(20, 20, std::vector<int>(400, 0));
+
+    PhysicsWorld world;
+    world.add(BodyChunk(glm::vec2(190, 200), 1.0f, 10.0f, 0.0f, 0.0f, room), glm::vec2(0));
+    world.add(BodyChunk(glm::vec2(200, 200), 1.0f, 10.0f, 0.0f, 0.0f, room), glm::vec2(0));
+    world.step();
+
+    EXPECT_FLOAT_EQ(world.getChunk(0).getPosition().x, 185.0f);
+    EXPECT_FLOAT_EQ(world.getChunk(1).getPosition().x, 205.0f);
+    EXPECT_FLOAT_EQ(world.getChunk(0).getPosition().y, 200.0f);
+}
+
+// Test for heavier chunks moving less when pushed apart
+TEST(PhysicsWorldTest, MassWeightedSeparation) {
+    RoomGeometry room(20, 20, std::vector<int>(400, 0));
+
+    PhysicsWorld world;
+    world.add(BodyChunk(glm::vec2(190, 200), 3.0f, 10.0f, 0.0f, 0.0f, room), glm::vec2(0));
+    world.add(BodyChunk(glm::vec2(200, 200), 1.0f, 10.0f, 0.0f, 0.0f, room), glm::vec2(0));
+    world.step();
+
+    EXPECT_FLOAT_EQ(world.getChunk(0).getPosition().x, 187.5f);
+    EXPECT_FLOAT_EQ(world.getChunk(1).getPosition().x, 207.5f);
+}
+
+// Test for chunks hitting head on trading their speed, momentum is kept
+TEST(PhysicsWorldTest, VelocityExchange) {
+    RoomGeometry room(20, 20, std::vector<int>(400, 0));
+
+    PhysicsWorld world;
+    world.add(BodyChunk(glm::vec2(185, 200), 1.0f, 10.0f, 0.0f, 1.0f, room), glm::vec2(0));
+    world.add(BodyChunk(glm::vec2(205, 200), 2.0f, 10.0f, 0.0f, 1.0f, room), glm::vec2(0));
+    world.getChunk(0).setVelocity(glm::vec2(2, 0));
+    world.getChunk(1).setVelocity(glm::vec2(-1, 0));
+    world.step();
+
+    // Fully elastic, the velocities swap their order around the centre of mass
+    EXPECT_FLOAT_EQ(world.getChunk(0).getVelocity().x, -2.0f);
+    EXPECT_FLOAT_EQ(world.getChunk(1).getVelocity().x, 1.0f);
+    EXPECT_FLOAT_EQ(world.getChunk(0).getVelocity().x * 1.0f + world.getChunk(1).getVelocity().x * 2.0f, 0.0f);
+
+    // Moving apart now, another step doesn't touch the velocities
+    world.step();
+    EXPECT_FLOAT_EQ(world.getChunk(0).getVelocity().x, -2.0f);
+}
+
+// Test for a chunk resting on the floor falling asleep and waking up when pushed
+TEST(PhysicsWorldTest, SleepAndWake) {
+    std::vector<int> tiles(100, 0);
+    for (int x = 0; x < 10; ++x) tiles[90 + x] = 1; // Bottom row, tile rows are top first
+    RoomGeometry room(10, 10, tiles);
+
+    PhysicsWorld world;
+    world.add(BodyChunk(glm::vec2(100, 40), 1.0f, 10.0f, 0.3f, 0.1f, room), glm::vec2(0, -1));
+
+    int ticks = 0;
+    while (!world.getChunk(0).isAsleep() && ticks < 500) {
+        world.step();
+        ticks++;
+    }
+
+    ASSERT_TRUE(world.getChunk(0).isAsleep());
+    EXPECT_GE(ticks, PhysicsWorld::SleepTicks);
+    EXPECT_EQ(world.getActiveCount(), 1); // The tick it fell asleep in still ran it
+
+    const glm::vec2 resting = world.getChunk(0).getPosition();
+    world.step();
+    EXPECT_EQ(world.getActiveCount(), 0);
+    EXPECT_EQ(world.getChunk(0).getPosition(), resting);
+
+    world.getChunk(0).addVelocity(glm::vec2(5, 0));
+    EXPECT_FALSE(world.getChunk(0).isAsleep());
+    world.step();
+    EXPECT_EQ(world.getActiveCount(), 1);
+    EXPECT_GT(world.getChunk(0).getPosition().x, resting.x);
+}
+
+// Test for a sleeping chunk waking up when the floor under it goes away
+TEST(PhysicsWorldTest, WakeOnTerrainChange) {
+    std::vector<int> tiles(100, 0);
+    for (int x = 0; x < 10; ++x) tiles[80 + x] = 1; // Second row from the bottom
+    RoomGeometry room(10, 10, tiles);
+
+    PhysicsWorld world;
+    world.add(BodyChunk(glm::vec2(100, 60), 1.0f, 10.0f, 0.3f, 0.1f, room), glm::vec2(0, -1));
+    for (int i = 0; i < 500 && !world.getChunk(0).isAsleep(); ++i) world.step();
+    ASSERT_TRUE(world.getChunk(0).isAsleep());
+
+    // Far away changes leave it asleep
+    room.setTileType(9, 8, 1);
+    world.step();
+    EXPECT_TRUE(world.getChunk(0).isAsleep());
+
+    room.setTileType(4, 1, 0);
+    room.setTileType(5, 1, 0);
+    world.step();
+    EXPECT_FALSE(world.getChunk(0).isAsleep());
+
+    const float before = world.getChunk(0).getPosition().y;
+    for (int i = 0; i < 5; ++i) world.step();
+    EXPECT_LT(world.getChunk(0).getPosition().y, before);
+}
+
+// Test for an awake chunk waking the sleeping one it lands on
+TEST(PhysicsWorldTest, WakeOnContact) {
+    std::vector<int> tiles(100, 0);
+    for (int x = 0; x < 10; ++x) tiles[90 + x] = 1;
+    RoomGeometry room(10, 10, tiles);
+
+    PhysicsWorld world;
+    world.add(BodyChunk(glm::vec2(100, 40), 1.0f, 10.0f, 0.3f, 0.1f, room), glm::vec2(0, -1));
+    for (int i = 0; i < 500 && !world.getChunk(0).isAsleep(); ++i) world.step();
+    ASSERT_TRUE(world.getChunk(0).isAsleep());
+
+    world.add(BodyChunk(glm::vec2(105, 120), 1.0f, 10.0f, 0.3f, 0.1f, room), glm::vec2(0, -1));
+    for (int i = 0; i < 100 && world.getChunk(0).isAsleep(); ++i) world.step();
+
+    EXPECT_FALSE(world.getChunk(0).isAsleep());
+}
+
+// Test for chunks that don't fill the last batch still being stepped
+TEST(PhysicsWorldTest, PartialBatch) {
+    RoomGeometry room(100, 10, std::vector<int>(1000, 0));
+
+    PhysicsWorld world;
+    for (size_t i = 0; i < PhysicsWorld::BatchSize + 3; ++i) {
+        world.add(BodyChunk(glm::vec2(static_cast<float>(i) * 20.0f + 10.0f, 100), 1.0f, 5.0f, 0.0f, 0.0f, room), glm::vec2(1, 0));
+    }
+    world.step();
+
+    for (size_t i = 0; i < world.getCount(); ++i) EXPECT_FLOAT_EQ(world.getChunk(i).getVelocity().x, 1.0f);
+}
+
+// Test for a chunk falling several tiles per tick landing on a floor one tile thick instead of going through it
+TEST(PhysicsWorldTest, FastFallLands) {
+    std::vector<int> tiles(20 * 40, 0);
+    for (int x = 0; x < 20; ++x) tiles[34 * 20 + x] = 1; // Row 5 from the bottom
+    RoomGeometry room(20, 40, tiles);
+
+    BodyChunk chunk(glm::vec2(200, 700), 1.0f, 8.0f, 0.0f, 0.0f, room);
+    chunk.setVelocity(glm::vec2(0, -45));
+    for (int i = 0; i < 30; ++i) chunk.Update(glm::vec2(0, -5));
+
+    EXPECT_FLOAT_EQ(chunk.getPosition().y, 128.0f);
+    EXPECT_TRUE(chunk.isOnSolid());
+}
+
+// Test for fast chunks aimed at a single tile from every direction never ending up past it
+TEST(PhysicsWorldTest, FastChunksDontTunnel) {
+    std::vector<int> tiles(400, 0);
+    tiles[9 * 20 + 10] = 1; // Tile (10, 10), rows are top first
+    RoomGeometry room(20, 20, tiles);
+    const glm::vec2 centre(210, 210);
+
+    for (int angle = 0; angle < 360; angle += 15) {
+        for (float speed = 40.0f; speed <= 400.0f; speed += 60.0f) {
+            const glm::vec2 direction(std::cos(glm::radians(static_cast<float>(angle))), std::sin(glm::radians(static_cast<float>(angle))));
+
+            BodyChunk chunk(centre - direction * (speed * 1.5f + 40.0f), 1.0f, 8.0f, 0.0f, 0.0f, room);
+            chunk.setVelocity(direction * speed);
+            for (int i = 0; i < 8; ++i) chunk.Update(glm::vec2(0));
+
+            EXPECT_LE(glm::dot(chunk.getPosition() - centre, direction), 18.0f) << angle << " degrees at " << speed;
+        }
+    }
+}
+
+// Test for projectiles far beyond the substep limit stopping at the first tile on their way
+TEST(PhysicsWorldTest, ProjectileTimeOfImpact) {
+    std::vector<int> tiles(60 * 60, 0);
+    for (int y = 0; y < 60; ++y) tiles[y * 60 + 40] = 1;
+    RoomGeometry room(60, 60, tiles);
+
+    BodyChunk chunk(glm::vec2(100, 300), 1.0f, 4.0f, 0.0f, 0.0f, room);
+    chunk.setProjectile(true);
+    EXPECT_TRUE(chunk.isProjectile());
+    chunk.setVelocity(glm::vec2(900, 450));
+    chunk.Update(glm::vec2(0));
+
+    EXPECT_LT(chunk.getPosition().x, 800.0f);
+    EXPECT_GT(chunk.getPosition().x, 700.0f);
+
+    // Not a projectile, still more than MaxSubsteps steps of movement
+    BodyChunk fast(glm::vec2(100, 300), 1.0f, 4.0f, 0.0f, 0.0f, room);
+    fast.setVelocity(glm::vec2(900, 0));
+    fast.Update(glm::vec2(0));
+    EXPECT_LT(fast.getPosition().x, 800.0f);
+}
+
+// Test for slow chunks moving in one step, exactly like before substeps
+TEST(PhysicsWorldTest, SlowChunkSingleStep) {
+    RoomGeometry room(20, 20, std::vector<int>(400, 0));
+
+    BodyChunk chunk(glm::vec2(100, 100), 1.0f, 16.0f, 0.0f, 0.0f, room);
+    EXPECT_FLOAT_EQ(chunk.getMaxStep(), 8.0f);
+
+    chunk.setVelocity(glm::vec2(3.3f, -7.1f));
+    chunk.Update(glm::vec2(0));
+    EXPECT_EQ(chunk.getPosition(), glm::vec2(100, 100) + glm::vec2(3.3f, -7.1f));
+}
+
+// Test for chunks without a radius still covering their whole velocity in a tick, forwards
+TEST(PhysicsWorldTest, ZeroRadiusFastChunk) {
+    RoomGeometry room(40, 40, std::vector<int>(1600, 0));
+
+    for (const float radius : { 0.0f, -2.0f }) {
+        BodyChunk chunk(glm::vec2(100, 400), 1.0f, radius, 0.0f, 0.0f, room);
+        EXPECT_GT(chunk.getMaxStep(), 0.0f);
+
+        chunk.setVelocity(glm::vec2(60, 0));
+        chunk.Update(glm::vec2(0));
+        EXPECT_NEAR(chunk.getPosition().x, 160.0f, 1e-3f) << radius;
+        EXPECT_FLOAT_EQ(chunk.getPosition().y, 400.0f) << radius;
+    }
+}
+
+// Test for bit identical results on SU_A40 no matter how many threads run the batches
+TEST(PhysicsWorldTest, DeterministicAcrossThreads) {
+    RoomGeometry room = RoomGeometry::fromFile("assets/levels/SU_A40.txt");
+
+    const uint64_t serial = simulate(room, nullptr, 200);
+
+    jobs::JobSystem one(1);
+    EXPECT_EQ(simulate(room, jobRunner(one), 200), serial);
+
+    jobs::JobSystem many(7);
+    EXPECT_EQ(simulate(room, jobRunner(many), 200), serial);
+    EXPECT_EQ(simulate(room, jobRunner(many), 200), serial);
+}
+
+// Test for variants with compiled in features stepping bit identically to the same features as runtime flags
+TEST(PhysicsWorldTest, VariantsMatchRuntimeFlags) {
+    RoomGeometry room = RoomGeometry::fromFile("assets/levels/SU_A40.txt");
+
+    BasicPhysicsWorld<DefaultChunkFeatures> compiled;
+    BasicPhysicsWorld<RuntimeChunkFeatures> flags;
+    populate(compiled, room);
+    populate(flags, room);
+    for (int i = 0; i < 200; ++i) {
+        compiled.step();
+        flags.step();
+    }
+    EXPECT_EQ(compiled.checksum(), flags.checksum());
+
+    BasicPhysicsWorld<FloorlessFeatures> floorless;
+    BasicPhysicsWorld<RuntimeChunkFeatures> floorless_flags;
+    populate(floorless, room);
+    populate(floorless_flags, room, RuntimeChunkFeatures { true, true, true, true });
+    for (int i = 0; i < 200; ++i) {
+        floorless.step();
+        floorless_flags.step();
+    }
+    EXPECT_EQ(floorless.checksum(), floorless_flags.checksum());
+    EXPECT_NE(floorless.checksum(), compiled.checksum());
+}
+
+// Test for chunks without terrain collision going through solid tiles, the size of the variant not growing for the features
+TEST(PhysicsWorldTest, GhostIgnoresTerrain) {
+    std::vector<int> tiles(400, 0);
+    for (int x = 0; x < 20; ++x) tiles[15 * 20 + x] = 1; // Row 4 from the bottom
+    RoomGeometry room(20, 20, tiles);
+
+    BasicBodyChunk<GhostFeatures> ghost(glm::vec2(100, 150), 1.0f, 8.0f, 0.0f, 0.0f, room);
+    for (int i = 0; i < 20; ++i) ghost.Update(glm::vec2(0, -1));
+    EXPECT_LT(ghost.getPosition().y, 0.0f);
+    EXPECT_FALSE(ghost.isOnSolid());
+
+    EXPECT_EQ(sizeof(BasicBodyChunk<GhostFeatures>), sizeof(BodyChunk));
+    EXPECT_GT(sizeof(BasicBodyChunk<RuntimeChunkFeatures>), sizeof(BodyChunk));
+
+    // Turned off at runtime does the same
+    BasicBodyChunk<RuntimeChunkFeatures> flags(glm::vec2(100, 150), 1.0f, 8.0f, 0.0f, 0.0f, room);
+    flags.getFeatures().CollideWithTerrain = false;
+    for (int i = 0; i < 20; ++i) flags.Update(glm::vec2(0, -1));
+    EXPECT_EQ(flags.getPosition(), ghost.getPosition());
+}
+
+// Test for chunks going through floors falling through the top of a tile but stopping at walls
+TEST(PhysicsWorldTest, GoThroughFloors) {
+    std::vector<int> tiles(400, 0);
+    for (int x = 0; x < 20; ++x) tiles[15 * 20 + x] = 1; // Row 4 from the bottom
+    for (int y = 0; y < 20; ++y) tiles[y * 20 + 15] = 1; // Column 15
+    RoomGeometry room(20, 20, tiles);
+
+    BasicBodyChunk<FloorlessFeatures> falling(glm::vec2(100, 150), 1.0f, 8.0f, 0.0f, 0.0f, room);
+    for (int i = 0; i < 15; ++i) falling.Update(glm::vec2(0, -1));
+    EXPECT_LT(falling.getPosition().y, 60.0f);
+    EXPECT_FALSE(falling.isOnSolid());
+
+    BasicBodyChunk<FloorlessFeatures> fast(glm::vec2(100, 150), 1.0f, 8.0f, 0.0f, 0.0f, room);
+    fast.setVelocity(glm::vec2(0, -60));
+    fast.Update(glm::vec2(0));
+    EXPECT_FLOAT_EQ(fast.getPosition().y, 90.0f);
+
+    BasicBodyChunk<FloorlessFeatures> sliding(glm::vec2(250, 150), 1.0f, 8.0f, 0.0f, 0.0f, room);
+    for (int i = 0; i < 20; ++i) sliding.Update(glm::vec2(2, 0));
+    EXPECT_LE(sliding.getPosition().x, 292.0f);
+}
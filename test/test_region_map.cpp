@@ -0,0 +1,78 @@
+#include <gtest/gtest.h>
+#include "region.h"
+#include <fstream>
+#include <sstream>
+
+static RegionMap testRegion() {
+    std::istringstream world(
+        "// Test region\n"
+        "ROOMS\n"
+        "SU_A40 : SU_A41, DISCONNECTED, SU_A22\n"
+        "SU_A41 : SU_A40, SU_S01\n"
+        "SU_A22 : SU_A40, GATE_SU_HI\n"
+        "SU_S01 : SU_A41 : SHELTER\n"
+        "SU_A99 : DISCONNECTED\n"
+        "END ROOMS\n"
+        "CREATURES\n"
+        "SU_A40 : 2-Green\n"
+        "END CREATURES\n"
+    );
+    return RegionMap::fromStream(world);
+}
+
+// Test for parsing rooms, connections and tags
+TEST(RegionMapTest, FromStreamValid) {
+    const RegionMap region = testRegion();
+
+    ASSERT_EQ(region.getRooms().size(), 5);
+    EXPECT_TRUE(region.contains("SU_A40"));
+    EXPECT_FALSE(region.contains("GATE_SU_HI"));
+
+    const RegionMap::Room &room = region.getRoom("SU_A40");
+    ASSERT_EQ(room.connections.size(), 2);
+    EXPECT_EQ(room.connections[0], "SU_A41");
+    EXPECT_EQ(room.connections[1], "SU_A22");
+    EXPECT_TRUE(room.tag.empty());
+
+    EXPECT_EQ(region.getRoom("SU_S01").tag, "SHELTER");
+    EXPECT_TRUE(region.getRoom("SU_A99").connections.empty());
+}
+
+// Test for neighbours by depth, rooms outside the region are skipped
+TEST(RegionMapTest, Neighbours) {
+    const RegionMap region = testRegion();
+
+    const std::vector<std::string> near = region.neighbours("SU_A40", 1);
+    ASSERT_EQ(near.size(), 2);
+    EXPECT_EQ(near[0], "SU_A41");
+    EXPECT_EQ(near[1], "SU_A22");
+
+    const std::vector<std::string> far = region.neighbours("SU_A40", 2);
+    ASSERT_EQ(far.size(), 3);
+    EXPECT_EQ(far[2], "SU_S01");
+
+    EXPECT_TRUE(region.neighbours("SU_A99", 3).empty());
+    EXPECT_TRUE(region.neighbours("SU_A40", 0).empty());
+}
+
+// Test for invalid world files
+TEST(RegionMapTest, FromStreamInvalid) {
+    std::istringstream no_rooms("CREATURES\nEND CREATURES\n");
+    EXPECT_THROW(RegionMap::fromStream(no_rooms), std::runtime_error);
+
+    std::istringstream unterminated("ROOMS\nSU_A40 : SU_A41\n");
+    EXPECT_THROW(RegionMap::fromStream(unterminated), std::runtime_error);
+
+    std::istringstream bad_line("ROOMS\nSU_A40 SU_A41\nEND ROOMS\n");
+    EXPECT_THROW(RegionMap::fromStream(bad_line), std::runtime_error);
+
+    std::istringstream duplicate("ROOMS\nSU_A40 : SU_A41\nSU_A40 : SU_A22\nEND ROOMS\n");
+    EXPECT_THROW(RegionMap::fromStream(duplicate), std::runtime_error);
+
+    EXPECT_THROW(testRegion().getRoom("SU_B01"), std::runtime_error);
+}
+
+// Test for RegionMap fromFile with a missing file
+TEST(RegionMapTest, FromFileInvalid) {
+    EXPECT_THROW(RegionMap::fromFile("nonexistent_file.txt"), std::runtime_error);
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+#include "cameras.h"
+#include <glm/glm.hpp>
+#include <sstream>
+
+// Two cameras side by side with 200 pixels of overlap, the room is exactly one view tall
+static RoomDescriptor twoCameraRoom() {
+    std::istringstream header(
+        "TEST\n"
+        "120*40|-1|0\n"
+        "1*1\n"
+        "10,0|1210,0\n"
+        "Border: Solid\n"
+    );
+    return RoomDescriptor::fromStream(header);
+}
+
+// Test for camera origins, measured from the top of the room in the file
+TEST(RoomCamerasTest, Origins) {
+    const RoomCameras cameras(twoCameraRoom());
+
+    ASSERT_EQ(cameras.getCount(), 2);
+    EXPECT_FLOAT_EQ(cameras.getOrigin(0).x, 0);
+    EXPECT_FLOAT_EQ(cameras.getOrigin(0).y, 0);
+    EXPECT_FLOAT_EQ(cameras.getOrigin(1).x, 1200);
+    EXPECT_FLOAT_EQ(cameras.getOffset(1).x, -1200);
+}
+
+// Test for edge distances inside and outside of a view
+TEST(RoomCamerasTest, EdgeDistance) {
+    const RoomCameras cameras(twoCameraRoom());
+
+    EXPECT_FLOAT_EQ(cameras.edgeDistance(0, glm::vec2(700, 400)), 400);
+    EXPECT_FLOAT_EQ(cameras.edgeDistance(0, glm::vec2(1390, 400)), 10);
+    EXPECT_FLOAT_EQ(cameras.edgeDistance(0, glm::vec2(1500, 400)), -100);
+}
+
+// Test for staying on the current camera in the overlap
+TEST(RoomCamerasTest, UpdateHysteresis) {
+    const RoomCameras cameras(twoCameraRoom());
+
+    // Right in the middle of the overlap both views are as good, nothing changes
+    EXPECT_EQ(cameras.update(0, glm::vec2(1300, 400)), 0);
+    EXPECT_EQ(cameras.update(1, glm::vec2(1300, 400)), 1);
+
+    // Close to the edge of view 0 and well inside view 1
+    EXPECT_EQ(cameras.update(0, glm::vec2(1380, 400)), 1);
+
+    // Left view 0 entirely
+    EXPECT_EQ(cameras.update(0, glm::vec2(1500, 400)), 1);
+
+    // Deep inside the current view
+    EXPECT_EQ(cameras.update(1, glm::vec2(2000, 400)), 1);
+}
+
+// Test for the views worth prefetching
+TEST(RoomCamerasTest, Neighbours) {
+    const RoomCameras cameras(twoCameraRoom());
+
+    // Standing still far away from view 1
+    EXPECT_TRUE(cameras.neighbours(0, glm::vec2(200, 400), glm::vec2(0, 0), 40, 200).empty());
+
+    // Running towards it
+    const std::vector<int> ahead = cameras.neighbours(0, glm::vec2(200, 400), glm::vec2(30, 0), 40, 200);
+    ASSERT_EQ(ahead.size(), 1);
+    EXPECT_EQ(ahead[0], 1);
+
+    // Close enough to its edge without moving
+    EXPECT_EQ(cameras.neighbours(0, glm::vec2(1100, 400), glm::vec2(0, 0), 40, 200).size(), 1);
+}
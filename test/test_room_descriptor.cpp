@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+#include "descriptor.h"
+#include <glm/glm.hpp>
+#include <fstream>
+#include <sstream>
+
+// Header of SU_A40, the room the demo loads
+TEST(RoomDescriptorTest, FromStreamValid) {
+    std::istringstream header(
+        "SU_A40\n"
+        "50*36|-1|0\n"
+        "3.3937*6.1223|0|0\n"
+        "-200,-20\n"
+        "Border: Passable\n"
+        "1,34,18|\n"
+    );
+
+    const RoomDescriptor room = RoomDescriptor::fromStream(header);
+
+    EXPECT_EQ(room.name, "SU_A40");
+    EXPECT_EQ(room.x_size, 50);
+    EXPECT_EQ(room.y_size, 36);
+    EXPECT_EQ(room.water_level, -1);
+    EXPECT_FALSE(room.hasWater());
+    EXPECT_FALSE(room.water_in_front);
+    EXPECT_FLOAT_EQ(room.light_angle.x, 3.3937f);
+    EXPECT_FLOAT_EQ(room.light_angle.y, 6.1223f);
+    ASSERT_EQ(room.cameras.size(), 1);
+    EXPECT_EQ(room.cameras[0], glm::ivec2(-200, -20));
+    EXPECT_EQ(room.border, RoomDescriptor::BorderMode::Passable);
+}
+
+// Test for rooms with water and several cameras
+TEST(RoomDescriptorTest, FromStreamWaterAndCameras) {
+    std::istringstream header(
+        "HI_B04\r\n"
+        "96*35|12|1\r\n"
+        "-1*2.5\r\n"
+        "0,0|1000,20|2000,-40\r\n"
+        "Border: Solid\r\n"
+    );
+
+    const RoomDescriptor room = RoomDescriptor::fromStream(header);
+
+    EXPECT_EQ(room.name, "HI_B04");
+    EXPECT_TRUE(room.hasWater());
+    EXPECT_EQ(room.water_level, 12);
+    EXPECT_TRUE(room.water_in_front);
+    EXPECT_FLOAT_EQ(room.light_angle.x, -1.0f);
+    ASSERT_EQ(room.cameras.size(), 3);
+    EXPECT_EQ(room.cameras[1], glm::ivec2(1000, 20));
+    EXPECT_EQ(room.cameras[2], glm::ivec2(2000, -40));
+    EXPECT_EQ(room.border, RoomDescriptor::BorderMode::Solid);
+}
+
+// Test for headers that end early
+TEST(RoomDescriptorTest, FromStreamMissingLines) {
+    std::istringstream header("SU_A40\n50*36|-1|0\n");
+    EXPECT_THROW(RoomDescriptor::fromStream(header), std::runtime_error);
+}
+
+// Test for invalid size and camera lines
+TEST(RoomDescriptorTest, FromStreamInvalidNumbers) {
+    std::istringstream bad_size("SU_A40\n50x36|-1|0\n1*1\n0,0\nBorder: Solid\n");
+    EXPECT_THROW(RoomDescriptor::fromStream(bad_size), std::runtime_error);
+
+    std::istringstream bad_camera("SU_A40\n50*36|-1|0\n1*1\n0;0\nBorder: Solid\n");
+    EXPECT_THROW(RoomDescriptor::fromStream(bad_camera), std::runtime_error);
+
+    std::istringstream no_camera("SU_A40\n50*36|-1|0\n1*1\n\nBorder: Solid\n");
+    EXPECT_THROW(RoomDescriptor::fromStream(no_camera), std::runtime_error);
+}
+
+// Test for RoomDescriptor fromFile with valid file
+TEST(RoomDescriptorTest, FromFileValid) {
+    std::ofstream file("test_descriptor.txt");
+    file << "TEST\n";
+    file << "3*3|1|0\n";
+    file << "1*1|0|0\n";
+    file << "10,20\n";
+    file << "Border: Solid\n";
+    file.close();
+
+    const RoomDescriptor room = RoomDescriptor::fromFile("test_descriptor.txt");
+    EXPECT_EQ(room.x_size, 3);
+    EXPECT_EQ(room.water_level, 1);
+    EXPECT_EQ(room.cameras[0], glm::ivec2(10, 20));
+
+    std::remove("test_descriptor.txt");
+}
+
+// Test for RoomDescriptor fromFile with a missing file
+TEST(RoomDescriptorTest, FromFileInvalid) {
+    EXPECT_THROW(RoomDescriptor::fromFile("nonexistent_file.txt"), std::runtime_error);
+}
@@ -60,6 +60,24 @@ TEST(RoomGeometryTest, FromFileValid) {
     std::remove("test_room.txt");
 }
 
+// Test for setTileType bumping the revision of the room and of the tile
+TEST(RoomGeometryTest, SetTileType) {
+    RoomGeometry room(3, 2, {1, 0, 1, 1, 0, 1});
+    EXPECT_EQ(room.getRevision(), 0);
+
+    room.setTileType(1, 0, 1);
+    EXPECT_EQ(room.getTileType(1, 0), 1);
+    EXPECT_EQ(room.getRevision(), 1);
+    EXPECT_EQ(room.getTileRevision(1, 0), 1);
+    EXPECT_EQ(room.getTileRevision(1, 1), 0);
+
+    // Same type isn't a change
+    room.setTileType(1, 0, 1);
+    EXPECT_EQ(room.getRevision(), 1);
+
+    EXPECT_THROW(room.setTileType(3, 0, 1), std::out_of_range);
+}
+
 // Test for RoomGeometry fromFile with invalid file
 TEST(RoomGeometryTest, FromFileInvalidFile) {
     // Try loading an invalid file (non-existent)
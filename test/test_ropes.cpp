@@ -0,0 +1,138 @@
+#include <gtest/gtest.h>
+#include "rope.h"
+#include "geometry.h"
+#include "jobs.h"
+#include <glm/glm.hpp>
+#include <cmath>
+#include <vector>
+
+namespace {
+
+// A room with a solid bottom row
+RoomGeometry floorRoom() {
+    std::vector<int> tiles(400, 0);
+    for (int x = 0; x < 20; ++x) tiles[380 + x] = 1;
+    return RoomGeometry(20, 20, tiles);
+}
+
+}
+
+// Test for a rope hanging from a pinned end keeping its segment lengths
+TEST(RopeSystemTest, Hangs) {
+    RopeSystem ropes;
+    const size_t rope = ropes.add(glm::vec2(100, 300), glm::vec2(200, 300), 10, 2.0f);
+    ropes.pin(rope, 0);
+    ropes.setIterations(20);
+
+    for (int i = 0; i < 600; ++i) ropes.step();
+
+    EXPECT_EQ(ropes.getPoint(rope, 0), glm::vec2(100, 300));
+
+    // Straight down under the pin
+    const glm::vec2 end = ropes.getPoint(rope, 10);
+    EXPECT_NEAR(end.x, 100.0f, 1.0f);
+    EXPECT_NEAR(end.y, 200.0f, 1.0f);
+
+    // Relaxation leaves a little stretch under gravity
+    for (uint32_t k = 0; k < 10; ++k) {
+        EXPECT_NEAR(glm::length(ropes.getPoint(rope, k + 1) - ropes.getPoint(rope, k)), 10.0f, 0.5f);
+    }
+}
+
+// Test for a falling rope coming to rest on the floor instead of sinking into it
+TEST(RopeSystemTest, LiesOnFloor) {
+    RoomGeometry room = floorRoom();
+    RopeSystem ropes;
+    ropes.setRoom(room);
+    const size_t rope = ropes.add(glm::vec2(60, 200), glm::vec2(300, 200), 24, 3.0f);
+
+    for (int i = 0; i < 400; ++i) ropes.step();
+
+    for (uint32_t k = 0; k < ropes.getPointCount(rope); ++k) {
+        EXPECT_NEAR(ropes.getPoint(rope, k).y, 23.0f, 0.5f);
+    }
+}
+
+// Test for points dropped inside a tile leaving it through the free side
+TEST(RopeSystemTest, PushedOutOfTiles) {
+    RoomGeometry room = floorRoom();
+    RopeSystem ropes;
+    ropes.setRoom(room);
+    ropes.setGravity(glm::vec2(0));
+    const size_t rope = ropes.add(glm::vec2(45, 5), glm::vec2(55, 5), 1, 1.0f);
+    ropes.step();
+
+    EXPECT_FLOAT_EQ(ropes.getPoint(rope, 0).y, 21.0f);
+    EXPECT_FLOAT_EQ(ropes.getPoint(rope, 1).y, 21.0f);
+}
+
+// Test for setPoint moving a pinned end without flinging the rope
+TEST(RopeSystemTest, SetPoint) {
+    RopeSystem ropes;
+    ropes.setGravity(glm::vec2(0));
+    const size_t rope = ropes.add(glm::vec2(0, 0), glm::vec2(0, -40), 4, 1.0f);
+    ropes.pin(rope, 0);
+    EXPECT_TRUE(ropes.isPinned(rope, 0));
+    EXPECT_FALSE(ropes.isPinned(rope, 1));
+
+    ropes.setPoint(rope, 0, glm::vec2(30, 0));
+    for (int i = 0; i < 10; ++i) ropes.step();
+    EXPECT_EQ(ropes.getPoint(rope, 0), glm::vec2(30, 0));
+    EXPECT_NEAR(glm::length(ropes.getPoint(rope, 1) - ropes.getPoint(rope, 0)), 10.0f, 0.5f);
+
+    EXPECT_THROW(ropes.getPoint(rope, 5), std::out_of_range);
+    EXPECT_THROW(ropes.add(glm::vec2(0), glm::vec2(1), 0, 1.0f), std::invalid_argument);
+}
+
+// Test for the outline, a pair of vertices per point at the rope's radius on either side
+TEST(RopeSystemTest, Outline) {
+    RopeSystem ropes;
+    ropes.add(glm::vec2(0, 0), glm::vec2(30, 0), 3, 2.0f);
+    ropes.add(glm::vec2(0, 0), glm::vec2(0, 10), 1, 1.0f);
+
+    std::vector<glm::vec2> vertices;
+    std::vector<uint32_t> strips;
+    ropes.outline(vertices, strips);
+
+    ASSERT_EQ(strips, (std::vector<uint32_t> { 4, 2 }));
+    ASSERT_EQ(vertices.size(), 12);
+    EXPECT_EQ(vertices[2], glm::vec2(10, 2));
+    EXPECT_EQ(vertices[3], glm::vec2(10, -2));
+    EXPECT_EQ(vertices[8], glm::vec2(-1, 0));
+    EXPECT_EQ(vertices[9], glm::vec2(1, 0));
+}
+
+// Test for ropes on SU_A40 stepping bit identically on any number of threads
+TEST(RopeSystemTest, DeterministicAcrossThreads) {
+    RoomGeometry room = RoomGeometry::fromFile("assets/levels/SU_A40.txt");
+
+    const auto simulate = [&](jobs::JobSystem *system) {
+        RopeSystem ropes;
+        ropes.setRoom(room);
+        if (system) {
+            ropes.setRunner([system](const size_t count, const std::function<void(size_t)> &batch) {
+                system->parallel_for(0, count, 1, [&](const size_t begin, const size_t end) {
+                    for (size_t i = begin; i < end; ++i) batch(i);
+                });
+            });
+        }
+
+        for (int i = 0; i < 100; ++i) {
+            const glm::vec2 from(100.0f + static_cast<float>(i) * 9.0f, 900.0f);
+            const size_t rope = ropes.add(from, from + glm::vec2(200, -100), 40, 2.0f, 1.2f);
+            ropes.pin(rope, 0);
+        }
+
+        for (int i = 0; i < 200; ++i) ropes.step();
+
+        std::vector<glm::vec2> vertices;
+        std::vector<uint32_t> strips;
+        ropes.outline(vertices, strips);
+        return vertices;
+    };
+
+    const std::vector<glm::vec2> serial = simulate(nullptr);
+
+    jobs::JobSystem many(7);
+    EXPECT_TRUE(simulate(&many) == serial);
+}
@@ -0,0 +1,101 @@
+#include <gtest/gtest.h>
+#include "triple.h"
+#include "fixedstep.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+namespace {
+
+struct Pair {
+    uint64_t a = 0;
+    uint64_t b = 0; // Always twice a, a torn read breaks that
+};
+
+}
+
+// Test for the reader getting the newest published value and only once
+TEST(SimulationTest, TripleBufferNewest) {
+    TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.update());
+
+    buffer.back() = 1;
+    buffer.publish();
+    buffer.back() = 2;
+    buffer.publish();
+
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.front(), 2);
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(buffer.front(), 2);
+
+    // The writer's slot is never the one being read
+    buffer.back() = 3;
+    EXPECT_EQ(buffer.front(), 2);
+    buffer.publish();
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.front(), 3);
+}
+
+// Test for values crossing threads whole and in order
+TEST(SimulationTest, TripleBufferThreads) {
+    TripleBuffer<Pair> buffer;
+    constexpr uint64_t Count = 200000;
+
+    std::thread writer([&] {
+        for (uint64_t i = 1; i <= Count; ++i) {
+            buffer.back() = Pair { i, i * 2 };
+            buffer.publish();
+        }
+    });
+
+    uint64_t last = 0;
+    while (last < Count) {
+        if (!buffer.update()) continue;
+
+        const Pair &pair = buffer.front();
+        ASSERT_EQ(pair.b, pair.a * 2);
+        ASSERT_GT(pair.a, last);
+        last = pair.a;
+    }
+
+    writer.join();
+}
+
+// Test for ticks coming due on time and late ones being caught up on
+TEST(SimulationTest, FixedStepDue) {
+    const FixedStep::Clock::time_point start {};
+    FixedStep step(25ms, start);
+
+    EXPECT_EQ(step.due(start - 1ms), 0);
+    EXPECT_EQ(step.due(start), 1);
+    EXPECT_EQ(step.advance(), start);
+    EXPECT_EQ(step.due(start + 24ms), 0);
+
+    // Three ticks late
+    EXPECT_EQ(step.due(start + 75ms), 3);
+    EXPECT_EQ(step.advance(), start + 25ms);
+    EXPECT_EQ(step.advance(), start + 50ms);
+    EXPECT_EQ(step.advance(), start + 75ms);
+    EXPECT_EQ(step.due(start + 80ms), 0);
+    EXPECT_EQ(step.getDropped(), 0u);
+
+    EXPECT_THROW(FixedStep(0ms, start), std::invalid_argument);
+}
+
+// Test for a long stall dropping ticks instead of running all of them
+TEST(SimulationTest, FixedStepSpiral) {
+    const FixedStep::Clock::time_point start {};
+    FixedStep step(25ms, start);
+
+    // A second behind, 41 ticks due
+    EXPECT_EQ(step.due(start + 1000ms), FixedStep::MaxCatchUp);
+    EXPECT_EQ(step.getDropped(), 41u - FixedStep::MaxCatchUp);
+
+    for (int i = 0; i < FixedStep::MaxCatchUp; ++i) step.advance();
+    EXPECT_EQ(step.getNext(), start + 1025ms);
+    EXPECT_EQ(step.due(start + 1000ms), 0);
+}
@@ -0,0 +1,100 @@
+#include <gtest/gtest.h>
+#include "spatial.h"
+#include <glm/glm.hpp>
+#include <algorithm>
+#include <random>
+#include <vector>
+
+namespace {
+
+// Every j within reach of circle i, the answer the hash has to match after the exact test
+std::vector<size_t> bruteForce(const std::vector<glm::vec2> &positions, const std::vector<float> &radii, const size_t i) {
+    std::vector<size_t> result;
+    for (size_t j = 0; j < positions.size(); ++j) {
+        if (glm::length(positions[i] - positions[j]) < radii[i] + radii[j]) result.push_back(j);
+    }
+    return result;
+}
+
+}
+
+// Test for queries finding exactly the overlapping circles found by testing every pair
+TEST(SpatialHashTest, MatchesBruteForce) {
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<float> coordinate(-100.0f, 1500.0f);
+    std::uniform_real_distribution<float> radius(2.0f, 30.0f);
+
+    std::vector<glm::vec2> positions;
+    std::vector<float> radii;
+    for (int i = 0; i < 2000; ++i) {
+        positions.emplace_back(coordinate(random), coordinate(random));
+        radii.push_back(radius(random));
+    }
+
+    SpatialHash hash;
+    EXPECT_TRUE(hash.update(positions, radii));
+
+    for (size_t i = 0; i < positions.size(); ++i) {
+        std::vector<size_t> found;
+        hash.query(positions[i], radii[i], [&](const size_t j) {
+            if (glm::length(positions[i] - positions[j]) < radii[i] + radii[j]) found.push_back(j);
+        });
+
+        std::ranges::sort(found);
+        EXPECT_EQ(found, bruteForce(positions, radii, i));
+    }
+}
+
+// Test for every candidate coming up once per query
+TEST(SpatialHashTest, NoDuplicates) {
+    std::vector<glm::vec2> positions;
+    std::vector<float> radii;
+    for (int i = 0; i < 500; ++i) {
+        positions.emplace_back(static_cast<float>(i % 25) * 7.0f, static_cast<float>(i / 25) * 7.0f);
+        radii.push_back(10.0f);
+    }
+
+    SpatialHash hash;
+    hash.update(positions, radii);
+
+    std::vector<size_t> found;
+    hash.query(glm::vec2(80, 70), 10.0f, [&](const size_t j) { found.push_back(j); });
+
+    std::vector<size_t> unique = found;
+    std::ranges::sort(unique);
+    EXPECT_TRUE(std::ranges::adjacent_find(unique) == unique.end());
+    EXPECT_FALSE(found.empty());
+}
+
+// Test for updates only rebuilding once a circle changes cell
+TEST(SpatialHashTest, RebuildsOnCellChange) {
+    std::vector<glm::vec2> positions = { glm::vec2(5, 5), glm::vec2(45, 45) };
+    const std::vector<float> radii = { 4.0f, 4.0f };
+
+    SpatialHash hash;
+    EXPECT_TRUE(hash.update(positions, radii));
+    EXPECT_EQ(hash.getRebuilds(), 1);
+
+    // Same tiles
+    positions[0] = glm::vec2(15, 12);
+    EXPECT_FALSE(hash.update(positions, radii));
+
+    positions[1] = glm::vec2(65, 45);
+    EXPECT_TRUE(hash.update(positions, radii));
+    EXPECT_EQ(hash.getRebuilds(), 2);
+
+    int found = 0;
+    hash.query(glm::vec2(65, 45), 1.0f, [&](const size_t j) { found += j == 1; });
+    EXPECT_EQ(found, 1);
+}
+
+// Test for an empty hash answering queries
+TEST(SpatialHashTest, Empty) {
+    SpatialHash hash;
+    hash.update({}, {});
+
+    int found = 0;
+    hash.query(glm::vec2(0, 0), 100.0f, [&](size_t) { found++; });
+    EXPECT_EQ(found, 0);
+    EXPECT_EQ(hash.getCount(), 0);
+}